@@ -4,6 +4,7 @@
 #include <atomic>
 #include <cassert>
 #include <coroutine>
+#include <cstdint>
 
 // modify from cppcoro/async_mutex.hpp
 
@@ -126,10 +127,43 @@ class AsyncMutex {
     assert(waitersHead_);
     auto head = waitersHead_;
     waitersHead_ = waitersHead_->next_;
-    head->awaiter_.resume();
+    Resume(head);
   }
 
  private:
+  // a waiter which unlocks while Unlock resumes it would resume the next
+  // one from inside, one stack frame per queued waiter. the outermost
+  // Unlock of the thread resumes them one after another instead, the nested
+  // ones queue theirs through next_, which the waiter list does not use
+  // anymore
+  static void Resume(AsyncMutexLockOperation* op) {
+    struct Queue {
+      AsyncMutexLockOperation* head;
+      AsyncMutexLockOperation* tail;
+    };
+    static thread_local Queue* t_resuming = nullptr;
+    op->next_ = nullptr;
+    if (t_resuming) {
+      if (t_resuming->tail) {
+        t_resuming->tail->next_ = op;
+      } else {
+        t_resuming->head = op;
+      }
+      t_resuming->tail = op;
+      return;
+    }
+    Queue queue{op, op};
+    t_resuming = &queue;
+    while (auto cur = queue.head) {
+      // the operation lives in the frame of the waiter, which may be gone
+      // after it is resumed
+      queue.head = cur->next_;
+      if (!queue.head) queue.tail = nullptr;
+      cur->awaiter_.resume();
+    }
+    t_resuming = nullptr;
+  }
+
   static constexpr std::uintptr_t kNotLocked = 1;
   static constexpr std::uintptr_t kLockedNoWaiters = 0;
 
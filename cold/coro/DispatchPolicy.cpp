@@ -0,0 +1,144 @@
+#include "cold/coro/DispatchPolicy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <utility>
+
+#include "cold/coro/IoService.h"
+
+using namespace Cold;
+
+namespace {
+
+uint64_t Mix(uint64_t x) {
+  // splitmix64 finalizer. std::hash of an integer is the identity
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+class RoundRobin : public Base::DispatchPolicy {
+ public:
+  size_t Select(const std::vector<Base::IoService*>& services,
+                size_t) override {
+    return next_.fetch_add(1, std::memory_order_relaxed) % services.size();
+  }
+
+ private:
+  std::atomic<size_t> next_ = 0;
+};
+
+// the service with the smallest load. the scan starts at a rotating index
+// so ties do not all go to the first service
+template <typename LOAD>
+class LeastLoaded : public Base::DispatchPolicy {
+ public:
+  size_t Select(const std::vector<Base::IoService*>& services,
+                size_t) override {
+    auto n = services.size();
+    auto start = next_.fetch_add(1, std::memory_order_relaxed) % n;
+    auto best = start;
+    auto bestLoad = LOAD()(services[start]->GetLoad());
+    for (size_t i = 1; i < n; ++i) {
+      auto index = (start + i) % n;
+      auto load = LOAD()(services[index]->GetLoad());
+      if (load < bestLoad) {
+        best = index;
+        bestLoad = load;
+      }
+    }
+    return best;
+  }
+
+ private:
+  std::atomic<size_t> next_ = 0;
+};
+
+struct Connections {
+  size_t operator()(const Base::IoServiceLoad& load) const {
+    return load.connections;
+  }
+};
+
+struct QueuedTasks {
+  size_t operator()(const Base::IoServiceLoad& load) const {
+    return load.queuedTasks;
+  }
+};
+
+// two random services, the less loaded one wins. close to least loaded
+// without scanning, and no herd on the service which just became idle
+class PowerOfTwoChoices : public Base::DispatchPolicy {
+ public:
+  size_t Select(const std::vector<Base::IoService*>& services,
+                size_t) override {
+    thread_local std::minstd_rand rng(std::random_device{}());
+    auto n = services.size();
+    if (n == 1) return 0;
+    std::uniform_int_distribution<size_t> dist(0, n - 1);
+    auto first = dist(rng);
+    auto second = dist(rng);
+    if (second == first) second = (first + 1) % n;
+    return Load(*services[second]) < Load(*services[first]) ? second : first;
+  }
+
+ private:
+  static size_t Load(const Base::IoService& service) {
+    auto load = service.GetLoad();
+    return load.connections + load.queuedTasks;
+  }
+};
+
+// a ring of virtual nodes. the same peer goes to the same service
+class ConsistentHash : public Base::DispatchPolicy {
+ public:
+  size_t Select(const std::vector<Base::IoService*>& services,
+                size_t hashCode) override {
+    std::call_once(built_, [&]() { Build(services.size()); });
+    auto hash = Mix(hashCode);
+    auto it = std::lower_bound(
+        ring_.begin(), ring_.end(), hash,
+        [](const std::pair<uint64_t, size_t>& node, uint64_t value) {
+          return node.first < value;
+        });
+    if (it == ring_.end()) it = ring_.begin();
+    return it->second;
+  }
+
+ private:
+  constexpr static size_t kVirtualNodes = 64;
+
+  void Build(size_t numServices) {
+    for (size_t i = 0; i < numServices; ++i) {
+      for (size_t j = 0; j < kVirtualNodes; ++j) {
+        ring_.emplace_back(Mix((static_cast<uint64_t>(i) << 32) | j), i);
+      }
+    }
+    std::sort(ring_.begin(), ring_.end());
+  }
+
+  std::once_flag built_;
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+};
+
+}  // namespace
+
+std::unique_ptr<Base::DispatchPolicy> Base::DispatchPolicy::Create(
+    DispatchPolicyType type) {
+  switch (type) {
+    case DispatchPolicyType::kLeastConnections:
+      return std::make_unique<LeastLoaded<Connections>>();
+    case DispatchPolicyType::kLeastQueuedTasks:
+      return std::make_unique<LeastLoaded<QueuedTasks>>();
+    case DispatchPolicyType::kPowerOfTwoChoices:
+      return std::make_unique<PowerOfTwoChoices>();
+    case DispatchPolicyType::kConsistentHash:
+      return std::make_unique<ConsistentHash>();
+    default:
+      return std::make_unique<RoundRobin>();
+  }
+}
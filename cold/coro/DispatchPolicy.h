@@ -0,0 +1,40 @@
+#ifndef COLD_CORO_DISPATCHPOLICY
+#define COLD_CORO_DISPATCHPOLICY
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Cold::Base {
+
+class IoService;
+
+enum class DispatchPolicyType {
+  kRoundRobin,
+  kLeastConnections,
+  kLeastQueuedTasks,
+  kPowerOfTwoChoices,
+  kConsistentHash
+};
+
+// chooses the IoService of a new connection in IoServicePool. the load
+// based policies read IoService::GetLoad. Select is thread safe
+class DispatchPolicy {
+ public:
+  DispatchPolicy() = default;
+  virtual ~DispatchPolicy() = default;
+
+  DispatchPolicy(const DispatchPolicy&) = delete;
+  DispatchPolicy& operator=(const DispatchPolicy&) = delete;
+
+  static std::unique_ptr<DispatchPolicy> Create(DispatchPolicyType type);
+
+  // index into services, which is not empty and does not change between
+  // calls. hashCode identifies the peer, only kConsistentHash uses it
+  virtual size_t Select(const std::vector<IoService*>& services,
+                        size_t hashCode) = 0;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_DISPATCHPOLICY */
@@ -0,0 +1,281 @@
+#include "cold/coro/EpollWatcher.h"
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <limits>
+
+#include "cold/log/Logger.h"
+#include "cold/time/Time.h"
+
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 35)
+#define COLD_HAVE_EPOLL_PWAIT2
+#endif
+#endif
+
+using namespace Cold;
+
+Base::EpollWatcher::EpollWatcher()
+    : epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeUpFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (epollFd_ < 0) {
+    Base::FATAL("Create epoll fd error. reason: {}", ThisThread::ErrorMsg());
+  }
+  if (wakeUpFd_ < 0) {
+    Base::FATAL("Create event fd error. reason: {}", ThisThread::ErrorMsg());
+  }
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = kWakeUpTag;
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeUpFd_, &ev) < 0) {
+    Base::FATAL("epoll_ctl error. error fd: {}, reason: {}", wakeUpFd_,
+                ThisThread::ErrorMsg());
+  }
+  epollEvents_.resize(16);
+}
+
+Base::EpollWatcher::~EpollWatcher() {
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, wakeUpFd_, nullptr);
+  close(wakeUpFd_);
+  if (timerFd_ >= 0) close(timerFd_);
+  close(epollFd_);
+}
+
+void Base::EpollWatcher::ListenReadEvent(int fd, Handle handle) {
+  auto event = Register(fd);
+  if (!event) {
+    Base::FATAL("epoll_ctl error. error fd: {}, reason: {}", fd,
+                ThisThread::ErrorMsg());
+    return;
+  }
+  assert(event->readHandle == std::noop_coroutine());
+  event->readHandle = handle;
+}
+
+void Base::EpollWatcher::ListenWriteEvent(int fd, Handle handle) {
+  auto event = Register(fd);
+  if (!event) {
+    Base::ERROR("epoll_ctl error. error fd: {}, reason: {}", fd,
+                ThisThread::ErrorMsg());
+    return;
+  }
+  assert(event->writeHandle == std::noop_coroutine());
+  event->writeHandle = handle;
+}
+
+void Base::EpollWatcher::StopListeningReadEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  event->readHandle = std::noop_coroutine();
+}
+
+void Base::EpollWatcher::StopListeningWriteEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  event->writeHandle = std::noop_coroutine();
+}
+
+void Base::EpollWatcher::ListenErrorEvent(int fd, Handle handle) {
+  auto event = Register(fd);
+  if (!event) {
+    Base::ERROR("epoll_ctl error. error fd: {}, reason: {}", fd,
+                ThisThread::ErrorMsg());
+    return;
+  }
+  event->errorQueue = true;
+  if (handle == std::noop_coroutine()) return;
+  assert(event->errorHandle == std::noop_coroutine());
+  event->errorHandle = handle;
+}
+
+void Base::EpollWatcher::StopListeningErrorEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  event->errorHandle = std::noop_coroutine();
+}
+
+bool Base::EpollWatcher::UsesErrorQueue(int fd) {
+  auto event = ioEvents_.Find(fd);
+  return event && event->errorQueue;
+}
+
+void Base::EpollWatcher::StopListeningAll(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  if (!UpdateEvent(EPOLL_CTL_DEL, *event)) {
+    Base::ERROR("epoll_ctl error. error fd: {}, reason: {}", fd,
+                ThisThread::ErrorMsg());
+  }
+  ioEvents_.Remove(fd);
+}
+
+Base::EpollWatcher::IoEvent* Base::EpollWatcher::Register(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (event) return event;
+  event = &ioEvents_.Add(fd);
+  event->fd = fd;
+  if (!UpdateEvent(EPOLL_CTL_ADD, *event)) {
+    ioEvents_.Remove(fd);
+    return nullptr;
+  }
+  return event;
+}
+
+bool Base::EpollWatcher::UpdateEvent(int op, IoEvent& event) {
+  struct epoll_event ev;
+  ev.events = kEvents;
+  ev.data.u64 = MakeData(event.fd, ioEvents_.GetGeneration(event.fd));
+  return epoll_ctl(epollFd_, op, event.fd, &ev) == 0;
+}
+
+void Base::EpollWatcher::WakeUp() {
+  uint64_t value = 666;
+  if (write(wakeUpFd_, &value, sizeof value) != sizeof value) {
+    Base::ERROR("WakeUp Error reason: {}", ThisThread::ErrorMsg());
+  }
+}
+
+int Base::EpollWatcher::Wait(int64_t waitNs) {
+  auto events = epollEvents_.data();
+  auto maxEvents = static_cast<int>(epollEvents_.size());
+  constexpr int64_t kNanoSecondsPerMillisecond = 1000000;
+  if (waitNs <= 0 || waitNs % kNanoSecondsPerMillisecond == 0) {
+    auto waitMs = waitNs < 0 ? -1 : waitNs / kNanoSecondsPerMillisecond;
+    waitMs = std::min<int64_t>(waitMs, std::numeric_limits<int>::max());
+    return epoll_wait(epollFd_, events, maxEvents, static_cast<int>(waitMs));
+  }
+#ifdef COLD_HAVE_EPOLL_PWAIT2
+  if (hasPwait2_) {
+    struct timespec ts;
+    ts.tv_sec = waitNs / Time::kNanoSecondsPerSecond;
+    ts.tv_nsec = waitNs % Time::kNanoSecondsPerSecond;
+    int ret = epoll_pwait2(epollFd_, events, maxEvents, &ts, nullptr);
+    if (ret >= 0 || errno != ENOSYS) return ret;
+    Base::INFO("epoll_pwait2 is not supported. use timerfd");
+    hasPwait2_ = false;
+  }
+#endif
+  ArmTimer(waitNs);
+  return epoll_wait(epollFd_, events, maxEvents, -1);
+}
+
+void Base::EpollWatcher::ArmTimer(int64_t waitNs) {
+  if (timerFd_ < 0) {
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timerFd_ < 0) {
+      Base::FATAL("Create timer fd error. reason: {}", ThisThread::ErrorMsg());
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = kTimerTag;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &ev) < 0) {
+      Base::FATAL("epoll_ctl error. error fd: {}, reason: {}", timerFd_,
+                  ThisThread::ErrorMsg());
+    }
+  }
+  // an expiration left from an earlier wait only causes a spurious wakeup
+  struct itimerspec spec {};
+  spec.it_value.tv_sec = waitNs / Time::kNanoSecondsPerSecond;
+  spec.it_value.tv_nsec = waitNs % Time::kNanoSecondsPerSecond;
+  if (timerfd_settime(timerFd_, 0, &spec, nullptr) < 0) {
+    Base::ERROR("timerfd_settime error reason: {}", ThisThread::ErrorMsg());
+  }
+}
+
+std::string DumpEpollEvent(uint32_t ev) {
+  std::string res;
+  if (ev & EPOLLIN) res += "EPOLLIN ";
+  if (ev & EPOLLOUT) res += "EPOLLOUT ";
+  if (ev & EPOLLHUP) res += "EPOLLHUP ";
+  if (ev & EPOLLPRI) res += "EPOLLPRI ";
+  if (ev & EPOLLERR) res += "EPOLLERR ";
+  if (ev & EPOLLRDHUP) res += "EPOLLRDHUP ";
+  return res;
+}
+
+const std::vector<std::coroutine_handle<>>& Base::EpollWatcher::WatchIo(
+    int64_t waitNs) {
+  activeCoroutines_.clear();
+  const int epoll_result = Wait(waitNs);
+  if (epoll_result < 0) {
+    Base::ERROR("epoll_wait error reson: {}", ThisThread::ErrorMsg());
+  } else {
+    size_t size = static_cast<size_t>(epoll_result);
+    Base::TRACE("WatchIo total active fd: {}", size);
+    for (size_t i = 0; i < size; ++i) {
+      auto& epollEvent = epollEvents_[i];
+      auto events = epollEvent.events;
+      const auto data = epollEvent.data.u64;
+      if (data == kWakeUpTag) {
+        HandleWakeUp();
+        continue;
+      }
+      if (data == kTimerTag) {
+        // drain it. EAGAIN when it was rearmed after it fired
+        uint64_t expirations = 0;
+        if (read(timerFd_, &expirations, sizeof expirations) < 0 &&
+            errno != EAGAIN) {
+          Base::ERROR("Read timer fd error reason: {}", ThisThread::ErrorMsg());
+        }
+        continue;
+      }
+      auto eventPtr = ioEvents_.Find(static_cast<int>(data & 0xffffffff),
+                                     static_cast<uint32_t>(data >> 32));
+      // the fd was removed (and maybe reused) after epoll_wait returned
+      if (!eventPtr) continue;
+      IoEvent& event = *eventPtr;
+      Base::DEBUG("In WaitIo Current solve fd: {} ,in epoll events: {}",
+                  event.fd, DumpEpollEvent(events));
+      const bool readable = (events & (EPOLLIN | EPOLLRDHUP)) != 0;
+      const bool writable = (events & EPOLLOUT) != 0;
+      const bool error = (events & EPOLLERR) != 0;
+      const bool hangup = (events & EPOLLHUP) != 0;
+      // e.g. a zero copy completion. it must not wake a read or write
+      const bool disconnected = hangup || (error && !event.errorQueue);
+      Base::DEBUG(
+          "IoEvent Info fd: {}, readable: {}, writeable: {}, disconnected: {}",
+          event.fd, readable, writable, disconnected);
+      // an edge without a waiter is dropped. a waiter has seen EAGAIN (or
+      // polled) before it suspends, so the next change gives a new edge. a
+      // waiter registered from another thread checks again, see
+      // IoAwaitableBase::ListenIo
+      if ((readable || disconnected) &&
+          (event.readHandle != std::noop_coroutine())) {
+        activeCoroutines_.push_back(event.readHandle);
+        event.readHandle = std::noop_coroutine();
+      }
+      if ((writable || disconnected) &&
+          (event.writeHandle != std::noop_coroutine())) {
+        activeCoroutines_.push_back(event.writeHandle);
+        event.writeHandle = std::noop_coroutine();
+      }
+      if ((error || hangup) && (event.errorHandle != std::noop_coroutine())) {
+        activeCoroutines_.push_back(event.errorHandle);
+        event.errorHandle = std::noop_coroutine();
+      }
+    }
+    if (epollEvents_.size() == size) epollEvents_.resize(size << 1);
+  }
+  return activeCoroutines_;
+}
+
+void Base::EpollWatcher::HandleWakeUp() {
+  uint64_t value = 0;
+  Base::TRACE("HandleWakeUp");
+  if (read(wakeUpFd_, &value, sizeof value) != sizeof value) {
+    Base::ERROR("HandleWakeUp Error Reason:{}", ThisThread::ErrorMsg());
+  }
+}
+
+std::string Base::EpollWatcher::IoEvent::Dump() {
+  return fmt::format("IoEvent(fd: {}, Read: {}, Write: {}, Error: {})", fd,
+                     readHandle != std::noop_coroutine(),
+                     writeHandle != std::noop_coroutine(),
+                     errorHandle != std::noop_coroutine());
+}
\ No newline at end of file
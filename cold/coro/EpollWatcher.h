@@ -0,0 +1,82 @@
+#ifndef COLD_CORO_EPOLLWATCHER
+#define COLD_CORO_EPOLLWATCHER
+
+#include <sys/epoll.h>
+
+#include <string>
+
+#include "cold/coro/IoEventTable.h"
+#include "cold/coro/IoWatcher.h"
+
+namespace Cold::Base {
+
+class EpollWatcher : public IoWatcher {
+ public:
+  EpollWatcher();
+  ~EpollWatcher() override;
+
+  IoBackend GetBackend() const override { return IoBackend::kEpoll; }
+
+  void ListenReadEvent(int fd, Handle handle) override;
+  void ListenWriteEvent(int fd, Handle handle) override;
+  void StopListeningReadEvent(int fd) override;
+  void StopListeningWriteEvent(int fd) override;
+  void StopListeningAll(int fd) override;
+
+  void ListenErrorEvent(int fd, Handle handle) override;
+  void StopListeningErrorEvent(int fd) override;
+  bool UsesErrorQueue(int fd) override;
+
+ private:
+  struct IoEvent {
+    int fd = 0;
+    Handle readHandle = std::noop_coroutine();
+    Handle writeHandle = std::noop_coroutine();
+    Handle errorHandle = std::noop_coroutine();
+    // EPOLLERR is an entry in the error queue, not a broken connection
+    bool errorQueue = false;
+    std::string Dump();
+  };
+
+  // epoll data: | gen 32 bits | fd 32 bits |
+  static uint64_t MakeData(int fd, uint32_t gen) {
+    return (static_cast<uint64_t>(gen) << 32) | static_cast<uint32_t>(fd);
+  }
+
+  // every fd is added once with all the events. edge triggered, so arming
+  // and disarming a waiter only touches the IoEvent
+  constexpr static uint32_t kEvents = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+  constexpr static uint64_t kWakeUpTag = ~0ull;
+  constexpr static uint64_t kTimerTag = ~0ull - 1;
+
+  const std::vector<Handle>& WatchIo(int64_t waitNs) override;
+
+  // epoll_wait with a nanosecond timeout. use epoll_pwait2, or a timerfd
+  // when the kernel does not have it
+  int Wait(int64_t waitNs);
+
+  void ArmTimer(int64_t waitNs);
+
+  // find the IoEvent of fd, add the fd to epoll on first use
+  IoEvent* Register(int fd);
+
+  bool UpdateEvent(int op, IoEvent& event);
+
+  void WakeUp() override;
+
+  void HandleWakeUp();
+
+  int epollFd_;
+  int wakeUpFd_;
+  // created when epoll_pwait2 is not supported
+  int timerFd_ = -1;
+  bool hasPwait2_ = true;
+  std::vector<struct epoll_event> epollEvents_;
+  IoEventTable<IoEvent> ioEvents_;
+  std::vector<Handle> activeCoroutines_;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_EPOLLWATCHER */
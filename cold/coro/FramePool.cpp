@@ -0,0 +1,106 @@
+#include "cold/coro/FramePool.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace Cold;
+
+namespace {
+
+// placed before every frame. 16 bytes keep the frame aligned as operator new
+struct alignas(16) FrameHeader {
+  const void* owner;
+  uint32_t sizeClass;
+};
+
+struct FreeFrame {
+  FreeFrame* next;
+};
+
+constexpr size_t kNumClasses =
+    Base::FramePool::kMaxFrameSize / Base::FramePool::kClassGranularity;
+constexpr uint32_t kOversized = ~0u;
+
+struct ThreadCache {
+  ThreadCache() = default;
+  ~ThreadCache();
+
+  FreeFrame* freeLists[kNumClasses] = {};
+  size_t counts[kNumClasses] = {};
+  Base::FramePool::Stats stats;
+};
+
+// trivially destructible, so frames freed during thread exit after the
+// cache is gone can still be recognized
+thread_local bool t_cacheDestroyed = false;
+thread_local ThreadCache t_cache;
+
+ThreadCache::~ThreadCache() {
+  for (auto& list : freeLists) {
+    while (list) {
+      auto next = list->next;
+      std::free(reinterpret_cast<FrameHeader*>(list) - 1);
+      list = next;
+    }
+  }
+  t_cacheDestroyed = true;
+}
+
+}  // namespace
+
+void* Base::FramePool::Allocate(size_t size) {
+  const size_t total = size + sizeof(FrameHeader);
+  FrameHeader* header = nullptr;
+  if (total > kMaxFrameSize || t_cacheDestroyed) {
+    header = static_cast<FrameHeader*>(std::malloc(total));
+    if (!header) throw std::bad_alloc();
+    header->owner = nullptr;
+    header->sizeClass = kOversized;
+    if (!t_cacheDestroyed) ++t_cache.stats.oversized;
+    return header + 1;
+  }
+  auto& cache = t_cache;
+  const auto sizeClass =
+      static_cast<uint32_t>((total - 1) / kClassGranularity);
+  if (auto frame = cache.freeLists[sizeClass]) {
+    cache.freeLists[sizeClass] = frame->next;
+    --cache.counts[sizeClass];
+    ++cache.stats.recycled;
+    return frame;
+  }
+  header = static_cast<FrameHeader*>(
+      std::malloc((sizeClass + 1) * kClassGranularity));
+  if (!header) throw std::bad_alloc();
+  header->owner = &cache;
+  header->sizeClass = sizeClass;
+  ++cache.stats.allocated;
+  return header + 1;
+}
+
+void Base::FramePool::Deallocate(void* ptr) noexcept {
+  if (!ptr) return;
+  auto header = static_cast<FrameHeader*>(ptr) - 1;
+  if (header->sizeClass == kOversized) {
+    std::free(header);
+    return;
+  }
+  if (t_cacheDestroyed || header->owner != &t_cache) {
+    if (!t_cacheDestroyed) ++t_cache.stats.foreignFreed;
+    std::free(header);
+    return;
+  }
+  auto& cache = t_cache;
+  const auto sizeClass = header->sizeClass;
+  if (cache.counts[sizeClass] >= kMaxCachedPerClass) {
+    std::free(header);
+    return;
+  }
+  auto frame = static_cast<FreeFrame*>(ptr);
+  frame->next = cache.freeLists[sizeClass];
+  cache.freeLists[sizeClass] = frame;
+  ++cache.counts[sizeClass];
+}
+
+const Base::FramePool::Stats& Base::FramePool::ThisThreadStats() {
+  return t_cache.stats;
+}
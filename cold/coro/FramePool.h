@@ -0,0 +1,41 @@
+#ifndef COLD_CORO_FRAMEPOOL
+#define COLD_CORO_FRAMEPOOL
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Cold::Base {
+
+// allocator of coroutine frames. every thread caches freed frames in size
+// class free lists. a frame freed by a thread other than the one which
+// allocated it goes back to the global heap, so producer/consumer patterns
+// don't move memory between the caches. frames larger than the biggest
+// class always use the global heap.
+class FramePool {
+ public:
+  struct Stats {
+    // frames taken from the global heap
+    uint64_t allocated = 0;
+    // frames served from the free lists
+    uint64_t recycled = 0;
+    // frames freed by another thread, returned to the global heap
+    uint64_t foreignFreed = 0;
+    // frames bigger than kMaxFrameSize
+    uint64_t oversized = 0;
+  };
+
+  constexpr static size_t kClassGranularity = 64;
+  constexpr static size_t kMaxFrameSize = 2048;
+  // max frames cached per size class and thread
+  constexpr static size_t kMaxCachedPerClass = 256;
+
+  static void* Allocate(size_t size);
+  static void Deallocate(void* ptr) noexcept;
+
+  // stats of the calling thread
+  static const Stats& ThisThreadStats();
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_FRAMEPOOL */
@@ -2,10 +2,12 @@
 #define COLD_CORO_IO
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
 #include <chrono>
 #include <cstdio>
+#include <utility>
 
 #include "cold/coro/IoService.h"
 #include "cold/log/Logger.h"
@@ -18,39 +20,83 @@ class IoAwaitableBase {
   friend class IoTimeoutAwaitable;
 
  public:
-  enum IoType { kREAD, kWRITE };
+  // kERROR waits for an entry in the error queue, see
+  // IoWatcher::ListenErrorEvent
+  enum IoType { kREAD, kWRITE, kERROR };
   IoAwaitableBase(Base::IoService* service, int fd, IoType type)
       : service_(service), fd_(fd), type_(type) {}
 
   virtual ~IoAwaitableBase() = default;
 
   void await_suspend(std::coroutine_handle<> handle) noexcept {
-    ListenIo(handle);
+    if (service_->InLoopThread()) {
+      ListenIo(handle);
+      return;
+    }
+    // e.g. a stolen task touching a socket of another IoService. register
+    // in the owner loop so the resumption stays affine to its watcher
+    deferred_ = true;
+    service_->CoSpawn(
+        [](IoAwaitableBase* self, std::coroutine_handle<> coro) -> Task<> {
+          self->ListenIo(coro);
+          co_return;
+        }(this, handle));
   }
 
  protected:
   void ListenIo(const std::coroutine_handle<>& handle) {
+    const bool deferred = std::exchange(deferred_, false);
+    if (op_.opcode != IoOperation::kNone &&
+        service_->SubmitOperation(fd_, handle, op_)) {
+      return;
+    }
+    // the EAGAIN was seen in another thread. an edge which came before the
+    // registration found no waiter and was dropped, so check the state
+    // before waiting for the next edge
+    if (deferred && ReadyNow()) {
+      IoWaker::Wake(handle);
+      return;
+    }
     if (type_ == kREAD) {
       service_->ListenReadEvent(fd_, handle);
-    } else {
+    } else if (type_ == kWRITE) {
       service_->ListenWriteEvent(fd_, handle);
+    } else {
+      service_->ListenErrorEvent(fd_, handle);
     }
   }
 
   void StopListeningIo() {
     if (type_ == kREAD) {
       service_->StopListeningReadEvent(fd_);
-    } else {
+    } else if (type_ == kWRITE) {
       service_->StopListeningWriteEvent(fd_);
+    } else {
+      service_->StopListeningErrorEvent(fd_);
     }
   }
 
   void SetIoType(IoType type) { type_ = type; }
 
-  bool GetTimeout() const { return timeout_; }
+  // an operation which completed while its timeout canceled it is not
+  // timed out, the result must not be lost
+  bool GetTimeout() const { return timeout_ && !op_.completed; }
+
+  // the result of op_, like the return value of its syscall
+  ssize_t GetOperationResult() const {
+    if (op_.result < 0) {
+      errno = -op_.result;
+      return -1;
+    }
+    return op_.result;
+  }
 
   Base::IoService* service_;
   int fd_;
+  // done by the backend instead of waiting for readiness if it can, see
+  // IoWatcher::SubmitOperation. set it up in await_ready, IoTimeoutAwaitable
+  // moves the awaitable before
+  IoOperation op_;
 
  private:
   void SetTimeout() {
@@ -58,57 +104,91 @@ class IoAwaitableBase {
     StopListeningIo();
   }
 
+  bool ReadyNow() const {
+    struct pollfd pfd {};
+    pfd.fd = fd_;
+    if (type_ == kREAD) {
+      pfd.events = POLLIN | POLLRDHUP;
+    } else if (type_ == kWRITE) {
+      pfd.events = POLLOUT;
+    }
+    if (poll(&pfd, 1, 0) <= 0) return false;
+    // a queued error only readies the error waiter
+    return type_ == kERROR || pfd.revents != POLLERR ||
+           !service_->UsesErrorQueue(fd_);
+  }
+
   IoType type_;
   bool timeout_ = false;
+  // registered by the owner loop on behalf of another thread
+  bool deferred_ = false;
 };
 
+// the awaitable suspends the caller directly, the deadline is an intrusive
+// node of the IoService. no coroutine or timer is created
 template <typename AWAITABLE, typename REP, typename PERIOD>
-class IoTimeoutAwaitable {
+class IoTimeoutAwaitable : public IoDeadline {
  public:
   using Duration = std::chrono::duration<REP, PERIOD>;
-  using RetType =
-      std::invoke_result_t<decltype(&AWAITABLE::await_resume), AWAITABLE>;
 
   IoTimeoutAwaitable(Base::IoService* service, AWAITABLE&& awaitable,
                      Duration timeoutTime)
       : service_(service),
         awaitable_(std::move(awaitable)),
-        timeoutTime_(timeoutTime),
-        timer_(*service) {}
-  ~IoTimeoutAwaitable() = default;
+        timeoutTime_(timeoutTime) {}
+  // the waiting coroutine is destroyed
+  ~IoTimeoutAwaitable() override {
+    if (IsQueued()) service_->CancelDeadline(*this);
+  }
 
-  bool await_ready() noexcept { return false; }
+  bool await_ready() noexcept { return awaitable_.await_ready(); }
 
   void await_suspend(std::coroutine_handle<> handle) noexcept {
-    auto task = [](std::coroutine_handle<> coro, RetType& retValue,
-                   AWAITABLE& awaitable) -> Base::Task<> {
-      retValue = co_await awaitable;
-      coro.resume();
-    }(handle, retValue_, awaitable_);
-    timer_.ExpiresAfter(timeoutTime_);
-    timer_.AsyncWait(
-        [](std::coroutine_handle<> coro, AWAITABLE& awaitable) -> Base::Task<> {
-          awaitable.SetTimeout();
-          coro.resume();
-          co_return;
-        }(task.GetHandle(), awaitable_));
-    service_->CoSpawn(std::move(task));
+    handle_ = handle;
+    if (service_->InLoopThread()) {
+      Suspend();
+      return;
+    }
+    // deadlines belong to the owner loop, like the io registration
+    awaitable_.deferred_ = true;
+    service_->CoSpawn([](IoTimeoutAwaitable* self) -> Task<> {
+      self->Suspend();
+      co_return;
+    }(this));
   }
 
-  RetType await_resume() noexcept {
-    if (!awaitable_.GetTimeout()) timer_.Cancel();
-    return retValue_;
+  auto await_resume() noexcept {
+    if (IsQueued()) service_->CancelDeadline(*this);
+    return awaitable_.await_resume();
   }
 
  private:
+  void Suspend() {
+    service_->AddDeadline(*this, service_->Now() + timeoutTime_);
+    awaitable_.await_suspend(handle_);
+  }
+
+  void OnTimeout() override {
+    awaitable_.SetTimeout();
+    handle_.resume();
+  }
+
   Base::IoService* service_;
   AWAITABLE awaitable_;
   Duration timeoutTime_;
-  Base::Timer timer_;
-  RetType retValue_;
+  std::coroutine_handle<> handle_;
 };
 
 namespace detail {
+// the fd may be blocking and epoll reports edges only, so check the state
+// before waiting for the next edge
+inline bool PollReady(int fd, short events) {
+  struct pollfd pfd {};
+  pfd.fd = fd;
+  pfd.events = events;
+  return poll(&pfd, 1, 0) != 0;
+}
+
 class AsyncRead : public IoAwaitableBase {
  public:
   AsyncRead(IoService& service, int fd, void* ptr, size_t readSize)
@@ -117,7 +197,7 @@ class AsyncRead : public IoAwaitableBase {
         readSize_(readSize) {}
   ~AsyncRead() override = default;
 
-  bool await_ready() noexcept { return false; }
+  bool await_ready() noexcept { return PollReady(fd_, POLLIN); }
 
   ssize_t await_resume() noexcept {
     if (GetTimeout()) {
@@ -141,7 +221,7 @@ class AsyncWrite : public IoAwaitableBase {
 
   ~AsyncWrite() override = default;
 
-  bool await_ready() noexcept { return false; }
+  bool await_ready() noexcept { return PollReady(fd_, POLLOUT); }
 
   ssize_t await_resume() noexcept {
     if (GetTimeout()) {
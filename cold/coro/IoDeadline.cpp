@@ -0,0 +1,66 @@
+#include "cold/coro/IoDeadline.h"
+
+#include <cassert>
+#include <chrono>
+
+using namespace Cold;
+
+void Base::IoDeadlineQueue::Push(IoDeadline& deadline, MonoTime expiry) {
+  assert(!deadline.IsQueued());
+  deadline.expiry_ = expiry;
+  heap_.push_back(&deadline);
+  deadline.index_ = heap_.size() - 1;
+  FixUp(deadline.index_);
+}
+
+void Base::IoDeadlineQueue::Remove(IoDeadline& deadline) {
+  if (!deadline.IsQueued()) return;
+  auto index = deadline.index_;
+  assert(heap_[index] == &deadline);
+  deadline.index_ = IoDeadline::kNotQueued;
+  auto last = heap_.back();
+  heap_.pop_back();
+  if (index == heap_.size()) return;
+  Place(index, last);
+  FixDown(index);
+  FixUp(last->index_);
+}
+
+int64_t Base::IoDeadlineQueue::HandleTimeout(MonoTime now) {
+  // pop one at a time. OnTimeout resumes a coroutine which may add, remove
+  // or destroy other deadlines
+  while (!heap_.empty() && heap_.front()->expiry_ <= now) {
+    auto deadline = heap_.front();
+    Remove(*deadline);
+    deadline->OnTimeout();
+  }
+  if (heap_.empty()) return -1;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             heap_.front()->expiry_ - now)
+      .count();
+}
+
+void Base::IoDeadlineQueue::FixUp(size_t index) {
+  auto deadline = heap_[index];
+  while (index > 0) {
+    auto parent = (index - 1) / 2;
+    if (!(deadline->expiry_ < heap_[parent]->expiry_)) break;
+    Place(index, heap_[parent]);
+    index = parent;
+  }
+  Place(index, deadline);
+}
+
+void Base::IoDeadlineQueue::FixDown(size_t index) {
+  auto deadline = heap_[index];
+  auto size = heap_.size();
+  for (auto son = index * 2 + 1; son < size; son = index * 2 + 1) {
+    if (son + 1 < size && heap_[son + 1]->expiry_ < heap_[son]->expiry_) {
+      ++son;
+    }
+    if (!(heap_[son]->expiry_ < deadline->expiry_)) break;
+    Place(index, heap_[son]);
+    index = son;
+  }
+  Place(index, deadline);
+}
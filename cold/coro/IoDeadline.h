@@ -0,0 +1,72 @@
+#ifndef COLD_CORO_IODEADLINE
+#define COLD_CORO_IODEADLINE
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cold/time/MonoTime.h"
+
+namespace Cold::Base {
+
+// the deadline of a suspended io. it lives in the awaitable, so arming it
+// costs no allocation. IoService calls OnTimeout when it expires before
+// the io completes
+class IoDeadline {
+  friend class IoDeadlineQueue;
+
+ public:
+  IoDeadline() = default;
+  virtual ~IoDeadline() = default;
+
+  IoDeadline(const IoDeadline&) = delete;
+  IoDeadline& operator=(const IoDeadline&) = delete;
+
+  MonoTime GetExpiry() const { return expiry_; }
+
+  bool IsQueued() const { return index_ != kNotQueued; }
+
+ protected:
+  // cancel the io and resume the waiting coroutine
+  virtual void OnTimeout() = 0;
+
+ private:
+  constexpr static size_t kNotQueued = ~0ull;
+
+  MonoTime expiry_;
+  size_t index_ = kNotQueued;
+};
+
+// intrusive binary min heap of deadlines. loop thread only
+class IoDeadlineQueue {
+ public:
+  IoDeadlineQueue() = default;
+  ~IoDeadlineQueue() = default;
+
+  IoDeadlineQueue(const IoDeadlineQueue&) = delete;
+  IoDeadlineQueue& operator=(const IoDeadlineQueue&) = delete;
+
+  void Push(IoDeadline& deadline, MonoTime expiry);
+  void Remove(IoDeadline& deadline);
+
+  // call OnTimeout of the deadlines expired at now. return nanoseconds until
+  // the next deadline, -1 if there is none
+  int64_t HandleTimeout(MonoTime now);
+
+  size_t Size() const { return heap_.size(); }
+
+ private:
+  void Place(size_t index, IoDeadline* deadline) {
+    heap_[index] = deadline;
+    deadline->index_ = index;
+  }
+
+  void FixUp(size_t index);
+  void FixDown(size_t index);
+
+  std::vector<IoDeadline*> heap_;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_IODEADLINE */
@@ -0,0 +1,90 @@
+#ifndef COLD_CORO_IOEVENTTABLE
+#define COLD_CORO_IOEVENTTABLE
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cold::Base {
+
+// per fd state of an IoWatcher. fds are small dense integers, so the
+// table is a vector indexed by fd. every Add bumps the generation of the
+// slot, events reported by the kernel carry the generation so an event of
+// a closed (and maybe reused) fd can be dropped.
+template <typename T>
+class IoEventTable {
+ public:
+  IoEventTable() = default;
+  ~IoEventTable() = default;
+
+  IoEventTable(const IoEventTable&) = delete;
+  IoEventTable& operator=(const IoEventTable&) = delete;
+
+  // fd must not be in use
+  T& Add(int fd) {
+    assert(fd >= 0);
+    auto index = static_cast<size_t>(fd);
+    if (index >= slots_.size()) {
+      auto newSize = slots_.empty() ? kInitSize : slots_.size();
+      while (newSize <= index) newSize <<= 1;
+      slots_.resize(newSize);
+    }
+    auto& slot = slots_[index];
+    assert(!slot.used);
+    slot.used = true;
+    ++slot.gen;
+    slot.event = T();
+    ++size_;
+    return slot.event;
+  }
+
+  T& FindOrAdd(int fd) {
+    auto event = Find(fd);
+    return event ? *event : Add(fd);
+  }
+
+  void Remove(int fd) {
+    auto& slot = slots_[static_cast<size_t>(fd)];
+    assert(slot.used);
+    slot.used = false;
+    --size_;
+  }
+
+  T* Find(int fd) {
+    auto index = static_cast<size_t>(fd);
+    if (fd < 0 || index >= slots_.size() || !slots_[index].used) {
+      return nullptr;
+    }
+    return &slots_[index].event;
+  }
+
+  // nullptr for an event of an old generation
+  T* Find(int fd, uint32_t gen) {
+    auto event = Find(fd);
+    if (!event || slots_[static_cast<size_t>(fd)].gen != gen) return nullptr;
+    return event;
+  }
+
+  uint32_t GetGeneration(int fd) const {
+    return slots_[static_cast<size_t>(fd)].gen;
+  }
+
+  size_t Size() const { return size_; }
+
+ private:
+  constexpr static size_t kInitSize = 1024;
+
+  struct Slot {
+    T event;
+    uint32_t gen = 0;
+    bool used = false;
+  };
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_IOEVENTTABLE */
@@ -1,67 +1,154 @@
 #include "cold/coro/IoService.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <memory>
 
 #include "cold/coro/IoWatcher.h"
+#include "cold/coro/WorkStealingScheduler.h"
 #include "cold/log/Logger.h"
 #include "cold/thread/Lock.h"
-#include "cold/time/TimerQueue.h"
+#include "cold/util/Config.h"
 
 using namespace Cold;
 
-Base::IoService::IoService()
-    : ioWatcher_(std::make_unique<IoWatcher>()),
-      timerQueue_(std::make_unique<TimerQueue>()) {}
+namespace {
+thread_local Base::IoService* t_currentService = nullptr;
 
-Base::IoService::~IoService() { assert(!running_); }
+auto HandleOf(Base::Internal::DetachedPromise* node) {
+  return std::coroutine_handle<Base::Internal::DetachedPromise>::from_promise(
+      *node);
+}
+}  // namespace
+
+Base::IoServiceOptions Base::IoServiceOptions::FromConfig() {
+  IoServiceOptions options;
+  auto& config = Config::GetGloablDefaultConfig();
+  if (config.Contains("/coro/io-backend")) {
+    auto backend = config.GetConfig("/coro/io-backend").get<std::string>();
+    if (backend == "io_uring") {
+      options.backend = IoBackend::kIoUring;
+    } else if (backend != "epoll") {
+      Base::WARN("Unknown io backend: {}. use epoll", backend);
+    }
+  }
+  if (config.Contains("/coro/timer-queue")) {
+    auto timerQueue =
+        config.GetConfig("/coro/timer-queue").get<std::string>();
+    if (timerQueue == "timing-wheel") {
+      options.timerQueue = TimerQueueType::kTimingWheel;
+    } else if (timerQueue != "heap") {
+      Base::WARN("Unknown timer queue: {}. use heap", timerQueue);
+    }
+  }
+  if (config.Contains("/coro/coarse-clock")) {
+    options.coarseClock = config.GetConfig("/coro/coarse-clock").get<bool>();
+  }
+  if (config.Contains("/coro/busy-poll-us")) {
+    options.busyPollMicroSeconds =
+        config.GetConfig("/coro/busy-poll-us").get<int64_t>();
+  }
+  return options;
+}
+
+Base::IoService::IoService() : IoService(IoServiceOptions::FromConfig()) {}
+
+Base::IoService::IoService(const IoServiceOptions& options)
+    : ioWatcher_(IoWatcher::Create(options.backend)),
+      clock_(options.coarseClock),
+      timerQueue_(TimerQueue::Create(options.timerQueue)),
+      maxSpinNs_(std::max<int64_t>(options.busyPollMicroSeconds, 0) * 1000),
+      spinNs_(maxSpinNs_) {}
+
+Base::IoService::~IoService() {
+  assert(!running_);
+  std::vector<TaskNode*> tasks;
+  TakePendingTasks(tasks);
+  // a producer may be in the middle of Push
+  while (!pendingTasks_.Empty()) {
+    if (auto node = pendingTasks_.Pop()) {
+      tasks.push_back(static_cast<TaskNode*>(node));
+    }
+  }
+  for (auto node : tasks) DestroyTask(node);
+  // coroutines still waiting for io or timers
+  while (liveTasks_) DestroyTask(liveTasks_);
+}
+
+bool Base::IoService::InLoopThread() const { return t_currentService == this; }
 
 void Base::IoService::Start() {
   assert(!running_);
   running_ = true;
+  auto prevService = std::exchange(t_currentService, this);
+  auto prevClock = LoopClock::SetThreadClock(&clock_);
+  clock_.Update();
+  std::vector<TaskNode*> tasks;
+  std::vector<Task<>> timerTasks;
   while (running_) {
-    std::vector<Task<>> tasks;
     // for pendingTasks
-    {
-      LockGuard guard(mutexForPendingTasks_);
-      tasks.swap(pendingTasks_);
-    }
-    for (auto& task : tasks) {
-      auto handle = task.GetHandle();
-      awaitCompletionTasks_.insert({handle, std::move(task)});
-      handle.resume();
+    TakePendingTasks(tasks);
+    for (auto node : tasks) {
+      // finished in another thread
+      if (HandleOf(node).done()) {
+        DestroyTask(node);
+      } else {
+        numQueuedTasks_.fetch_sub(1, std::memory_order_relaxed);
+        RunTask(node);
+      }
     }
+    bool ran = !tasks.empty();
     tasks.clear();
-    // for timer event
-    int waitTime = 0;
+    // for tasks of the pool scheduler
+    bool scheduled = RunScheduledTasks();
+    // for timer event. the tasks above may have taken a while, the timers
+    // need the exact time
+    if (ran || scheduled) clock_.Update();
+    // for io deadlines. before timers, the timed out coroutines may add
+    // timers
+    auto deadlineWait = deadlines_.HandleTimeout(clock_.GetMonoTime());
+    int64_t waitTime = 0;
     {
       LockGuard guard(mutexForTimerQueue_);
-      waitTime = timerQueue_->HandleTimeout(tasks);
+      waitTime = timerQueue_->HandleTimeout(clock_.GetMonoTime(), timerTasks);
     }
-    for (auto& task : tasks) {
-      auto newTask = WrapTask(std::move(task));
-      auto handle = newTask.GetHandle();
-      awaitCompletionTasks_.insert({handle, std::move(newTask)});
-      handle.resume();
+    if (deadlineWait >= 0 && (waitTime < 0 || deadlineWait < waitTime)) {
+      waitTime = deadlineWait;
     }
-    // for io event
-    const auto& activeCoros = ioWatcher_->WatchIo(waitTime);
-    for (const auto& coro : activeCoros) {
-      assert(!coro.done());
-      coro.resume();
+    // they may add earlier timers
+    if (!timerTasks.empty()) waitTime = 0;
+    for (auto& task : timerTasks) {
+      RunTask(&WrapTask(std::move(task)).Release().promise());
     }
-    // clear the completion
-    std::vector<Handle> completions;
-    {
-      LockGuard guard(mutexForCompletionTasks_);
-      completions.swap(completionTasks_);
+    timerTasks.clear();
+    // for io event
+    const bool runnable = scheduled || !localTasks_.empty();
+    const std::vector<Handle>* activeCoros = nullptr;
+    if (maxSpinNs_ > 0 && waitTime != 0 && !runnable) {
+      activeCoros = BusyPoll(waitTime);
     }
-    for (const auto& completion : completions) {
-      assert(completion.done());
-      awaitCompletionTasks_.erase(completion);
+    if (!activeCoros) {
+      polling_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (runnable || !pendingTasks_.Empty() ||
+          (scheduler_ && scheduler_->HasTask(schedulerIndex_)) ||
+          timersChanged_.exchange(false, std::memory_order_relaxed)) {
+        waitTime = 0;
+      }
+      if (waitTime != 0) {
+        blockingWaits_.fetch_add(1, std::memory_order_relaxed);
+      }
+      activeCoros = &ioWatcher_->WatchIo(waitTime);
+      polling_.store(false, std::memory_order_relaxed);
+      notified_.store(false, std::memory_order_relaxed);
     }
-    Base::TRACE("awaitCompletionTasks size: {}", awaitCompletionTasks_.size());
+    clock_.Update();
+    for (const auto& coro : *activeCoros) IoWaker::Wake(coro);
+    Base::TRACE("live tasks size: {}", numLiveTasks_);
   }
+  LoopClock::SetThreadClock(prevClock);
+  t_currentService = prevService;
 }
 
 void Base::IoService::Stop() {
@@ -69,20 +156,149 @@ void Base::IoService::Stop() {
   ioWatcher_->WakeUp();
 }
 
-void Base::IoService::AddTask(Task<> task) {
-  LockGuard guard(mutexForPendingTasks_);
-  pendingTasks_.push_back(std::move(task));
-  ioWatcher_->WakeUp();
+void Base::IoService::AddTask(Internal::DetachedTask task) {
+  auto node = &task.Release().promise();
+  numQueuedTasks_.fetch_add(1, std::memory_order_relaxed);
+  if (InLoopThread()) {
+    localTasks_.push_back(node);
+    return;
+  }
+  pendingTasks_.Push(node);
+  Notify();
+}
+
+void Base::IoService::RunTask(TaskNode* node) {
+  assert(!node->linked_);
+  node->linked_ = true;
+  node->prev_ = nullptr;
+  node->next_ = liveTasks_;
+  if (liveTasks_) liveTasks_->prev_ = node;
+  liveTasks_ = node;
+  ++numLiveTasks_;
+  HandleOf(node).resume();
+}
+
+void Base::IoService::OnTaskDone(TaskNode* node) {
+  if (InLoopThread()) {
+    DestroyTask(node);
+    return;
+  }
+  // the live list belongs to the loop thread
+  pendingTasks_.Push(node);
+  Notify();
+}
+
+void Base::IoService::DestroyTask(TaskNode* node) {
+  if (node->linked_) {
+    if (node->prev_) node->prev_->next_ = node->next_;
+    if (node->next_) node->next_->prev_ = node->prev_;
+    if (liveTasks_ == node) liveTasks_ = node->next_;
+    node->linked_ = false;
+    --numLiveTasks_;
+  }
+  HandleOf(node).destroy();
+}
+
+void Base::Internal::DetachedPromise::FinalAwaitable::await_suspend(
+    std::coroutine_handle<DetachedPromise> handle) noexcept {
+  auto& promise = handle.promise();
+  promise.service_->OnTaskDone(&promise);
+}
+
+void Base::IoService::Notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // the loop checks its queues after it marks itself polling, so only a
+  // polling loop needs the eventfd and only one write per poll is enough
+  if (polling_.load(std::memory_order_relaxed) &&
+      !notified_.exchange(true, std::memory_order_relaxed)) {
+    ioWatcher_->WakeUp();
+  }
+}
+
+const std::vector<Base::IoService::Handle>* Base::IoService::BusyPoll(
+    int64_t waitTime) {
+  // the budget doubles on a hit and halves on a miss, within
+  // [max / 16, max]
+  constexpr int kMinSpinShift = 4;
+  auto spinNs = spinNs_.load(std::memory_order_relaxed);
+  auto budget = waitTime > 0 ? std::min(spinNs, waitTime) : spinNs;
+  const auto until = MonoTime::Now() + std::chrono::nanoseconds(budget);
+  // not polling_, producers don't write the eventfd while the loop spins.
+  // Stop() does, so running_ is checked as well
+  do {
+    const auto& activeCoros = ioWatcher_->WatchIo(0);
+    if (!activeCoros.empty() || !pendingTasks_.Empty() ||
+        !running_.load(std::memory_order_relaxed) ||
+        timersChanged_.load(std::memory_order_relaxed) ||
+        (scheduler_ && scheduler_->HasTask(schedulerIndex_))) {
+      spinHits_.fetch_add(1, std::memory_order_relaxed);
+      spinNs_.store(std::min(spinNs * 2, maxSpinNs_),
+                    std::memory_order_relaxed);
+      return &activeCoros;
+    }
+  } while (MonoTime::Now() < until);
+  spinMisses_.fetch_add(1, std::memory_order_relaxed);
+  spinNs_.store(std::max(spinNs / 2, maxSpinNs_ >> kMinSpinShift),
+                std::memory_order_relaxed);
+  return nullptr;
+}
+
+Base::BusyPollStats Base::IoService::GetBusyPollStats() const {
+  BusyPollStats stats;
+  stats.spinHits = spinHits_.load(std::memory_order_relaxed);
+  stats.spinMisses = spinMisses_.load(std::memory_order_relaxed);
+  stats.blockingWaits = blockingWaits_.load(std::memory_order_relaxed);
+  stats.spinNanoSeconds = spinNs_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool Base::IoService::RunScheduledTasks() {
+  if (!scheduler_) return false;
+  // bound the batch so io events are not starved by a deep deque
+  constexpr int kMaxBatch = 64;
+  int count = 0;
+  Task<> task;
+  while (count < kMaxBatch && scheduler_->Pop(schedulerIndex_, task)) {
+    RunTask(&WrapTask(std::move(task)).Release().promise());
+    ++count;
+  }
+  if (count == 0 && localTasks_.empty() &&
+      scheduler_->Steal(schedulerIndex_, task)) {
+    RunTask(&WrapTask(std::move(task)).Release().promise());
+    ++count;
+  }
+  return count > 0;
+}
+
+void Base::IoService::TakePendingTasks(std::vector<TaskNode*>& tasks) {
+  tasks.swap(localTasks_);
+  while (auto node = pendingTasks_.Pop()) {
+    tasks.push_back(static_cast<TaskNode*>(node));
+  }
 }
 
 void Base::IoService::AddTimer(Timer& timer) {
-  LockGuard guard(mutexForTimerQueue_);
-  timerQueue_->AddTimer(timer);
+  {
+    LockGuard guard(mutexForTimerQueue_);
+    timerQueue_->AddTimer(timer);
+  }
+  OnTimersChanged();
 }
 
 void Base::IoService::UpdateTimer(Timer& timer) {
-  LockGuard guard(mutexForTimerQueue_);
-  timerQueue_->UpdateTimer(timer);
+  {
+    LockGuard guard(mutexForTimerQueue_);
+    timerQueue_->UpdateTimer(timer);
+  }
+  OnTimersChanged();
+}
+
+void Base::IoService::OnTimersChanged() {
+  // the loop recomputes its wait time every iteration
+  if (InLoopThread()) return;
+  // the loop sleeps until the earliest timer it knew, maybe forever
+  timersChanged_.store(true, std::memory_order_relaxed);
+  Notify();
 }
 
 void Base::IoService::CancelTimer(Timer& timer) {
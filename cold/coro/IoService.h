@@ -4,23 +4,136 @@
 #include <atomic>
 #include <cassert>
 #include <coroutine>
-#include <map>
 #include <memory>
 #include <vector>
 
+#include "cold/coro/IoDeadline.h"
+#include "cold/coro/IoWatcher.h"
 #include "cold/coro/Task.h"
 #include "cold/thread/Lock.h"
+#include "cold/thread/MpscQueue.h"
+#include "cold/time/LoopClock.h"
+#include "cold/time/TimerQueue.h"
 
 namespace Cold::Base {
 
-class IoWatcher;
-class Timer;
-class TimerQueue;
+class IoService;
+class WorkStealingScheduler;
+
+namespace Internal {
+
+class DetachedPromise;
+
+// a coroutine spawned to IoService. nobody waits for it, the frame is
+// destroyed at final suspend by the IoService which runs it
+class DetachedTask {
+ public:
+  using promise_type = DetachedPromise;
+
+  explicit DetachedTask(std::coroutine_handle<DetachedPromise> handle) noexcept
+      : handle_(handle) {}
+  ~DetachedTask() {
+    if (handle_) handle_.destroy();
+  }
+
+  DetachedTask(const DetachedTask&) = delete;
+  DetachedTask& operator=(const DetachedTask&) = delete;
+
+  DetachedTask(DetachedTask&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  std::coroutine_handle<DetachedPromise> GetHandle() const { return handle_; }
+
+  std::coroutine_handle<DetachedPromise> Release() noexcept {
+    return std::exchange(handle_, nullptr);
+  }
+
+ private:
+  std::coroutine_handle<DetachedPromise> handle_;
+};
+
+// MpscQueueNode let a spawned (or finished in another thread) coroutine be
+// queued to IoService without allocation. prev/next link the running
+// coroutines of the IoService
+class DetachedPromise : public MpscQueueNode {
+  friend class Cold::Base::IoService;
+
+ public:
+  static void* operator new(size_t size) { return FramePool::Allocate(size); }
+  static void operator delete(void* ptr) noexcept {
+    FramePool::Deallocate(ptr);
+  }
+
+  DetachedTask get_return_object() noexcept {
+    return DetachedTask(
+        std::coroutine_handle<DetachedPromise>::from_promise(*this));
+  }
+
+  auto initial_suspend() noexcept { return std::suspend_always(); }
+  auto final_suspend() noexcept { return FinalAwaitable(); }
+  void unhandled_exception() noexcept { assert(false); }
+  void return_void() noexcept {}
+
+ private:
+  struct FinalAwaitable {
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<DetachedPromise> handle) noexcept;
+    void await_resume() noexcept {}
+  };
+
+  IoService* service_ = nullptr;
+  DetachedPromise* prev_ = nullptr;
+  DetachedPromise* next_ = nullptr;
+  bool linked_ = false;
+};
+
+}  // namespace Internal
+
+struct IoServiceOptions {
+  IoBackend backend = IoBackend::kEpoll;
+  TimerQueueType timerQueue = TimerQueueType::kHeap;
+  // read the loop clock with CLOCK_MONOTONIC_COARSE. timers may fire up to
+  // a kernel tick late
+  bool coarseClock = false;
+  // spin on the run queues and a non blocking WatchIo for up to this long
+  // before blocking. the budget adapts to the hit rate. 0 disables
+  int64_t busyPollMicroSeconds = 0;
+
+  // read from global config. keys:
+  // /coro/io-backend: "epoll" or "io_uring"
+  // /coro/timer-queue: "heap" or "timing-wheel"
+  // /coro/coarse-clock: bool
+  // /coro/busy-poll-us: int
+  static IoServiceOptions FromConfig();
+};
+
+struct BusyPollStats {
+  // spins ended by an io event or a new task
+  uint64_t spinHits = 0;
+  // spins which ran out of budget
+  uint64_t spinMisses = 0;
+  // waits in WatchIo which may block
+  uint64_t blockingWaits = 0;
+  // current spin budget
+  int64_t spinNanoSeconds = 0;
+};
+
+struct IoServiceLoad {
+  // spawned coroutines which have not started
+  size_t queuedTasks = 0;
+  // connections running in the service, counted by the servers
+  size_t connections = 0;
+};
 
 class IoService {
+  friend class IoServicePool;
+  friend class WorkStealingScheduler;
+  friend class Internal::DetachedPromise;
+
  public:
   using Handle = std::coroutine_handle<>;
   IoService();
+  explicit IoService(const IoServiceOptions& options);
   ~IoService();
 
   IoService(const IoService&) = delete;
@@ -44,48 +157,146 @@ class IoService {
   void StopListeningWriteEvent(int fd);
   void StopListeningAll(int fd);
 
- private:
-  struct TaskCompletionAwaitable {
-    TaskCompletionAwaitable(IoService* s) : service(s) {}
-    bool await_ready() noexcept { return false; }
+  // see IoWatcher::ListenErrorEvent
+  void ListenErrorEvent(int fd, const Handle& handle) {
+    ioWatcher_->ListenErrorEvent(fd, handle);
+  }
+  void StopListeningErrorEvent(int fd) {
+    ioWatcher_->StopListeningErrorEvent(fd);
+  }
+  bool UsesErrorQueue(int fd) { return ioWatcher_->UsesErrorQueue(fd); }
 
-    Handle await_suspend(Handle handle) noexcept {
-      LockGuard guard(service->mutexForCompletionTasks_);
-      service->completionTasks_.push_back(handle);
-      return handle;
-    }
+  // see IoWatcher::SubmitOperation. loop thread only
+  bool SubmitOperation(int fd, const Handle& handle, IoOperation& op) {
+    assert(InLoopThread());
+    return ioWatcher_->SubmitOperation(fd, handle, op);
+  }
+  bool SupportsOperations() const { return ioWatcher_->SupportsOperations(); }
 
-    void await_resume() noexcept {}
+  // loop thread only. the deadline of a suspended io, see IoDeadline
+  void AddDeadline(IoDeadline& deadline, MonoTime expiry) {
+    assert(InLoopThread());
+    deadlines_.Push(deadline, expiry);
+  }
+  void CancelDeadline(IoDeadline& deadline) { deadlines_.Remove(deadline); }
 
-    IoService* service;
-  };
+  IoBackend GetBackend() const { return ioWatcher_->GetBackend(); }
+
+  // whether the caller is running in the thread which runs Start()
+  bool InLoopThread() const;
+
+  // in the loop thread, the time cached at the start of the current
+  // iteration. otherwise read the clock
+  MonoTime Now() const {
+    return InLoopThread() ? clock_.GetMonoTime() : clock_.ReadMonoTime();
+  }
+
+  // number of spawned coroutines which are started but not finished.
+  // loop thread only. for diagnostics
+  size_t GetNumLiveTasks() const { return numLiveTasks_; }
+
+  // thread safe
+  BusyPollStats GetBusyPollStats() const;
+
+  // thread safe. read by the dispatch policies of IoServicePool
+  IoServiceLoad GetLoad() const {
+    IoServiceLoad load;
+    load.queuedTasks = numQueuedTasks_.load(std::memory_order_relaxed);
+    load.connections = numConnections_.load(std::memory_order_relaxed);
+    return load;
+  }
+
+  void AddConnection() {
+    numConnections_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RemoveConnection() {
+    numConnections_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  using TaskNode = Internal::DetachedPromise;
 
   template <typename T>
-  Task<> WrapTask(Task<T> task);
+  Internal::DetachedTask WrapTask(Task<T> task);
+
+  void AddTask(Internal::DetachedTask task);
+
+  void TakePendingTasks(std::vector<TaskNode*>& tasks);
+
+  // link the task to the live list and run it
+  void RunTask(TaskNode* node);
+
+  // called at the final suspend of a spawned coroutine
+  void OnTaskDone(TaskNode* node);
+
+  void DestroyTask(TaskNode* node);
 
-  void AddTask(Task<> task);
+  // run tasks of the pool scheduler. return false if there is nothing to run
+  bool RunScheduledTasks();
+
+  void SetScheduler(WorkStealingScheduler* scheduler, size_t index) {
+    assert(!running_);
+    scheduler_ = scheduler;
+    schedulerIndex_ = index;
+  }
+
+  bool IsPolling() const { return polling_.load(std::memory_order_relaxed); }
+
+  // wake up the loop if it is blocked in WatchIo
+  void Notify();
+
+  // spin before blocking for at most waitTime ns. nullptr when nothing
+  // happened within the budget
+  const std::vector<Handle>* BusyPoll(int64_t waitTime);
+
+  // a timer is added or updated
+  void OnTimersChanged();
 
   std::atomic<bool> running_ = false;
   std::unique_ptr<IoWatcher> ioWatcher_;
+  LoopClock clock_;
 
   Mutex mutexForTimerQueue_;
   std::unique_ptr<TimerQueue> timerQueue_ GUARDED_BY(mutexForTimerQueue_);
+  IoDeadlineQueue deadlines_;
+
+  // tasks spawned from other threads
+  MpscQueue pendingTasks_;
+  // tasks spawned in the loop thread
+  std::vector<TaskNode*> localTasks_;
+  // the loop is (about to be) blocked in WatchIo
+  std::atomic<bool> polling_ = false;
+  // a WakeUp has been sent since the loop went polling
+  std::atomic<bool> notified_ = false;
+  // timers are changed by other threads after the loop computed its wait
+  std::atomic<bool> timersChanged_ = false;
+
+  // busy poll. written by the loop thread only
+  const int64_t maxSpinNs_;
+  std::atomic<int64_t> spinNs_;
+  std::atomic<uint64_t> spinHits_ = 0;
+  std::atomic<uint64_t> spinMisses_ = 0;
+  std::atomic<uint64_t> blockingWaits_ = 0;
 
-  Mutex mutexForPendingTasks_;
-  std::vector<Task<>> pendingTasks_ GUARDED_BY(mutexForPendingTasks_);
+  WorkStealingScheduler* scheduler_ = nullptr;
+  size_t schedulerIndex_ = 0;
 
-  std::map<Handle, Task<>> awaitCompletionTasks_;
+  // started and not finished spawned coroutines
+  TaskNode* liveTasks_ = nullptr;
+  size_t numLiveTasks_ = 0;
 
-  Mutex mutexForCompletionTasks_;
-  std::vector<Handle> completionTasks_ GUARDED_BY(mutexForCompletionTasks_);
+  // load counters, see GetLoad
+  std::atomic<size_t> numQueuedTasks_ = 0;
+  std::atomic<size_t> numConnections_ = 0;
 };
 
 template <typename T>
-Task<> IoService::WrapTask(Task<T> task) {
-  return [](Task<T> t, IoService* service) -> Task<> {
+Internal::DetachedTask IoService::WrapTask(Task<T> task) {
+  auto detached = [](Task<T> t) -> Internal::DetachedTask {
     co_await t;
-    co_await TaskCompletionAwaitable(service);
-  }(std::move(task), this);
+  }(std::move(task));
+  detached.GetHandle().promise().service_ = this;
+  return detached;
 }
 
 }  // namespace Cold::Base
@@ -1,5 +1,9 @@
 #include "cold/coro/IoServicePool.h"
 
+#include <algorithm>
+
+#include "cold/log/Logger.h"
+#include "cold/util/Config.h"
 #include "third_party/fmt/include/fmt/format.h"
 
 using namespace Cold;
@@ -12,11 +16,32 @@ Base::IoServicePool::IoServicePool(size_t poolSize, std::string nameArg)
   for (size_t i = 0; i < poolSize; ++i) {
     auto ioService = std::make_unique<IoService>();
     auto thread = std::make_unique<Thread>(
-        [service = ioService.get()]() { service->Start(); },
-        fmt::format("{}-{}", nameArg_, i + 1));
+        [this, i]() { RunWorker(i); }, fmt::format("{}-{}", nameArg_, i + 1));
     threads_.push_back(std::move(thread));
+    services_.push_back(ioService.get());
     serviceVector_.push_back(std::move(ioService));
   }
+  auto& config = Config::GetGloablDefaultConfig();
+  auto policy = DispatchPolicyType::kRoundRobin;
+  if (config.Contains("/coro/dispatch-policy")) {
+    auto name = config.GetConfig("/coro/dispatch-policy").get<std::string>();
+    if (name == "least-connections") {
+      policy = DispatchPolicyType::kLeastConnections;
+    } else if (name == "least-queued-tasks") {
+      policy = DispatchPolicyType::kLeastQueuedTasks;
+    } else if (name == "power-of-two-choices") {
+      policy = DispatchPolicyType::kPowerOfTwoChoices;
+    } else if (name == "consistent-hash") {
+      policy = DispatchPolicyType::kConsistentHash;
+    } else if (name != "round-robin") {
+      Base::WARN("Unknown dispatch policy: {}. use round-robin", name);
+    }
+  }
+  policy_ = DispatchPolicy::Create(policy);
+  if (config.Contains("/coro/cpu-affinity") &&
+      config.GetConfig("/coro/cpu-affinity").get<bool>()) {
+    PinWorkersToCpus();
+  }
 }
 
 Base::IoServicePool::~IoServicePool() {
@@ -31,8 +56,8 @@ Base::IoService& Base::IoServicePool::GetMainIoService() {
 
 Base::IoService& Base::IoServicePool::GetNextIoService() {
   if (serviceVector_.empty()) return mainIoService_;
-  if (index_ >= serviceVector_.size()) index_ = 0;
-  return *serviceVector_[index_++].get();
+  auto index = index_.fetch_add(1, std::memory_order_relaxed);
+  return *serviceVector_[index % serviceVector_.size()].get();
 }
 
 Base::IoService& Base::IoServicePool::GetIoServiceForHash(size_t hashCode) {
@@ -40,9 +65,87 @@ Base::IoService& Base::IoServicePool::GetIoServiceForHash(size_t hashCode) {
   return *serviceVector_[hashCode % serviceVector_.size()].get();
 }
 
+Base::IoService& Base::IoServicePool::SelectIoService(size_t hashCode) {
+  if (services_.empty()) return mainIoService_;
+  return *services_[policy_->Select(services_, hashCode)];
+}
+
+void Base::IoServicePool::SetCpuAffinity(
+    std::vector<std::vector<int>> cpuSets) {
+  assert(!started_);
+  cpuSets_ = std::move(cpuSets);
+  cpuToService_.clear();
+  if (cpuSets_.empty()) return;
+  for (size_t i = 0; i < serviceVector_.size(); ++i) {
+    for (auto cpu : cpuSets_[i % cpuSets_.size()]) {
+      if (cpu < 0) continue;
+      auto index = static_cast<size_t>(cpu);
+      if (index >= cpuToService_.size()) cpuToService_.resize(index + 1, -1);
+      // a cpu shared by several workers goes to the first one
+      if (cpuToService_[index] < 0) {
+        cpuToService_[index] = static_cast<int>(i);
+      }
+    }
+  }
+}
+
+void Base::IoServicePool::PinWorkersToCpus() {
+  auto cpus = ThisThread::GetCpuAffinity();
+  if (cpus.empty()) {
+    Base::WARN("Cannot get cpu affinity. reason: {}", ThisThread::ErrorMsg());
+    return;
+  }
+  std::vector<std::vector<int>> cpuSets;
+  for (size_t i = 0; i < std::min(cpus.size(), serviceVector_.size()); ++i) {
+    cpuSets.push_back({cpus[i]});
+  }
+  SetCpuAffinity(std::move(cpuSets));
+}
+
+Base::IoService& Base::IoServicePool::GetIoServiceForCpu(int cpu) {
+  if (cpu >= 0 && static_cast<size_t>(cpu) < cpuToService_.size() &&
+      cpuToService_[static_cast<size_t>(cpu)] >= 0) {
+    auto index = static_cast<size_t>(cpuToService_[static_cast<size_t>(cpu)]);
+    return *serviceVector_[index];
+  }
+  return SelectIoService();
+}
+
+void Base::IoServicePool::RunWorker(size_t index) {
+  // pin before the loop allocates anything
+  if (!cpuSets_.empty()) {
+    if (!ThisThread::SetCpuAffinity(cpuSets_[index % cpuSets_.size()])) {
+      Base::WARN("Cannot set cpu affinity of {}. reason: {}",
+                 ThisThread::ThreadName(), ThisThread::ErrorMsg());
+    }
+  }
+  serviceVector_[index]->Start();
+}
+
 void Base::IoServicePool::Start() {
+  assert(!started_);
+  started_ = true;
+  if (workStealing_ && !serviceVector_.empty()) {
+    scheduler_ = std::make_unique<WorkStealingScheduler>(services_);
+    for (size_t i = 0; i < serviceVector_.size(); ++i) {
+      serviceVector_[i]->SetScheduler(scheduler_.get(), i);
+    }
+  }
   for (auto& thread : threads_) {
     thread->Start();
   }
   mainIoService_.Start();
+}
+
+void Base::IoServicePool::Stop() {
+  // stop through the task queues, so a service which has not started yet
+  // is stopped as well
+  auto stop = [](IoService& service) -> Task<> {
+    service.Stop();
+    co_return;
+  };
+  for (auto& service : serviceVector_) {
+    service->CoSpawn(stop(*service));
+  }
+  mainIoService_.CoSpawn(stop(mainIoService_));
 }
\ No newline at end of file
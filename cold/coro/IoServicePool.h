@@ -1,7 +1,9 @@
 #ifndef COLD_CORO_IOSERVICEPOOL
 #define COLD_CORO_IOSERVICEPOOL
 
+#include "cold/coro/DispatchPolicy.h"
 #include "cold/coro/IoService.h"
+#include "cold/coro/WorkStealingScheduler.h"
 #include "cold/thread/Thread.h"
 
 namespace Cold::Base {
@@ -15,20 +17,96 @@ class IoServicePool {
   IoServicePool& operator=(const IoServicePool&) = delete;
 
   IoService& GetMainIoService();
+  // round robin
   IoService& GetNextIoService();
   IoService& GetIoServiceForHash(size_t hashCode);
 
+  // choose the worker of a new connection by the dispatch policy. hashCode
+  // identifies the peer for kConsistentHash. thread safe
+  IoService& SelectIoService(size_t hashCode = 0);
+
+  // round robin by default, or /coro/dispatch-policy: "round-robin",
+  // "least-connections", "least-queued-tasks", "power-of-two-choices" or
+  // "consistent-hash". must be called before Start
+  void SetDispatchPolicy(std::unique_ptr<DispatchPolicy> policy) {
+    assert(!started_);
+    assert(policy);
+    policy_ = std::move(policy);
+  }
+
+  void SetDispatchPolicy(DispatchPolicyType type) {
+    SetDispatchPolicy(DispatchPolicy::Create(type));
+  }
+
   size_t GetPoolSize() const { return poolSize_; }
 
+  // runnable coroutines spawned by CoSpawn can be stolen by idle workers.
+  // must be called before Start. no effect when the pool size is 0
+  void EnableWorkStealing(bool on) {
+    assert(!started_);
+    workStealing_ = on;
+  }
+
+  bool IsWorkStealingEnabled() const { return workStealing_; }
+
+  // pin worker i to cpuSets[i % cpuSets.size()]. a worker allocates its
+  // frame pool and buffers itself, so with first touch they are placed on
+  // the numa node of its cpus. must be called before Start
+  void SetCpuAffinity(std::vector<std::vector<int>> cpuSets);
+
+  // pin worker i to the i-th cpu the process is allowed to run on
+  void PinWorkersToCpus();
+
+  const std::vector<std::vector<int>>& GetCpuAffinity() const {
+    return cpuSets_;
+  }
+
+  // the worker pinned to cpu, e.g. the cpu from SO_INCOMING_CPU of a
+  // socket. SelectIoService if no worker is pinned to it
+  IoService& GetIoServiceForCpu(int cpu);
+
+  // spawn a coroutine on the pool workers. with work stealing, the task
+  // may run in any worker, io on a socket still resumes in the socket's
+  // IoService. without work stealing, this is GetNextIoService().CoSpawn
+  template <typename T>
+  void CoSpawn(Task<T> task) {
+    if (!scheduler_) {
+      GetNextIoService().CoSpawn(std::move(task));
+      return;
+    }
+    if constexpr (std::is_void_v<T>) {
+      scheduler_->Push(std::move(task));
+    } else {
+      scheduler_->Push([](Task<T> t) -> Task<> { co_await t; }(std::move(task)));
+    }
+  }
+
+  // number of tasks taken by a worker from the deque of another worker
+  size_t GetStealCount() const {
+    return scheduler_ ? scheduler_->GetStealCount() : 0;
+  }
+
   void Start();
+  void Stop();
 
  private:
+  void RunWorker(size_t index);
+
   size_t poolSize_;
   std::string nameArg_;
   IoService mainIoService_;
   std::vector<std::unique_ptr<Thread>> threads_;
   std::vector<std::unique_ptr<IoService>> serviceVector_;
-  std::atomic<size_t> index_;
+  // same as serviceVector_, for the dispatch policy
+  std::vector<IoService*> services_;
+  std::unique_ptr<DispatchPolicy> policy_;
+  std::atomic<size_t> index_ = 0;
+  bool workStealing_ = false;
+  bool started_ = false;
+  std::unique_ptr<WorkStealingScheduler> scheduler_;
+  std::vector<std::vector<int>> cpuSets_;
+  // cpu -> index of the worker pinned to it, -1 if none
+  std::vector<int> cpuToService_;
 };
 
 }  // namespace Cold::Base
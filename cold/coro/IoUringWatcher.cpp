@@ -0,0 +1,493 @@
+#include "cold/coro/IoUringWatcher.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <csignal>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "cold/log/Logger.h"
+#include "cold/time/Time.h"
+
+using namespace Cold;
+
+namespace {
+
+int IoUringSetup(unsigned entries, struct io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringRegister(int ringFd, unsigned opcode, void* arg, unsigned nrArgs) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs));
+}
+
+int IoUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags, void* arg, size_t argSize) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit,
+                                  minComplete, flags, arg, argSize));
+}
+
+unsigned LoadAcquire(unsigned* p) {
+  return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void StoreRelease(unsigned* p, unsigned v) {
+  std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+template <typename T>
+T* Offset(void* base, uint32_t off) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+}
+
+}  // namespace
+
+bool Base::IoUringWatcher::IsSupported() {
+  struct io_uring_params params {};
+  int fd = IoUringSetup(1, &params);
+  if (fd < 0) return false;
+  close(fd);
+  return true;
+}
+
+Base::IoUringWatcher::IoUringWatcher() {
+  struct io_uring_params params {};
+  ringFd_ = IoUringSetup(kEntries, &params);
+  if (ringFd_ < 0) {
+    Base::WARN("io_uring_setup error. reason: {}", ThisThread::ErrorMsg());
+    return;
+  }
+  features_ = params.features;
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (features_ & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED) {
+    Base::FATAL("mmap sq ring error. reason: {}", ThisThread::ErrorMsg());
+  }
+  if (features_ & IORING_FEAT_SINGLE_MMAP) {
+    cqRing_ = sqRing_;
+  } else {
+    cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED) {
+      Base::FATAL("mmap cq ring error. reason: {}", ThisThread::ErrorMsg());
+    }
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(
+      mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe),
+           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+           IORING_OFF_SQES));
+  if (sqes_ == MAP_FAILED) {
+    Base::FATAL("mmap sqes error. reason: {}", ThisThread::ErrorMsg());
+  }
+
+  sqHead_ = Offset<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = Offset<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = *Offset<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  sqArray_ = Offset<unsigned>(sqRing_, params.sq_off.array);
+  for (unsigned i = 0; i < sqEntries_; ++i) sqArray_[i] = i;
+  sqeTail_ = *sqTail_;
+
+  cqHead_ = Offset<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = Offset<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = *Offset<unsigned>(cqRing_, params.cq_off.ring_mask);
+  cqes_ = Offset<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+
+  wakeUpFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wakeUpFd_ < 0) {
+    Base::FATAL("Create event fd error. reason: {}", ThisThread::ErrorMsg());
+  }
+  ArmWakeUp();
+  hasOperations_ = ProbeOperations();
+  if (!hasOperations_) {
+    Base::INFO("io_uring socket operations are not supported. use poll");
+  }
+}
+
+Base::IoUringWatcher::~IoUringWatcher() {
+  if (ringFd_ < 0) return;
+  munmap(sqes_, sqEntries_ * sizeof(struct io_uring_sqe));
+  if (cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+  munmap(sqRing_, sqRingSize_);
+  close(wakeUpFd_);
+  close(ringFd_);
+}
+
+bool Base::IoUringWatcher::ProbeOperations() {
+  std::vector<char> buf(sizeof(struct io_uring_probe) +
+                        IORING_OP_LAST * sizeof(struct io_uring_probe_op));
+  auto probe = reinterpret_cast<struct io_uring_probe*>(buf.data());
+  if (IoUringRegister(ringFd_, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) <
+      0) {
+    return false;
+  }
+  for (auto opcode : {IORING_OP_RECV, IORING_OP_SEND, IORING_OP_RECVMSG,
+                      IORING_OP_SENDMSG, IORING_OP_ACCEPT, IORING_OP_CONNECT,
+                      IORING_OP_ASYNC_CANCEL}) {
+    if (opcode > probe->last_op ||
+        !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t Base::IoUringWatcher::NextGen() {
+  auto gen = nextGen_;
+  nextGen_ = (nextGen_ + 1) & 0x3fffffff;
+  if (nextGen_ == 0) nextGen_ = 1;
+  return gen;
+}
+
+void Base::IoUringWatcher::ListenReadEvent(int fd, Handle handle) {
+  // only register the fd. the poll is armed when a coroutine waits on it
+  if (handle == std::noop_coroutine()) {
+    ioEvents_.FindOrAdd(fd);
+    return;
+  }
+  Listen(fd, kRead, handle, nullptr);
+}
+
+void Base::IoUringWatcher::ListenWriteEvent(int fd, Handle handle) {
+  Listen(fd, kWrite, handle, nullptr);
+}
+
+bool Base::IoUringWatcher::SubmitOperation(int fd, Handle handle,
+                                           IoOperation& op) {
+  if (!hasOperations_) return false;
+  op.submitted = true;
+  op.completed = false;
+  Listen(fd, op.IsRead() ? kRead : kWrite, handle, &op);
+  return true;
+}
+
+void Base::IoUringWatcher::Listen(int fd, Direction dir, Handle handle,
+                                  IoOperation* op) {
+  auto& event = ioEvents_.FindOrAdd(fd);
+  auto& waiter = event.Get(dir);
+  assert(waiter.handle == std::noop_coroutine());
+  waiter.handle = handle;
+  waiter.op = op;
+  waiter.gen = NextGen();
+  waiter.polling = false;
+  if (op) {
+    ArmOperation(fd, dir, waiter.gen, *op);
+  } else {
+    ArmPoll(fd, dir, waiter.gen);
+  }
+}
+
+void Base::IoUringWatcher::StopListening(int fd, Direction dir,
+                                         Waiter& waiter) {
+  if (waiter.gen != 0) {
+    if (waiter.op && !waiter.polling) {
+      CancelOperation(fd, dir, waiter.gen, *waiter.op);
+    } else {
+      CancelPoll(fd, dir, waiter.gen);
+    }
+  }
+  waiter = Waiter();
+}
+
+void Base::IoUringWatcher::StopListeningReadEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  StopListening(fd, kRead, event->read);
+}
+
+void Base::IoUringWatcher::StopListeningWriteEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  StopListening(fd, kWrite, event->write);
+}
+
+void Base::IoUringWatcher::StopListeningAll(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  StopListening(fd, kRead, event->read);
+  StopListening(fd, kWrite, event->write);
+  StopListening(fd, kError, event->error);
+  ioEvents_.Remove(fd);
+}
+
+void Base::IoUringWatcher::ListenErrorEvent(int fd, Handle handle) {
+  if (handle == std::noop_coroutine()) {
+    ioEvents_.FindOrAdd(fd).errorQueue = true;
+    return;
+  }
+  Listen(fd, kError, handle, nullptr);
+}
+
+void Base::IoUringWatcher::StopListeningErrorEvent(int fd) {
+  auto event = ioEvents_.Find(fd);
+  if (!event) return;
+  StopListening(fd, kError, event->error);
+}
+
+bool Base::IoUringWatcher::UsesErrorQueue(int fd) {
+  auto event = ioEvents_.Find(fd);
+  return event && event->errorQueue;
+}
+
+void Base::IoUringWatcher::WakeUp() {
+  uint64_t value = 666;
+  if (write(wakeUpFd_, &value, sizeof value) != sizeof value) {
+    Base::ERROR("WakeUp Error reason: {}", ThisThread::ErrorMsg());
+  }
+}
+
+void Base::IoUringWatcher::HandleWakeUp() {
+  uint64_t value = 0;
+  Base::TRACE("HandleWakeUp");
+  if (read(wakeUpFd_, &value, sizeof value) != sizeof value) {
+    Base::ERROR("HandleWakeUp Error Reason:{}", ThisThread::ErrorMsg());
+  }
+  ArmWakeUp();
+}
+
+void Base::IoUringWatcher::ArmPoll(int fd, Direction dir, uint32_t gen) {
+  auto sqe = GetSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = PollEvents(dir);
+  sqe->user_data = MakeUserData(fd, dir, gen);
+}
+
+void Base::IoUringWatcher::CancelPoll(int fd, Direction dir, uint32_t gen) {
+  auto sqe = GetSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = MakeUserData(fd, dir, gen);
+  sqe->user_data = kIgnoreTag;
+}
+
+void Base::IoUringWatcher::ArmOperation(int fd, Direction dir, uint32_t gen,
+                                        IoOperation& op) {
+  auto sqe = GetSqe();
+  sqe->fd = fd;
+  sqe->user_data = MakeUserData(fd, dir, gen);
+  sqe->addr = reinterpret_cast<uint64_t>(op.addr);
+  switch (op.opcode) {
+    case IoOperation::kRecv:
+    case IoOperation::kSend:
+      sqe->opcode =
+          op.opcode == IoOperation::kRecv ? IORING_OP_RECV : IORING_OP_SEND;
+      sqe->len = static_cast<uint32_t>(
+          std::min<size_t>(op.len, std::numeric_limits<uint32_t>::max()));
+      sqe->msg_flags = static_cast<uint32_t>(op.flags);
+      break;
+    case IoOperation::kRecvMsg:
+    case IoOperation::kSendMsg:
+      sqe->opcode = op.opcode == IoOperation::kRecvMsg ? IORING_OP_RECVMSG
+                                                       : IORING_OP_SENDMSG;
+      sqe->len = 1;
+      sqe->msg_flags = static_cast<uint32_t>(op.flags);
+      break;
+    case IoOperation::kAccept:
+      sqe->opcode = IORING_OP_ACCEPT;
+      sqe->addr2 = reinterpret_cast<uint64_t>(op.addrlen);
+      sqe->accept_flags = static_cast<uint32_t>(op.flags);
+      break;
+    case IoOperation::kConnect:
+      sqe->opcode = IORING_OP_CONNECT;
+      sqe->off = op.len;
+      break;
+    case IoOperation::kNone:
+      assert(false);
+      break;
+  }
+}
+
+void Base::IoUringWatcher::CancelOperation(int fd, Direction dir,
+                                           uint32_t gen, IoOperation& op) {
+  const auto userData = MakeUserData(fd, dir, gen);
+  auto sqe = GetSqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = userData;
+  sqe->user_data = kIgnoreTag;
+  Submit();
+  while (true) {
+    unsigned head = *cqHead_;
+    const unsigned tail = LoadAcquire(cqTail_);
+    bool found = false;
+    for (; head != tail && !found; ++head) {
+      const auto& cqe = cqes_[head & cqMask_];
+      if (cqe.user_data == userData) {
+        if (cqe.res != -ECANCELED && cqe.res != -EAGAIN) {
+          op.result = cqe.res;
+          op.completed = true;
+        }
+        found = true;
+      } else if (cqe.user_data != kIgnoreTag) {
+        // reaped for WatchIo. a full ring would keep the cqe waited for in
+        // the overflow list of the kernel
+        stashedCqes_.push_back(cqe);
+      }
+    }
+    StoreRelease(cqHead_, head);
+    if (found) return;
+    if (IoUringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr,
+                     _NSIG / 8) < 0 &&
+        errno != EINTR) {
+      Base::ERROR("io_uring_enter error reson: {}", ThisThread::ErrorMsg());
+      return;
+    }
+  }
+}
+
+void Base::IoUringWatcher::ArmWakeUp() {
+  auto sqe = GetSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = wakeUpFd_;
+  sqe->poll32_events = POLLIN;
+  sqe->user_data = kWakeUpTag;
+}
+
+struct io_uring_sqe* Base::IoUringWatcher::GetSqe() {
+  if (sqeTail_ - LoadAcquire(sqHead_) >= sqEntries_) {
+    // submission queue is full. flush it now
+    Submit();
+    if (toSubmit_ >= sqEntries_) {
+      Base::FATAL("io_uring submission queue overflow");
+    }
+  }
+  auto sqe = &sqes_[sqeTail_ & sqMask_];
+  memset(sqe, 0, sizeof(*sqe));
+  ++sqeTail_;
+  ++toSubmit_;
+  return sqe;
+}
+
+void Base::IoUringWatcher::Submit() {
+  StoreRelease(sqTail_, sqeTail_);
+  if (IoUringEnter(ringFd_, toSubmit_, 0, 0, nullptr, 0) < 0) {
+    Base::ERROR("io_uring_enter error. reason: {}", ThisThread::ErrorMsg());
+  }
+  toSubmit_ = sqeTail_ - LoadAcquire(sqHead_);
+}
+
+void Base::IoUringWatcher::SubmitAndWait(int64_t waitNs) {
+  struct __kernel_timespec ts {};
+  ts.tv_sec = waitNs / Time::kNanoSecondsPerSecond;
+  ts.tv_nsec = waitNs % Time::kNanoSecondsPerSecond;
+  const bool hasCompletion =
+      !stashedCqes_.empty() || LoadAcquire(cqTail_) != *cqHead_;
+  const bool wait = waitNs != 0 && !hasCompletion;
+  const bool timed = waitNs > 0;
+  const bool extArg = features_ & IORING_FEAT_EXT_ARG;
+  if (wait && timed && !extArg) {
+    // timeout completes once any other cqe posted
+    auto sqe = GetSqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&ts);
+    sqe->len = 1;
+    sqe->off = 1;
+    sqe->user_data = kIgnoreTag;
+  }
+  if (!wait && toSubmit_ == 0) return;
+  StoreRelease(sqTail_, sqeTail_);
+  int ret = 0;
+  if (!wait) {
+    ret = IoUringEnter(ringFd_, toSubmit_, 0, 0, nullptr, 0);
+  } else if (extArg) {
+    struct io_uring_getevents_arg arg {};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timed ? reinterpret_cast<uint64_t>(&ts) : 0;
+    ret = IoUringEnter(ringFd_, toSubmit_, 1,
+                       IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                       sizeof arg);
+  } else {
+    ret = IoUringEnter(ringFd_, toSubmit_, 1, IORING_ENTER_GETEVENTS, nullptr,
+                       _NSIG / 8);
+  }
+  if (ret < 0 && errno != ETIME && errno != EINTR) {
+    Base::ERROR("io_uring_enter error reson: {}", ThisThread::ErrorMsg());
+  }
+  toSubmit_ = sqeTail_ - LoadAcquire(sqHead_);
+}
+
+const std::vector<std::coroutine_handle<>>& Base::IoUringWatcher::WatchIo(
+    int64_t waitNs) {
+  activeCoroutines_.clear();
+  SubmitAndWait(waitNs);
+  // reaped while a cancel waited, they came before those in the ring
+  for (const auto& cqe : stashedCqes_) HandleCqe(cqe);
+  stashedCqes_.clear();
+  unsigned head = *cqHead_;
+  const unsigned tail = LoadAcquire(cqTail_);
+  Base::TRACE("WatchIo total cqe: {}", tail - head);
+  for (; head != tail; ++head) HandleCqe(cqes_[head & cqMask_]);
+  StoreRelease(cqHead_, head);
+  return activeCoroutines_;
+}
+
+void Base::IoUringWatcher::HandleCqe(const struct io_uring_cqe& cqe) {
+  const auto userData = cqe.user_data;
+  if (userData == kIgnoreTag) return;
+  if (userData == kWakeUpTag) {
+    HandleWakeUp();
+    return;
+  }
+  const int fd = static_cast<int>(userData & 0xffffffff);
+  const auto dir = static_cast<Direction>((userData >> 32) & 3);
+  const auto gen = static_cast<uint32_t>(userData >> 34);
+  auto event = ioEvents_.Find(fd);
+  // canceled or fd already removed
+  if (!event) return;
+  Base::DEBUG("IoEvent Info fd: {}, write: {}, result: {}", fd,
+              dir == kWrite, cqe.res);
+  auto& waiter = event->Get(dir);
+  if (waiter.gen != gen) return;
+  if (dir != kError && event->errorQueue && (!waiter.op || waiter.polling) &&
+      cqe.res >= 0 && !(cqe.res & (PollEvents(dir) | POLLHUP))) {
+    // woken only by a queued error, which is for the error waiter. a
+    // poll completes at once while the queue is not empty, so an op goes
+    // back to the kernel instead of polling again
+    waiter.gen = NextGen();
+    if (waiter.op) {
+      waiter.polling = false;
+      ArmOperation(fd, dir, waiter.gen, *waiter.op);
+    } else {
+      ArmPoll(fd, dir, waiter.gen);
+    }
+    return;
+  }
+  if (waiter.op) {
+    if (waiter.polling) {
+      // ready now, try the operation again
+      waiter.polling = false;
+      waiter.gen = NextGen();
+      ArmOperation(fd, dir, waiter.gen, *waiter.op);
+      return;
+    }
+    if (cqe.res == -EAGAIN) {
+      // the socket is O_NONBLOCK and the kernel honors it, or another
+      // reader took the data first. wait until it is ready
+      waiter.polling = true;
+      waiter.gen = NextGen();
+      ArmPoll(fd, dir, waiter.gen);
+      return;
+    }
+    waiter.op->result = cqe.res;
+    waiter.op->completed = true;
+  }
+  activeCoroutines_.push_back(waiter.handle);
+  waiter = Waiter();
+}
@@ -0,0 +1,144 @@
+#ifndef COLD_CORO_IOURINGWATCHER
+#define COLD_CORO_IOURINGWATCHER
+
+#include <linux/io_uring.h>
+#include <poll.h>
+
+#include "cold/coro/IoEventTable.h"
+#include "cold/coro/IoWatcher.h"
+
+namespace Cold::Base {
+
+// io_uring backend. socket reads, writes, accepts and connects are
+// submitted as their own sqes (IORING_OP_RECV, SEND, RECVMSG, SENDMSG,
+// ACCEPT, CONNECT) and the waiter is resumed with the result. other waits,
+// e.g. tls, sendfile, splice and pipes, are oneshot IORING_OP_POLL_ADDs.
+// sqes queued while the loop is running are submitted together with the
+// wait in a single io_uring_enter.
+class IoUringWatcher : public IoWatcher {
+ public:
+  IoUringWatcher();
+  ~IoUringWatcher() override;
+
+  static bool IsSupported();
+
+  bool Valid() const { return ringFd_ >= 0; }
+
+  IoBackend GetBackend() const override { return IoBackend::kIoUring; }
+
+  void ListenReadEvent(int fd, Handle handle) override;
+  void ListenWriteEvent(int fd, Handle handle) override;
+  void StopListeningReadEvent(int fd) override;
+  void StopListeningWriteEvent(int fd) override;
+  void StopListeningAll(int fd) override;
+
+  void ListenErrorEvent(int fd, Handle handle) override;
+  void StopListeningErrorEvent(int fd) override;
+  bool UsesErrorQueue(int fd) override;
+
+  bool SubmitOperation(int fd, Handle handle, IoOperation& op) override;
+  bool SupportsOperations() const override { return hasOperations_; }
+
+ private:
+  enum Direction : uint64_t { kRead = 0, kWrite = 1, kError = 2 };
+
+  struct Waiter {
+    Handle handle = std::noop_coroutine();
+    // nullptr for a readiness wait
+    IoOperation* op = nullptr;
+    // of the sqe in flight, 0 if none
+    uint32_t gen = 0;
+    // op met EAGAIN. a poll is in flight, op is submitted again after it
+    bool polling = false;
+  };
+
+  struct IoEvent {
+    Waiter read;
+    Waiter write;
+    Waiter error;
+    // POLLERR is an entry in the error queue, not a broken connection
+    bool errorQueue = false;
+
+    Waiter& Get(Direction dir) {
+      return dir == kRead ? read : dir == kWrite ? write : error;
+    }
+  };
+
+  // user_data: | gen 30 bits | direction 2 bits | fd 32 bits |
+  static uint64_t MakeUserData(int fd, Direction dir, uint32_t gen) {
+    return (static_cast<uint64_t>(gen) << 34) | (dir << 32) |
+           static_cast<uint32_t>(fd);
+  }
+
+  static uint32_t PollEvents(Direction dir) {
+    return dir == kRead ? POLLIN : dir == kWrite ? POLLOUT : POLLERR;
+  }
+
+  constexpr static uint64_t kWakeUpTag = ~0ull;
+  constexpr static uint64_t kIgnoreTag = ~0ull - 1;
+  constexpr static unsigned kEntries = 1024;
+
+  const std::vector<Handle>& WatchIo(int64_t waitNs) override;
+  void HandleCqe(const struct io_uring_cqe& cqe);
+
+  void WakeUp() override;
+
+  void HandleWakeUp();
+
+  // whether the kernel has every opcode of IoOperation
+  bool ProbeOperations();
+
+  uint32_t NextGen();
+
+  void Listen(int fd, Direction dir, Handle handle, IoOperation* op);
+  void StopListening(int fd, Direction dir, Waiter& waiter);
+
+  void ArmPoll(int fd, Direction dir, uint32_t gen);
+  void CancelPoll(int fd, Direction dir, uint32_t gen);
+  void ArmOperation(int fd, Direction dir, uint32_t gen, IoOperation& op);
+  // the kernel may write to the buffers until the operation completed, so
+  // wait for its cqe. the result is kept if it completed before the cancel.
+  // the other cqes are reaped meanwhile into stashedCqes_
+  void CancelOperation(int fd, Direction dir, uint32_t gen, IoOperation& op);
+  void ArmWakeUp();
+
+  struct io_uring_sqe* GetSqe();
+  void Submit();
+  void SubmitAndWait(int64_t waitNs);
+
+  int ringFd_ = -1;
+  int wakeUpFd_ = -1;
+  uint32_t features_ = 0;
+  uint32_t nextGen_ = 1;
+  bool hasOperations_ = false;
+
+  // submission ring
+  void* sqRing_ = nullptr;
+  size_t sqRingSize_ = 0;
+  unsigned* sqHead_ = nullptr;
+  unsigned* sqTail_ = nullptr;
+  unsigned sqMask_ = 0;
+  unsigned sqEntries_ = 0;
+  unsigned* sqArray_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned sqeTail_ = 0;
+  unsigned toSubmit_ = 0;
+
+  // completion ring
+  void* cqRing_ = nullptr;
+  size_t cqRingSize_ = 0;
+  unsigned* cqHead_ = nullptr;
+  unsigned* cqTail_ = nullptr;
+  unsigned cqMask_ = 0;
+  struct io_uring_cqe* cqes_ = nullptr;
+
+  // cqes taken out of the ring by CancelOperation, handled by WatchIo
+  std::vector<struct io_uring_cqe> stashedCqes_;
+
+  IoEventTable<IoEvent> ioEvents_;
+  std::vector<Handle> activeCoroutines_;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_IOURINGWATCHER */
@@ -1,52 +1,136 @@
 #ifndef COLD_CORO_IOWATCHER
 #define COLD_CORO_IOWATCHER
 
-#include <sys/epoll.h>
+#include <sys/socket.h>
 
+#include <cassert>
 #include <coroutine>
-#include <map>
-#include <string>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Cold::Base {
 
+enum class IoBackend { kEpoll, kIoUring };
+
+// a socket operation done by the backend itself. the waiter is resumed with
+// the result instead of a readiness event, so it makes no syscall again.
+// see IoWatcher::SubmitOperation
+struct IoOperation {
+  enum Opcode : uint8_t {
+    kNone,
+    kRecv,
+    kSend,
+    kRecvMsg,
+    kSendMsg,
+    kAccept,
+    kConnect
+  };
+
+  bool IsRead() const {
+    return opcode == kRecv || opcode == kRecvMsg || opcode == kAccept;
+  }
+
+  Opcode opcode = kNone;
+  int flags = 0;
+  // kRecv, kSend: the buffer. kRecvMsg, kSendMsg: the msghdr. kAccept,
+  // kConnect: the sockaddr
+  void* addr = nullptr;
+  // kRecv, kSend: the buffer size. kConnect: the sockaddr length
+  size_t len = 0;
+  // kAccept: the sockaddr length
+  socklen_t* addrlen = nullptr;
+  // the syscall result, or -errno. set before the waiter is resumed
+  int result = 0;
+  // taken by the backend
+  bool submitted = false;
+  // result is set. may be set by StopListening*, when the operation
+  // completed before it could be canceled
+  bool completed = false;
+};
+
+// a waiter which is not a coroutine, e.g. an awaitable which must check the
+// state again before it resumes its coroutine. it lives in the awaitable, so
+// waiting costs no allocation. the backends take AsHandle() like any handle,
+// Wake calls OnReady instead of resuming it
+class IoWaker {
+ public:
+  virtual ~IoWaker() = default;
+
+  // resume handle, or call OnReady if it is a waker
+  static void Wake(std::coroutine_handle<> handle) {
+    auto address = reinterpret_cast<uintptr_t>(handle.address());
+    if (address & kTag) {
+      reinterpret_cast<IoWaker*>(address & ~kTag)->OnReady();
+      return;
+    }
+    assert(!handle.done());
+    handle.resume();
+  }
+
+ protected:
+  // never resumed, only told apart from a coroutine frame, which is not at
+  // an odd address
+  std::coroutine_handle<> AsHandle() {
+    return std::coroutine_handle<>::from_address(
+        reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(this) | kTag));
+  }
+
+  // called by the loop when the awaited event came
+  virtual void OnReady() = 0;
+
+ private:
+  constexpr static uintptr_t kTag = 1;
+};
+
+// io backend of IoService. reports readiness, and completes socket
+// operations itself if SupportsOperations().
+// all methods except WakeUp must be called in the IoService thread.
 class IoWatcher {
   friend class IoService;
 
  public:
   using Handle = std::coroutine_handle<>;
-  IoWatcher();
-  ~IoWatcher();
+  IoWatcher() = default;
+  virtual ~IoWatcher() = default;
 
   IoWatcher(const IoWatcher&) = delete;
   IoWatcher& operator=(const IoWatcher&) = delete;
 
-  void ListenReadEvent(int fd, Handle handle);
-  void ListenWriteEvent(int fd, Handle handle);
-  void StopListeningReadEvent(int fd);
-  void StopListeningWriteEvent(int fd);
-  void StopListeningAll(int fd);
+  // fallback to epoll when io_uring is not available
+  static std::unique_ptr<IoWatcher> Create(IoBackend backend);
 
- private:
-  struct IoEvent {
-    int fd = 0;
-    uint32_t events = 0;
-    Handle readHandle = std::noop_coroutine();
-    Handle writeHandle = std::noop_coroutine();
-    std::string Dump();
-  };
+  virtual IoBackend GetBackend() const = 0;
 
-  const std::vector<Handle>& WatchIo(int waitMs);
+  virtual void ListenReadEvent(int fd, Handle handle) = 0;
+  virtual void ListenWriteEvent(int fd, Handle handle) = 0;
+  virtual void StopListeningReadEvent(int fd) = 0;
+  virtual void StopListeningWriteEvent(int fd) = 0;
+  virtual void StopListeningAll(int fd) = 0;
 
-  void WakeUp();
+  // wait for an error event, e.g. an entry in the error queue of a socket.
+  // from then on the errors of fd wake only this waiter, the read and write
+  // waiters are woken by data, space and hangups. a noop handle only marks
+  // the fd
+  virtual void ListenErrorEvent(int fd, Handle handle) = 0;
+  virtual void StopListeningErrorEvent(int fd) = 0;
+  // whether ListenErrorEvent has marked fd
+  virtual bool UsesErrorQueue(int fd) = 0;
 
-  void HandleWakeUp();
+  // start op on fd and resume handle when it completed. op takes the place
+  // of a read (op.IsRead()) or write wait, and StopListening* cancels it.
+  // buffers of op must stay valid until then. always succeeds if
+  // SupportsOperations(), false otherwise: wait for readiness instead
+  virtual bool SubmitOperation(int fd, Handle handle, IoOperation& op) {
+    return false;
+  }
+  virtual bool SupportsOperations() const { return false; }
+
+ private:
+  // wait at most waitNs nanoseconds, forever if waitNs < 0
+  virtual const std::vector<Handle>& WatchIo(int64_t waitNs) = 0;
 
-  int epollFd_;
-  int wakeUpFd_;
-  std::vector<struct epoll_event> epollEvents_;
-  std::map<int, IoEvent> ioEvents_;
-  std::vector<Handle> activeCoroutines_;
+  virtual void WakeUp() = 0;
 };
 
 }  // namespace Cold::Base
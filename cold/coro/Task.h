@@ -6,6 +6,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "cold/coro/FramePool.h"
+
 namespace Cold::Base {
 
 template <typename T = void>
@@ -18,6 +20,12 @@ class PromiseBase {
   PromiseBase() noexcept = default;
   virtual ~PromiseBase() noexcept = default;
 
+  // coroutine frames come from the per thread frame pool
+  static void* operator new(size_t size) { return FramePool::Allocate(size); }
+  static void operator delete(void* ptr) noexcept {
+    FramePool::Deallocate(ptr);
+  }
+
   auto initial_suspend() noexcept { return std::suspend_always(); }
   auto final_suspend() noexcept { return FinalAwaitable(); }
   void unhandled_exception() noexcept { assert(false); }
@@ -111,6 +119,11 @@ class Task {
 
   std::coroutine_handle<> GetHandle() const { return handle_; }
 
+  // give up the ownership of the coroutine
+  std::coroutine_handle<promise_type> Release() noexcept {
+    return std::exchange(handle_, nullptr);
+  }
+
   auto operator co_await() const noexcept {
     assert(handle_);
     return TaskAwaitable(handle_);
@@ -0,0 +1,81 @@
+#include "cold/coro/WorkStealingScheduler.h"
+
+#include "cold/coro/IoService.h"
+
+using namespace Cold;
+
+Base::WorkStealingScheduler::WorkStealingScheduler(
+    std::vector<IoService*> services) {
+  for (auto service : services) {
+    auto worker = std::make_unique<Worker>();
+    worker->service = service;
+    workers_.push_back(std::move(worker));
+  }
+}
+
+void Base::WorkStealingScheduler::Push(Task<> task) {
+  assert(!workers_.empty());
+  size_t index = workers_.size();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    if (workers_[i]->service->InLoopThread()) {
+      index = i;
+      break;
+    }
+  }
+  if (index == workers_.size()) {
+    index = next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  }
+  auto& worker = *workers_[index];
+  {
+    LockGuard guard(worker.lock);
+    worker.tasks.push_back(std::move(task));
+    worker.size.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // an idle owner picks the task by itself. otherwise wake one idle worker
+  // to steal it
+  if (worker.service->IsPolling()) {
+    worker.service->Notify();
+    return;
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto service = workers_[(index + i) % workers_.size()]->service;
+    if (service->IsPolling()) {
+      service->Notify();
+      return;
+    }
+  }
+}
+
+bool Base::WorkStealingScheduler::Pop(size_t index, Task<>& task) {
+  auto& worker = *workers_[index];
+  if (worker.size.load(std::memory_order_relaxed) == 0) return false;
+  LockGuard guard(worker.lock);
+  if (worker.tasks.empty()) return false;
+  task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  worker.size.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool Base::WorkStealingScheduler::Steal(size_t thief, Task<>& task) {
+  size_t victim = thief;
+  size_t maxSize = 0;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    if (i == thief) continue;
+    auto size = workers_[i]->size.load(std::memory_order_relaxed);
+    if (size > maxSize) {
+      maxSize = size;
+      victim = i;
+    }
+  }
+  if (victim == thief) return false;
+  auto& worker = *workers_[victim];
+  LockGuard guard(worker.lock);
+  if (worker.tasks.empty()) return false;
+  task = std::move(worker.tasks.front());
+  worker.tasks.pop_front();
+  worker.size.fetch_sub(1, std::memory_order_relaxed);
+  steals_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
\ No newline at end of file
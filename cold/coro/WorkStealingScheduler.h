@@ -0,0 +1,63 @@
+#ifndef COLD_CORO_WORKSTEALINGSCHEDULER
+#define COLD_CORO_WORKSTEALINGSCHEDULER
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "cold/coro/Task.h"
+#include "cold/thread/Lock.h"
+
+namespace Cold::Base {
+
+class IoService;
+
+// per worker deques of runnable coroutines shared by the IoServices of a
+// pool. the owner pops from the back, idle workers steal from the front.
+// only tasks spawned through IoServicePool::CoSpawn live here. io
+// resumptions always happen in the IoService which owns the fd.
+class WorkStealingScheduler {
+ public:
+  explicit WorkStealingScheduler(std::vector<IoService*> services);
+  ~WorkStealingScheduler() = default;
+
+  WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+  WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+  // thread safe. push to the deque of the calling worker, or round robin
+  // when called outside of the pool
+  void Push(Task<> task);
+
+  // owner only
+  bool Pop(size_t index, Task<>& task);
+
+  // take one task from the busiest other worker
+  bool Steal(size_t thief, Task<>& task);
+
+  bool HasTask(size_t index) const {
+    return workers_[index]->size.load(std::memory_order_relaxed) > 0;
+  }
+
+  size_t GetNumWorkers() const { return workers_.size(); }
+
+  size_t GetStealCount() const {
+    return steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(64) Worker {
+    SpinLock lock;
+    std::deque<Task<>> tasks GUARDED_BY(lock);
+    std::atomic<size_t> size = 0;
+    IoService* service = nullptr;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_ = 0;
+  std::atomic<size_t> steals_ = 0;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_CORO_WORKSTEALINGSCHEDULER */
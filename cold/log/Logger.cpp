@@ -96,6 +96,10 @@ Base::LogManager::LogManager() {
     if (!loggerPattern.empty()) defaultSink->SetPattern(loggerPattern);
     mainLogger_ = std::make_shared<Logger>(std::move(name), defaultSink);
   }
+  if (config.Contains("/logs/loop-clock")) {
+    mainLogger_->SetUseLoopClock(
+        config.GetConfig("/logs/loop-clock").get<bool>());
+  }
   // set levels
   const char* arr[7] = {"trace", "debug", "info", "warn",
                         "error", "fatal", "off"};
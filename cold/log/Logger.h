@@ -7,6 +7,7 @@
 #include "cold/log/LogCommon.h"
 #include "cold/thread/Lock.h"
 #include "cold/thread/Thread.h"
+#include "cold/time/LoopClock.h"
 #include "cold/time/Time.h"
 
 namespace Cold::Base {
@@ -58,6 +59,11 @@ class Logger {
   LogLevel GetFlushLevel() const { return flushLevel_; }
   void SetFlushLevel(LogLevel level) { flushLevel_ = level; }
 
+  // stamp messages logged in an IoService thread with the cached loop time
+  // instead of reading the clock. the time may be behind by one iteration
+  bool IsUsingLoopClock() const { return useLoopClock_; }
+  void SetUseLoopClock(bool use) { useLoopClock_ = use; }
+
   void SetPattern(std::string_view pattern);
   void SetFormatter(LogFormatterPtr formatter);
 
@@ -73,7 +79,9 @@ class Logger {
     message.loggerName = name_;
     message.location = wrapper.location;
     message.baseName = wrapper.baseName;
-    message.logTime = Time::Now();
+    message.logTime = useLoopClock_.load(std::memory_order_relaxed)
+                          ? LoopClock::WallNow()
+                          : Time::Now();
     auto logLine = fmt::format(fmt, std::forward<Args>(args)...);
     message.logLine = logLine;
     SinkIt(message);
@@ -87,6 +95,7 @@ class Logger {
   std::string name_;
   std::atomic<LogLevel> loggerLevel_;
   std::atomic<LogLevel> flushLevel_;
+  std::atomic<bool> useLoopClock_ = false;
   std::vector<SinkPtr> loggerSinks_;
 };
 
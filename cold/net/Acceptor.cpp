@@ -1,6 +1,8 @@
 #include "cold/net/Acceptor.h"
 
 #include <fcntl.h>
+#include <linux/filter.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "cold/log/Logger.h"
@@ -33,6 +35,68 @@ Net::Acceptor::Acceptor(Base::IoService& service, const IpAddress& listenAddr,
   if (reusePort) {
     SetOption(SocketOptions::ReusePort(true));
   }
+  // accepted sockets inherit it
+  auto& config = Base::Config::GetGloablDefaultConfig();
+  if (config.Contains("/net/busy-poll-us")) {
+    auto busyPoll = config.GetConfig("/net/busy-poll-us").get<int>();
+    if (busyPoll > 0 && !SetOption(SocketOptions::BusyPoll(busyPoll))) {
+      Base::WARN("Cannot set SO_BUSY_POLL. reason: {}",
+                 Base::ThisThread::ErrorMsg());
+    }
+  }
+  if (config.Contains("/net/defer-accept-s")) {
+    auto defer = config.GetConfig("/net/defer-accept-s").get<int>();
+    if (defer > 0 && !SetDeferAccept(defer)) {
+      Base::WARN("Cannot set TCP_DEFER_ACCEPT. reason: {}",
+                 Base::ThisThread::ErrorMsg());
+    }
+  }
+  if (!Bind(listenAddr)) {
+    Base::FATAL("Cannot bind listen fd. errno: {}. reason: {}", errno,
+                Base::ThisThread::ErrorMsg());
+  }
+#ifndef COLD_NET_ENABLE_SSL
+  enableSSL_ = false;
+#else
+  if (enableSSL_ && !SSLContext::GetInstance().CertLoaded()) {
+    Base::FATAL("SSL Cert not loaded.");
+  }
+#endif
+}
+
+Net::Acceptor::Acceptor(Base::IoService& service,
+                        const UnixAddress& listenAddr, bool enableSSL)
+    : BasicSocket(service,
+                  socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                         0),
+                  false),
+      idleFd_(open("/dev/null", O_RDONLY | O_CLOEXEC)),
+      unixDomain_(true),
+      enableSSL_(enableSSL) {
+  assert(idleFd_ >= 0);
+  if (fd_ < 0) {
+    Base::FATAL("Cannot create listen fd. errno: {}. reason: {}", errno,
+                Base::ThisThread::ErrorMsg());
+  }
+  if (!listenAddr.IsAbstract()) {
+    unixPath_ = listenAddr.GetPath();
+    // left behind by a process which did not exit cleanly. a socket file
+    // which still accepts connections belongs to a live server
+    struct stat st;
+    if (stat(unixPath_.data(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+      int probe =
+          socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      const bool refused = probe >= 0 &&
+                           connect(probe, listenAddr.GetSockaddr(),
+                                   listenAddr.GetLength()) < 0 &&
+                           errno == ECONNREFUSED;
+      if (probe >= 0) close(probe);
+      if (!refused) {
+        Base::FATAL("Cannot bind listen fd. {} address in use", unixPath_);
+      }
+      unlink(unixPath_.data());
+    }
+  }
   if (!Bind(listenAddr)) {
     Base::FATAL("Cannot bind listen fd. errno: {}. reason: {}", errno,
                 Base::ThisThread::ErrorMsg());
@@ -46,19 +110,34 @@ Net::Acceptor::Acceptor(Base::IoService& service, const IpAddress& listenAddr,
 #endif
 }
 
-Net::Acceptor::~Acceptor() { close(idleFd_); }
+Net::Acceptor::~Acceptor() {
+  close(idleFd_);
+  if (fd_ >= 0 && !unixPath_.empty()) unlink(unixPath_.data());
+}
 
 Net::Acceptor::Acceptor(Acceptor&& other)
-    : BasicSocket(std::move(other)), idleFd_(other.idleFd_) {
+    : BasicSocket(std::move(other)),
+      idleFd_(other.idleFd_),
+      unixPath_(std::move(other.unixPath_)),
+      unixDomain_(other.unixDomain_),
+      listened_(other.listened_),
+      enableSSL_(other.enableSSL_) {
   other.idleFd_ = -1;
+  other.unixPath_.clear();
 }
 
 Net::Acceptor& Net::Acceptor::operator=(Acceptor&& other) {
   if (this == &other) return *this;
-  BasicSocket::operator=(std::move(other));
   if (idleFd_ >= 0) close(idleFd_);
+  if (fd_ >= 0 && !unixPath_.empty()) unlink(unixPath_.data());
+  BasicSocket::operator=(std::move(other));
   idleFd_ = other.idleFd_;
   other.idleFd_ = -1;
+  unixPath_ = std::move(other.unixPath_);
+  other.unixPath_.clear();
+  unixDomain_ = other.unixDomain_;
+  listened_ = other.listened_;
+  enableSSL_ = other.enableSSL_;
   return *this;
 }
 
@@ -110,26 +189,76 @@ Base::Task<SSL*> DoHandshake(Base::IoService* service, int& sockfd,
 #endif
 
 Base::Task<Net::TcpSocket> Net::Acceptor::Accept(Base::IoService& service) {
+  auto [sockfd, addr] = co_await AcceptFd();
+  co_return co_await MakeSocket(service, sockfd, std::move(addr));
+}
+
+Base::Task<std::pair<int, Net::IpAddress>> Net::Acceptor::AcceptFd() {
   assert(listened_);
   auto [sockfd, addr] = co_await AcceptAwaitable(ioService_, fd_);
+  if (sockfd < 0) HandleAcceptError();
+  co_return std::pair(sockfd, addr);
+}
+
+Base::Task<size_t> Net::Acceptor::AcceptFdBatch(
+    std::vector<std::pair<int, IpAddress>>& connections, size_t maxBatch) {
+  assert(listened_);
+  auto n = co_await AcceptBatchAwaitable(ioService_, fd_, connections,
+                                         maxBatch);
+  if (n == 0) HandleAcceptError();
+  co_return n;
+}
+
+Base::Task<std::vector<Net::TcpSocket>> Net::Acceptor::AcceptBatch(
+    size_t maxBatch) {
+  std::vector<std::pair<int, IpAddress>> connections;
+  std::vector<TcpSocket> sockets;
+  co_await AcceptFdBatch(connections, maxBatch);
+  for (auto& [sockfd, addr] : connections) {
+    auto socket = co_await MakeSocket(*ioService_, sockfd, addr);
+    if (socket) sockets.push_back(std::move(socket));
+  }
+  co_return sockets;
+}
+
+void Net::Acceptor::HandleAcceptError() {
+  if (errno == EMFILE) {
+    close(idleFd_);
+    idleFd_ = accept(fd_, nullptr, nullptr);
+    close(idleFd_);
+    idleFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  } else if (errno != EAGAIN) {
+    Base::ERROR("Accept Error. errno: {}, reason: {}", errno,
+                Base::ThisThread::ErrorMsg());
+  }
+}
+
+bool Net::Acceptor::SetDeferAccept(int seconds) {
+  return SetOption(SocketOptions::TcpDeferAccept(seconds));
+}
+
+Base::Task<Net::TcpSocket> Net::Acceptor::MakeSocket(Base::IoService& service,
+                                                     int sockfd,
+                                                     IpAddress addr) {
+  // the peer of an AF_UNIX socket has no ip address
+  if (unixDomain_) addr = IpAddress();
 #ifdef COLD_NET_ENABLE_SSL
   if (enableSSL_ && sockfd >= 0) {
     auto ssl = co_await DoHandshake(&service, sockfd, addr);
     co_return Net::TcpSocket(service, localAddress_, addr, sockfd, ssl);
   }
 #endif
-  if (sockfd < 0) {
-    if (errno == EMFILE) {
-      close(idleFd_);
-      idleFd_ = accept(fd_, nullptr, nullptr);
-      close(idleFd_);
-      idleFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
-    } else {
-      Base::ERROR("Accept Error. errno: {}, reason: {}", errno,
-                  Base::ThisThread::ErrorMsg());
-    }
+  Net::TcpSocket socket(service, localAddress_, addr, sockfd);
+  // zero copy sends of at least this many bytes. 0 turns it off
+  static size_t zeroCopyThreshold =
+      Base::Config::GetGloablDefaultConfig().GetOrDefault<size_t>(
+          "/net/zerocopy-threshold", 0);
+  if (sockfd >= 0 && zeroCopyThreshold > 0 && !unixDomain_ &&
+      !socket.EnableZeroCopy(zeroCopyThreshold)) {
+    Base::WARN("Cannot enable zero copy. reason: {}",
+               Base::ThisThread::ErrorMsg());
   }
-  co_return Net::TcpSocket(service, localAddress_, addr, sockfd);
+  co_return socket;
 }
 
 void Net::Acceptor::Listen() {
@@ -140,3 +269,19 @@ void Net::Acceptor::Listen() {
   listened_ = true;
   ioService_->ListenReadEvent(fd_, std::noop_coroutine());
 }
+
+bool Net::Acceptor::AttachReusePortCpuProgram(size_t groupSize) {
+  assert(groupSize > 0);
+  // A = cpu; A %= groupSize; return A
+  struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+               static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)),
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(groupSize)),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  struct sock_fprog program;
+  program.len = sizeof code / sizeof code[0];
+  program.filter = code;
+  return setsockopt(fd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program,
+                    sizeof program) == 0;
+}
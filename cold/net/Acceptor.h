@@ -1,6 +1,10 @@
 #ifndef COLD_NET_ACCEPTOR
 #define COLD_NET_ACCEPTOR
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "cold/coro/IoService.h"
 #include "cold/net/BasicSocket.h"
 
@@ -12,6 +16,13 @@ class Acceptor : public BasicSocket {
   Acceptor(Base::IoService& service, const IpAddress& listenAddr,
            bool reusePort, bool enableSSL = false);
 
+  // listen on an AF_UNIX stream socket. a stale socket file at the path is
+  // removed first, and the file is removed again with the acceptor. the
+  // accepted TcpSockets have no ip addresses, see UnixStreamSocket for the
+  // operations only AF_UNIX has
+  Acceptor(Base::IoService& service, const UnixAddress& listenAddr,
+           bool enableSSL = false);
+
   ~Acceptor() override;
 
   Acceptor(Acceptor&&);
@@ -21,11 +32,49 @@ class Acceptor : public BasicSocket {
 
   bool GetListened() const { return listened_; }
 
+  // attach a cbpf program to the SO_REUSEPORT group of the socket. a new
+  // connection goes to the listener of index cpu % groupSize, the cpu
+  // which received the SYN. the index is the order of Listen in the group
+  bool AttachReusePortCpuProgram(size_t groupSize);
+
   Base::Task<TcpSocket> Accept();
   Base::Task<TcpSocket> Accept(Base::IoService& service);
 
+  // accept a connection without creating its socket, so the caller can
+  // choose the IoService by the fd. sockfd < 0 on error
+  Base::Task<std::pair<int, IpAddress>> AcceptFd();
+
+  // create the socket of an accepted fd in service, with the ssl handshake
+  // if enabled. run it in the thread of service
+  Base::Task<TcpSocket> MakeSocket(Base::IoService& service, int sockfd,
+                                   IpAddress addr);
+
+  // take every pending connection, up to maxBatch, in one co_await.
+  // connections is reused by the caller to avoid allocation
+  Base::Task<size_t> AcceptFdBatch(
+      std::vector<std::pair<int, IpAddress>>& connections,
+      size_t maxBatch = kDefaultAcceptBatch);
+
+  // AcceptFdBatch then MakeSocket in the acceptor's IoService. the ssl
+  // handshakes run one after another, a server should rather hand each fd
+  // to MakeSocket in its own coroutine as TcpServer does
+  Base::Task<std::vector<TcpSocket>> AcceptBatch(
+      size_t maxBatch = kDefaultAcceptBatch);
+
+  // only surface a connection once its first data arrived, or after
+  // seconds. for protocols where the client speaks first
+  bool SetDeferAccept(int seconds);
+
+  constexpr static size_t kDefaultAcceptBatch = 64;
+
  private:
+  // EMFILE: close the idle fd to accept and drop the connection
+  void HandleAcceptError();
+
   int idleFd_;
+  // the file to remove, empty for the abstract namespace and ip sockets
+  std::string unixPath_;
+  bool unixDomain_ = false;
   bool listened_ = false;
   bool enableSSL_ = false;
 };
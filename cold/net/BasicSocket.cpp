@@ -40,7 +40,8 @@ Net::BasicSocket::BasicSocket(BasicSocket&& other)
       localAddress_(other.localAddress_),
       remoteAddress_(other.remoteAddress_),
       connected_(other.connected_.load()),
-      ssl_(other.ssl_) {
+      ssl_(other.ssl_),
+      enableSSL_(other.enableSSL_) {
   other.ioService_ = nullptr;
   other.fd_ = -1;
   other.connected_ = false;
@@ -49,9 +50,14 @@ Net::BasicSocket::BasicSocket(BasicSocket&& other)
 
 Net::BasicSocket& Net::BasicSocket::operator=(BasicSocket&& other) {
   if (this == &other) return *this;
+  if (ssl_) {
+#ifdef COLD_NET_ENABLE_SSL
+    SSL_free(ssl_);
+#endif
+  }
   if (fd_ >= 0) {
+    ioService_->StopListeningAll(fd_);
     close(fd_);
-    ioService_->StopListeningAll(other.fd_);
   }
   ioService_ = other.ioService_;
   fd_ = other.fd_;
@@ -59,6 +65,7 @@ Net::BasicSocket& Net::BasicSocket::operator=(BasicSocket&& other) {
   remoteAddress_ = other.remoteAddress_;
   connected_ = other.connected_.load();
   ssl_ = other.ssl_;
+  enableSSL_ = other.enableSSL_;
   other.ioService_ = nullptr;
   other.fd_ = -1;
   other.connected_ = false;
@@ -78,6 +85,11 @@ bool Net::BasicSocket::Bind(IpAddress address) {
   return false;
 }
 
+bool Net::BasicSocket::Bind(const UnixAddress& address) {
+  assert(IsValid());
+  return bind(fd_, address.GetSockaddr(), address.GetLength()) == 0;
+}
+
 void Net::BasicSocket::ShutDown() {
 #ifdef COLD_NET_ENABLE_SSL
   if (ssl_) SSL_shutdown(ssl_);
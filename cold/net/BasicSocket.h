@@ -7,6 +7,7 @@
 
 #include "cold/net/IoAwaitable.h"
 #include "cold/net/IpAddress.h"
+#include "cold/net/UnixAddress.h"
 
 #ifdef COLD_NET_ENABLE_SSL
 #include "cold/net/ssl/SSLContext.h"
@@ -71,6 +72,8 @@ class BasicSocket {
   void SetRemoteAddress(const IpAddress& addr) { remoteAddress_ = addr; }
 
   bool Bind(IpAddress address);
+  // the local address of an AF_UNIX socket is not recorded
+  bool Bind(const UnixAddress& address);
   void ShutDown();
 
   virtual void Close();
@@ -96,11 +99,25 @@ class BasicSocket {
     return WriteAwaitable(ioService_, fd_, buf, count, connected_, ssl_);
   }
 
+  // iov must stay valid until the returned awaitable completes
+  [[nodiscard]] auto ReadV(const struct iovec* iov, int iovcnt) {
+    return ReadVAwaitable(ioService_, fd_, iov, iovcnt, connected_, ssl_);
+  }
+
+  [[nodiscard]] auto WriteV(const struct iovec* iov, int iovcnt) {
+    return WriteVAwaitable(ioService_, fd_, iov, iovcnt, connected_, ssl_);
+  }
+
   [[nodiscard]] auto Connect(const IpAddress& address) {
     return ConnectAwaitable(ioService_, fd_, address, &connected_,
                             &localAddress_, &remoteAddress_);
   }
 
+  [[nodiscard]] auto Connect(const UnixAddress& address) {
+    return ConnectAwaitable(ioService_, fd_, address.GetSockaddr(),
+                            address.GetLength(), &connected_);
+  }
+
   template <typename REP, typename PERIOD>
   [[nodiscard]] auto ReadWithTimeout(
       void* buf, size_t count, std::chrono::duration<REP, PERIOD> duration) {
@@ -114,6 +131,20 @@ class BasicSocket {
     return IoTimeoutAwaitable(ioService_, Write(buf, count), duration);
   }
 
+  template <typename REP, typename PERIOD>
+  [[nodiscard]] auto ReadVWithTimeout(
+      const struct iovec* iov, int iovcnt,
+      std::chrono::duration<REP, PERIOD> duration) {
+    return IoTimeoutAwaitable(ioService_, ReadV(iov, iovcnt), duration);
+  }
+
+  template <typename REP, typename PERIOD>
+  [[nodiscard]] auto WriteVWithTimeout(
+      const struct iovec* iov, int iovcnt,
+      std::chrono::duration<REP, PERIOD> duration) {
+    return IoTimeoutAwaitable(ioService_, WriteV(iov, iovcnt), duration);
+  }
+
   template <typename REP, typename PERIOD>
   [[nodiscard]] auto ConnectWithTimeout(
       const IpAddress& remoteAddress,
@@ -121,6 +152,13 @@ class BasicSocket {
     return IoTimeoutAwaitable(ioService_, Connect(remoteAddress), duration);
   }
 
+  template <typename REP, typename PERIOD>
+  [[nodiscard]] auto ConnectWithTimeout(
+      const UnixAddress& remoteAddress,
+      std::chrono::duration<REP, PERIOD> duration) {
+    return IoTimeoutAwaitable(ioService_, Connect(remoteAddress), duration);
+  }
+
   bool IsEnableSSL() const { return enableSSL_; }
 
  protected:
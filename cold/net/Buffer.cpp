@@ -0,0 +1,108 @@
+#include "cold/net/Buffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <new>
+
+using namespace Cold;
+
+namespace {
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+constexpr int kMinShift = std::countr_zero(Net::BufferPool::kMinBlockSize);
+constexpr size_t kNumClasses =
+    static_cast<size_t>(
+        std::countr_zero(Net::BufferPool::kMaxPooledBlockSize) - kMinShift) +
+    1;
+
+struct ThreadCache {
+  ThreadCache() = default;
+  ~ThreadCache();
+
+  FreeBlock* freeLists[kNumClasses] = {};
+  size_t counts[kNumClasses] = {};
+  Net::BufferPool::Stats stats;
+};
+
+// trivially destructible, so blocks freed during thread exit after the
+// cache is gone go straight to the heap
+thread_local bool t_cacheDestroyed = false;
+thread_local ThreadCache t_cache;
+
+ThreadCache::~ThreadCache() {
+  for (auto& list : freeLists) {
+    while (list) {
+      auto next = list->next;
+      std::free(list);
+      list = next;
+    }
+  }
+  t_cacheDestroyed = true;
+}
+
+size_t SizeClassOf(size_t size) {
+  return static_cast<size_t>(std::countr_zero(size) - kMinShift);
+}
+
+}  // namespace
+
+char* Net::BufferPool::Allocate(size_t& size) {
+  size = std::bit_ceil(std::max(size, kMinBlockSize));
+  if (size <= kMaxPooledBlockSize && !t_cacheDestroyed) {
+    auto& cache = t_cache;
+    auto sizeClass = SizeClassOf(size);
+    if (auto block = cache.freeLists[sizeClass]) {
+      cache.freeLists[sizeClass] = block->next;
+      --cache.counts[sizeClass];
+      ++cache.stats.recycled;
+      return reinterpret_cast<char*>(block);
+    }
+    ++cache.stats.allocated;
+  }
+  auto block = static_cast<char*>(std::malloc(size));
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+
+void Net::BufferPool::Deallocate(char* block, size_t size) noexcept {
+  if (size <= kMaxPooledBlockSize && !t_cacheDestroyed) {
+    auto& cache = t_cache;
+    auto sizeClass = SizeClassOf(size);
+    if (cache.counts[sizeClass] < kMaxCachedPerClass) {
+      auto freeBlock = reinterpret_cast<FreeBlock*>(block);
+      freeBlock->next = cache.freeLists[sizeClass];
+      cache.freeLists[sizeClass] = freeBlock;
+      ++cache.counts[sizeClass];
+      return;
+    }
+  }
+  std::free(block);
+}
+
+const Net::BufferPool::Stats& Net::BufferPool::ThisThreadStats() {
+  return t_cache.stats;
+}
+
+void Net::Buffer::MakeSpace(size_t n) {
+  auto readable = ReadableBytes();
+  // slide to the front if that frees enough room and the bytes to move are
+  // few compared with the block
+  if (readIndex_ + WritableBytes() >= n && readable <= capacity_ / 2) {
+    memmove(data_, data_ + readIndex_, readable);
+    readIndex_ = 0;
+    writeIndex_ = readable;
+    return;
+  }
+  size_t size = std::max(readable + n, capacity_ * 2);
+  auto block = BufferPool::Allocate(size);
+  if (readable) memcpy(block, data_ + readIndex_, readable);
+  if (data_) BufferPool::Deallocate(data_, capacity_);
+  data_ = block;
+  capacity_ = size;
+  readIndex_ = 0;
+  writeIndex_ = readable;
+}
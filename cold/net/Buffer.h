@@ -0,0 +1,148 @@
+#ifndef COLD_NET_BUFFER
+#define COLD_NET_BUFFER
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace Cold::Net {
+
+// allocator of buffer blocks. blocks are powers of two between
+// kMinBlockSize and kMaxPooledBlockSize and every thread caches freed blocks
+// in one free list per size. bigger blocks always use the global heap.
+class BufferPool {
+ public:
+  struct Stats {
+    // blocks taken from the global heap
+    uint64_t allocated = 0;
+    // blocks served from the free lists
+    uint64_t recycled = 0;
+  };
+
+  constexpr static size_t kMinBlockSize = 4096;
+  constexpr static size_t kMaxPooledBlockSize = 1 << 20;
+  // max blocks cached per size and thread
+  constexpr static size_t kMaxCachedPerClass = 32;
+
+  // size is rounded up to the size of the returned block
+  static char* Allocate(size_t& size);
+  static void Deallocate(char* block, size_t size) noexcept;
+
+  // stats of the calling thread
+  static const Stats& ThisThreadStats();
+};
+
+// contiguous byte buffer with a read and a write index, backed by pooled
+// blocks. readable bytes are [Peek(), Peek() + ReadableBytes()) and new
+// bytes go to BeginWrite() followed by Commit. readable bytes are moved to
+// the front only when the tail has no room, and never more than once per
+// growth, so consuming from the front costs nothing.
+class Buffer {
+ public:
+  Buffer() = default;
+  ~Buffer() { Release(); }
+
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+
+  Buffer(Buffer&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        readIndex_(std::exchange(other.readIndex_, 0)),
+        writeIndex_(std::exchange(other.writeIndex_, 0)) {}
+
+  Buffer& operator=(Buffer&& other) noexcept {
+    if (this == &other) return *this;
+    Release();
+    data_ = std::exchange(other.data_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+    readIndex_ = std::exchange(other.readIndex_, 0);
+    writeIndex_ = std::exchange(other.writeIndex_, 0);
+    return *this;
+  }
+
+  size_t ReadableBytes() const { return writeIndex_ - readIndex_; }
+  size_t WritableBytes() const { return capacity_ - writeIndex_; }
+  size_t Capacity() const { return capacity_; }
+  bool Empty() const { return readIndex_ == writeIndex_; }
+
+  const char* Peek() const { return data_ + readIndex_; }
+  std::string_view View() const { return {Peek(), ReadableBytes()}; }
+
+  // offset of the first delim in the readable bytes at or after from,
+  // npos if there is none
+  size_t Find(std::string_view delim, size_t from = 0) const {
+    return View().find(delim, from);
+  }
+
+  void Consume(size_t n) {
+    assert(n <= ReadableBytes());
+    readIndex_ += n;
+    if (readIndex_ == writeIndex_) readIndex_ = writeIndex_ = 0;
+  }
+
+  void ConsumeAll() { readIndex_ = writeIndex_ = 0; }
+
+  std::string Retrieve(size_t n) {
+    std::string result(Peek(), n);
+    Consume(n);
+    return result;
+  }
+
+  // make room for at least n more bytes
+  void EnsureWritable(size_t n) {
+    if (WritableBytes() < n) MakeSpace(n);
+  }
+
+  char* BeginWrite() { return data_ + writeIndex_; }
+
+  // n bytes have been written at BeginWrite
+  void Commit(size_t n) {
+    assert(n <= WritableBytes());
+    writeIndex_ += n;
+  }
+
+  void Append(const void* data, size_t len) {
+    if (len == 0) return;
+    EnsureWritable(len);
+    memcpy(BeginWrite(), data, len);
+    Commit(len);
+  }
+
+  void Append(std::string_view data) { Append(data.data(), data.size()); }
+
+  // give the block back to the pool if the buffer is empty and the block is
+  // bigger than keep. a buffer that sits idle then pins at most keep bytes
+  void Shrink(size_t keep = 0) {
+    if (Empty() && capacity_ > keep) Release();
+  }
+
+  void Swap(Buffer& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(readIndex_, other.readIndex_);
+    std::swap(writeIndex_, other.writeIndex_);
+  }
+
+ private:
+  void MakeSpace(size_t n);
+
+  void Release() noexcept {
+    if (data_) BufferPool::Deallocate(data_, capacity_);
+    data_ = nullptr;
+    capacity_ = readIndex_ = writeIndex_ = 0;
+  }
+
+  char* data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t readIndex_ = 0;
+  size_t writeIndex_ = 0;
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_BUFFER */
@@ -0,0 +1,189 @@
+#ifndef COLD_NET_BUFFEREDSOCKET
+#define COLD_NET_BUFFEREDSOCKET
+
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "cold/coro/Task.h"
+#include "cold/net/Buffer.h"
+#include "cold/net/TcpSocket.h"
+
+namespace Cold::Net {
+
+// buffered reader and writer on top of a TcpSocket. the socket is borrowed
+// and must outlive this object.
+// reads land in a pooled read buffer which protocols scan in place with
+// Peek/Find and drop with Consume. once the buffered bytes are consumed the
+// block shrinks back to kIdleBlockSize, so an idle connection pins at most
+// one small block.
+// writes are copied into a pooled write buffer and go out in one write when
+// Flush is called or the buffer reaches the flush threshold, so small
+// writes like headers and a short body leave as one segment.
+class BufferedSocket {
+ public:
+  constexpr static size_t kIdleBlockSize = BufferPool::kMinBlockSize;
+  // read buffers with less room than this grow before the next read
+  constexpr static size_t kMinReadSize = 1024;
+  constexpr static size_t kGrowSize = 16 * 1024;
+  constexpr static size_t kDefaultFlushThreshold = 16 * 1024;
+
+  explicit BufferedSocket(TcpSocket& socket,
+                          size_t flushThreshold = kDefaultFlushThreshold)
+      : socket_(&socket), flushThreshold_(flushThreshold) {}
+
+  ~BufferedSocket() = default;
+
+  BufferedSocket(const BufferedSocket&) = delete;
+  BufferedSocket& operator=(const BufferedSocket&) = delete;
+
+  TcpSocket& GetSocket() const { return *socket_; }
+  Buffer& GetReadBuffer() { return readBuffer_; }
+  Buffer& GetWriteBuffer() { return writeBuffer_; }
+
+  // timeout of every single read or write. zero means no timeout
+  void SetReadTimeout(std::chrono::milliseconds timeout) {
+    readTimeout_ = timeout;
+  }
+
+  void SetWriteTimeout(std::chrono::milliseconds timeout) {
+    writeTimeout_ = timeout;
+  }
+
+  std::string_view Peek() const { return readBuffer_.View(); }
+  size_t ReadableBytes() const { return readBuffer_.ReadableBytes(); }
+  void Consume(size_t n) { readBuffer_.Consume(n); }
+
+  // read once from the socket and append to the read buffer. return the
+  // bytes read, 0 on eof, -1 on error or timeout. target is the number of
+  // buffered bytes the caller waits for, the buffer makes room for all of
+  // them in one allocation
+  [[nodiscard]] Base::Task<ssize_t> Fill(size_t target = 0) {
+    auto readable = readBuffer_.ReadableBytes();
+    if (readable == 0 && !lastReadFull_ && target <= kIdleBlockSize) {
+      readBuffer_.Shrink(kIdleBlockSize);
+    }
+    if (readable < target) readBuffer_.EnsureWritable(target - readable);
+    if (readBuffer_.WritableBytes() < kMinReadSize) {
+      readBuffer_.EnsureWritable(readBuffer_.Empty() ? kIdleBlockSize
+                                                     : kGrowSize);
+    }
+    auto buf = readBuffer_.BeginWrite();
+    auto len = readBuffer_.WritableBytes();
+    ssize_t n = 0;
+    if (readTimeout_.count() > 0) {
+      n = co_await socket_->ReadWithTimeout(buf, len, readTimeout_);
+    } else {
+      n = co_await socket_->Read(buf, len);
+    }
+    if (n > 0) readBuffer_.Commit(static_cast<size_t>(n));
+    // a full read means more is on the way. keep the block for it
+    lastReadFull_ = n == static_cast<ssize_t>(len);
+    co_return n;
+  }
+
+  // read until delim is buffered. return the length of the buffered bytes
+  // up to and including the first delim, 0 on eof, -1 on error or timeout.
+  // fail with EMSGSIZE when maxBytes are buffered without a delim
+  [[nodiscard]] Base::Task<ssize_t> ReadUntil(std::string_view delim,
+                                              size_t maxBytes = SIZE_MAX) {
+    size_t from = 0;
+    while (true) {
+      auto pos = readBuffer_.Find(delim, from);
+      if (pos != std::string_view::npos) {
+        co_return static_cast<ssize_t>(pos + delim.size());
+      }
+      auto readable = readBuffer_.ReadableBytes();
+      if (readable >= maxBytes) {
+        errno = EMSGSIZE;
+        co_return -1;
+      }
+      // the delim may straddle the old and the new bytes
+      from = readable >= delim.size() ? readable - delim.size() + 1 : 0;
+      auto n = co_await Fill();
+      if (n <= 0) co_return n;
+    }
+  }
+
+  // read until at least n bytes are buffered. return n, 0 on eof, -1 on
+  // error or timeout
+  [[nodiscard]] Base::Task<ssize_t> ReadExactly(size_t n) {
+    while (readBuffer_.ReadableBytes() < n) {
+      auto ret = co_await Fill(n);
+      if (ret <= 0) co_return ret;
+    }
+    co_return static_cast<ssize_t>(n);
+  }
+
+  // buffer len bytes. flush when the buffer reaches the flush threshold.
+  // data larger than the threshold skips the buffer and leaves with the
+  // buffered bytes in one writev. return false if a write fails
+  [[nodiscard]] Base::Task<bool> Write(const void* data, size_t len) {
+    if (writeBuffer_.ReadableBytes() + len < flushThreshold_) {
+      writeBuffer_.Append(data, len);
+      co_return true;
+    }
+    if (len < flushThreshold_) {
+      writeBuffer_.Append(data, len);
+      co_return co_await Flush();
+    }
+    // the buffered bytes and data leave in one writev
+    struct iovec iov[2] = {
+        {const_cast<char*>(writeBuffer_.Peek()), writeBuffer_.ReadableBytes()},
+        {const_cast<void*>(data), len}};
+    auto ok = co_await WriteVDirect(iov, 2);
+    writeBuffer_.ConsumeAll();
+    writeBuffer_.Shrink();
+    co_return ok;
+  }
+
+  [[nodiscard]] Base::Task<bool> Write(std::string_view data) {
+    return Write(data.data(), data.size());
+  }
+
+  // write out all buffered bytes and give the write block back
+  [[nodiscard]] Base::Task<bool> Flush() {
+    if (writeBuffer_.Empty()) co_return true;
+    auto ok = co_await WriteDirect(writeBuffer_.Peek(),
+                                   writeBuffer_.ReadableBytes());
+    writeBuffer_.ConsumeAll();
+    writeBuffer_.Shrink();
+    co_return ok;
+  }
+
+ private:
+  Base::Task<bool> WriteDirect(const char* data, size_t len) {
+    ssize_t n = 0;
+    if (writeTimeout_.count() > 0) {
+      n = co_await socket_->WriteNWithTimeout(data, len, writeTimeout_);
+    } else {
+      n = co_await socket_->WriteN(data, len);
+    }
+    co_return n == static_cast<ssize_t>(len);
+  }
+
+  Base::Task<bool> WriteVDirect(const struct iovec* iov, int iovcnt) {
+    ssize_t n = 0;
+    if (writeTimeout_.count() > 0) {
+      n = co_await socket_->WriteVNWithTimeout(iov, iovcnt, writeTimeout_);
+    } else {
+      n = co_await socket_->WriteVN(iov, iovcnt);
+    }
+    co_return n >= 0;
+  }
+
+  TcpSocket* socket_;
+  size_t flushThreshold_;
+  std::chrono::milliseconds readTimeout_{0};
+  std::chrono::milliseconds writeTimeout_{0};
+  bool lastReadFull_ = false;
+  Buffer readBuffer_;
+  Buffer writeBuffer_;
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_BUFFEREDSOCKET */
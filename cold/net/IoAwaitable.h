@@ -1,7 +1,21 @@
 #ifndef COLD_NET_IOAWAITABLE
 #define COLD_NET_IOAWAITABLE
 
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 #include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "cold/coro/Io.h"
 #include "cold/net/IpAddress.h"
@@ -16,6 +30,7 @@ class SSL;
 namespace Cold::Net {
 
 using Base::IoAwaitableBase;
+using Base::IoOperation;
 using Base::IoTimeoutAwaitable;
 
 #ifdef COLD_NET_ENABLE_SSL
@@ -61,7 +76,10 @@ class SSLReadAwaitable : public IoAwaitableBase {
 };
 #endif
 
-class ReadAwaitable : public IoAwaitableBase {
+// on a tls socket a readable fd may not hold a whole record yet. the
+// awaitable then waits again as a waker, and resumes the coroutine only when
+// SSL_read is done
+class ReadAwaitable : public IoAwaitableBase, public Base::IoWaker {
  public:
   ReadAwaitable(Base::IoService* service, int fd, void* buf, size_t count,
                 std::atomic<bool>& connected, SSL* ssl)
@@ -69,64 +87,74 @@ class ReadAwaitable : public IoAwaitableBase {
         buf_(buf),
         count_(count),
         connected_(connected),
-        ssl_(ssl),
-        states_(std::make_shared<std::pair<ssize_t, bool>>(0, false)) {
+        ssl_(ssl) {
     (void)ssl_;
   }
   ~ReadAwaitable() override = default;
 
+  ReadAwaitable(ReadAwaitable&&) = default;
+
   bool await_ready() noexcept {
     if (!connected_) return true;
-    if (ssl_) return false;
-    states_->first = read(fd_, buf_, count_);
-    if (states_->first >= 0 || errno != EAGAIN) ready_ = true;
+    if (ssl_) return SSLRead();
+    retValue_ = read(fd_, buf_, count_);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    op_.opcode = IoOperation::kRecv;
+    op_.addr = buf_;
+    op_.len = count_;
     return ready_;
   }
 
   void await_suspend(std::coroutine_handle<> handle) noexcept {
     if (!ssl_) {
       IoAwaitableBase::await_suspend(handle);
-    } else {
-#ifdef COLD_NET_ENABLE_SSL
-      service_->CoSpawn(
-          [](std::coroutine_handle<> h, Base::IoService* service, SSL* ssl,
-             void* buf, size_t count, const std::atomic<bool>& connected,
-             std::shared_ptr<std::pair<ssize_t, bool>> states) -> Base::Task<> {
-            while (!states->second) {
-              states->first = co_await SSLReadAwaitable(service, ssl, buf,
-                                                        count, connected);
-              if (states->first == -1 &&
-                  SSL_get_error(ssl, static_cast<int>(states->first)) ==
-                      SSL_ERROR_WANT_READ) {
-                states->first = 0;
-                continue;
-              }
-              break;
-            }
-            if (!states->second) h.resume();
-          }(handle, service_, ssl_, buf_, count_, connected_, states_));
-#endif
+      return;
     }
+    handle_ = handle;
+    IoAwaitableBase::await_suspend(AsHandle());
   }
 
   ssize_t await_resume() noexcept {
-    states_->second = true;
     if (!connected_ || GetTimeout()) {
       errno = GetTimeout() ? ETIMEDOUT : ENOTCONN;
       return -1;
     }
-    if (!ssl_ && !ready_) states_->first = read(fd_, buf_, count_);
-    return states_->first;
+    if (!ssl_ && !ready_) {
+      retValue_ =
+          op_.submitted ? GetOperationResult() : read(fd_, buf_, count_);
+    }
+    return retValue_;
   }
 
  private:
+  void OnReady() override {
+    if (!connected_ || SSLRead()) {
+      handle_.resume();
+      return;
+    }
+    ListenIo(AsHandle());
+  }
+
+  // false if SSL_read wants more bytes
+  bool SSLRead() {
+#ifdef COLD_NET_ENABLE_SSL
+    retValue_ = SSL_read(ssl_, buf_, static_cast<int>(count_));
+    return retValue_ >= 0 ||
+           SSL_get_error(ssl_, static_cast<int>(retValue_)) !=
+               SSL_ERROR_WANT_READ;
+#else
+    return true;
+#endif
+  }
+
   void* buf_;
   size_t count_;
   bool ready_ = false;
+  ssize_t retValue_ = 0;
   const std::atomic<bool>& connected_;
   SSL* ssl_;
-  // first retValue second alreadyResume
-  std::shared_ptr<std::pair<ssize_t, bool>> states_;
+  // resumed by OnReady
+  std::coroutine_handle<> handle_;
 };
 
 class WriteAwaitable : public IoAwaitableBase {
@@ -159,6 +187,9 @@ class WriteAwaitable : public IoAwaitableBase {
 #endif
     retValue_ = write(fd_, buf_, count_);
     if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    op_.opcode = IoOperation::kSend;
+    op_.addr = const_cast<void*>(buf_);
+    op_.len = count_;
     return ready_;
   }
 
@@ -173,6 +204,7 @@ class WriteAwaitable : public IoAwaitableBase {
       return SSL_write(ssl_, buf_, static_cast<int>(count_));
     }
 #endif
+    if (op_.submitted) return GetOperationResult();
     return write(fd_, buf_, count_);
   }
 
@@ -185,6 +217,317 @@ class WriteAwaitable : public IoAwaitableBase {
   SSL* ssl_;
 };
 
+// scatter read. on a tls socket a record is decrypted into the first non
+// empty buffer and bytes already decrypted fill the following ones. it waits
+// for a whole record like ReadAwaitable
+class ReadVAwaitable : public IoAwaitableBase, public Base::IoWaker {
+ public:
+  ReadVAwaitable(Base::IoService* service, int fd, const struct iovec* iov,
+                 int iovcnt, std::atomic<bool>& connected, SSL* ssl)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kREAD),
+        iov_(iov),
+        iovcnt_(iovcnt),
+        connected_(connected),
+        ssl_(ssl) {
+    (void)ssl_;
+  }
+  ~ReadVAwaitable() override = default;
+
+  ReadVAwaitable(ReadVAwaitable&&) = default;
+
+  bool await_ready() noexcept {
+    if (!connected_) return true;
+    if (ssl_) return SSLRead();
+    retValue_ = readv(fd_, iov_, iovcnt_);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    msg_ = {};
+    msg_.msg_iov = const_cast<struct iovec*>(iov_);
+    msg_.msg_iovlen = static_cast<size_t>(iovcnt_);
+    op_.opcode = IoOperation::kRecvMsg;
+    op_.addr = &msg_;
+    return ready_;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) noexcept {
+    if (!ssl_) {
+      IoAwaitableBase::await_suspend(handle);
+      return;
+    }
+    handle_ = handle;
+    IoAwaitableBase::await_suspend(AsHandle());
+  }
+
+  ssize_t await_resume() noexcept {
+    if (!connected_ || GetTimeout()) {
+      errno = GetTimeout() ? ETIMEDOUT : ENOTCONN;
+      return -1;
+    }
+    if (!ssl_ && !ready_) {
+      retValue_ =
+          op_.submitted ? GetOperationResult() : readv(fd_, iov_, iovcnt_);
+    }
+    return retValue_;
+  }
+
+ private:
+  void OnReady() override {
+    if (!connected_ || SSLRead()) {
+      handle_.resume();
+      return;
+    }
+    ListenIo(AsHandle());
+  }
+
+  // false if SSL_read wants more bytes
+  bool SSLRead() {
+#ifdef COLD_NET_ENABLE_SSL
+    int i = 0;
+    while (i < iovcnt_ && iov_[i].iov_len == 0) ++i;
+    if (i == iovcnt_) return true;
+    retValue_ = SSL_read(ssl_, iov_[i].iov_base,
+                         static_cast<int>(iov_[i].iov_len));
+    if (retValue_ < 0) {
+      return SSL_get_error(ssl_, static_cast<int>(retValue_)) !=
+             SSL_ERROR_WANT_READ;
+    }
+    if (retValue_ == 0) return true;
+    auto filled = static_cast<size_t>(retValue_) == iov_[i].iov_len;
+    for (++i; filled && i < iovcnt_ && SSL_pending(ssl_) > 0; ++i) {
+      auto n = SSL_read(ssl_, iov_[i].iov_base,
+                        static_cast<int>(iov_[i].iov_len));
+      if (n <= 0) break;
+      retValue_ += n;
+      filled = static_cast<size_t>(n) == iov_[i].iov_len;
+    }
+#endif
+    return true;
+  }
+
+  const struct iovec* iov_;
+  int iovcnt_;
+  struct msghdr msg_ {};
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+  const std::atomic<bool>& connected_;
+  SSL* ssl_;
+  // resumed by OnReady
+  std::coroutine_handle<> handle_;
+};
+
+// gather write. on a tls socket the buffers are coalesced and go out in one
+// SSL_write, so they are sealed in as few records as possible instead of at
+// least one record per buffer
+class WriteVAwaitable : public IoAwaitableBase {
+ public:
+  WriteVAwaitable(Base::IoService* service, int fd, const struct iovec* iov,
+                  int iovcnt, std::atomic<bool>& connected, SSL* ssl)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kWRITE),
+        iov_(iov),
+        iovcnt_(iovcnt),
+        connected_(connected),
+        ssl_(ssl) {
+    if (!ssl_) return;
+    size_t total = 0;
+    for (int i = 0; i < iovcnt_; ++i) total += iov_[i].iov_len;
+    record_.reserve(total);
+    for (int i = 0; i < iovcnt_; ++i) {
+      record_.append(static_cast<const char*>(iov_[i].iov_base),
+                     iov_[i].iov_len);
+    }
+  }
+
+  ~WriteVAwaitable() override = default;
+
+  WriteVAwaitable(WriteVAwaitable&&) = default;
+
+  bool await_ready() noexcept {
+    if (!connected_) return true;
+#ifdef COLD_NET_ENABLE_SSL
+    if (ssl_) {
+      if (record_.empty()) {
+        retValue_ = 0;
+        ready_ = true;
+        return true;
+      }
+      retValue_ =
+          SSL_write(ssl_, record_.data(), static_cast<int>(record_.size()));
+      if (retValue_ > 0) {
+        ready_ = true;
+      } else {
+        int e = SSL_get_error(ssl_, static_cast<int>(retValue_));
+        if (e != SSL_ERROR_WANT_WRITE) ready_ = true;
+      }
+      return ready_;
+    }
+#endif
+    retValue_ = writev(fd_, iov_, iovcnt_);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    msg_ = {};
+    msg_.msg_iov = const_cast<struct iovec*>(iov_);
+    msg_.msg_iovlen = static_cast<size_t>(iovcnt_);
+    op_.opcode = IoOperation::kSendMsg;
+    op_.addr = &msg_;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (!connected_ || GetTimeout()) {
+      errno = GetTimeout() ? ETIMEDOUT : ENOTCONN;
+      return -1;
+    }
+    if (ready_) return retValue_;
+#ifdef COLD_NET_ENABLE_SSL
+    if (ssl_) {
+      return SSL_write(ssl_, record_.data(), static_cast<int>(record_.size()));
+    }
+#endif
+    if (op_.submitted) return GetOperationResult();
+    return writev(fd_, iov_, iovcnt_);
+  }
+
+ private:
+  const struct iovec* iov_;
+  int iovcnt_;
+  struct msghdr msg_ {};
+  std::string record_;
+  const std::atomic<bool>& connected_;
+  bool ready_ = false;
+  ssize_t retValue_ = -1;
+  SSL* ssl_;
+};
+
+// send with MSG_ZEROCOPY. the pages of buf are pinned and sent from where
+// they are, so buf must not change until the kernel reports the send as
+// completed on the error queue. every send which returns > 0 takes the next
+// completion id of the socket
+class SendZeroCopyAwaitable : public IoAwaitableBase {
+ public:
+  SendZeroCopyAwaitable(Base::IoService* service, int fd, const void* buf,
+                        size_t count, std::atomic<bool>& connected)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kWRITE),
+        buf_(buf),
+        count_(count),
+        connected_(connected) {}
+
+  ~SendZeroCopyAwaitable() override = default;
+
+  bool await_ready() noexcept {
+    if (!connected_) return true;
+    retValue_ = send(fd_, buf_, count_, MSG_ZEROCOPY | MSG_NOSIGNAL);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    op_.opcode = IoOperation::kSend;
+    op_.flags = MSG_ZEROCOPY | MSG_NOSIGNAL;
+    op_.addr = const_cast<void*>(buf_);
+    op_.len = count_;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (!connected_ || GetTimeout()) {
+      errno = GetTimeout() ? ETIMEDOUT : ENOTCONN;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    if (op_.submitted) return GetOperationResult();
+    return send(fd_, buf_, count_, MSG_ZEROCOPY | MSG_NOSIGNAL);
+  }
+
+ private:
+  const void* buf_;
+  size_t count_;
+  const std::atomic<bool>& connected_;
+  bool ready_ = false;
+  ssize_t retValue_ = -1;
+};
+
+// ids lo to hi (inclusive) of zero copy sends were released by the kernel.
+// copied: the kernel copied the data anyway
+struct ZeroCopyCompletion {
+  uint32_t lo;
+  uint32_t hi;
+  bool copied;
+};
+
+// read the zero copy completions from the error queue of fd into
+// completions. wait for an error event if there is none. completions is
+// cleared first
+class ZeroCopyCompletionAwaitable : public IoAwaitableBase {
+ public:
+  ZeroCopyCompletionAwaitable(Base::IoService* service, int fd,
+                              std::vector<ZeroCopyCompletion>& completions)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kERROR),
+        completions_(&completions) {
+    completions_->clear();
+  }
+
+  ~ZeroCopyCompletionAwaitable() override = default;
+
+  bool await_ready() noexcept { return Drain(); }
+
+  // number of completions. 0 and errno on error. EAGAIN if another reader
+  // took the completions first, EPIPE if the connection hung up without
+  // one
+  size_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return 0;
+    }
+    if (!ready_ && !Drain() && HungUp()) error_ = EPIPE;
+    if (completions_->empty()) errno = error_;
+    return completions_->size();
+  }
+
+ private:
+  // return false if nothing happened before EAGAIN
+  bool Drain() {
+    while (true) {
+      alignas(struct cmsghdr) char control[CMSG_SPACE(
+          sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+      struct msghdr msg {};
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof control;
+      if (recvmsg(fd_, &msg, MSG_ERRQUEUE) < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) {
+          error_ = errno;
+          ready_ = true;
+        }
+        break;
+      }
+      for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        // an ipv6 socket reports ipv4 traffic with SOL_IP
+        if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+            !(cmsg->cmsg_level == SOL_IPV6 &&
+              cmsg->cmsg_type == IPV6_RECVERR)) {
+          continue;
+        }
+        struct sock_extended_err err;
+        memcpy(&err, CMSG_DATA(cmsg), sizeof err);
+        if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) {
+          continue;
+        }
+        completions_->push_back(
+            {err.ee_info, err.ee_data,
+             (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0});
+        ready_ = true;
+      }
+    }
+    return ready_;
+  }
+
+  // a hung up socket stays ready, waiting again would not block
+  bool HungUp() const {
+    struct pollfd pfd {};
+    pfd.fd = fd_;
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLHUP);
+  }
+
+  std::vector<ZeroCopyCompletion>* completions_;
+  bool ready_ = false;
+  int error_ = EAGAIN;
+};
+
 class AcceptAwaitable : public IoAwaitableBase {
  public:
   AcceptAwaitable(Base::IoService* service, int fd)
@@ -196,9 +539,15 @@ class AcceptAwaitable : public IoAwaitableBase {
     socklen_t arrlen = sizeof(addr_);
     peer_ = accept4(fd_, reinterpret_cast<struct sockaddr*>(&addr_), &arrlen,
                     SOCK_NONBLOCK | SOCK_CLOEXEC);
-    if (peer_ >= 0) {
+    // an error other than EAGAIN (e.g. EMFILE) gives no new edge
+    if (peer_ >= 0 || errno != EAGAIN) {
       ready_ = true;
     }
+    addrlen_ = sizeof(addr_);
+    op_.opcode = IoOperation::kAccept;
+    op_.flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    op_.addr = &addr_;
+    op_.addrlen = &addrlen_;
     return ready_;
   }
 
@@ -207,7 +556,9 @@ class AcceptAwaitable : public IoAwaitableBase {
       errno = ETIMEDOUT;
       return {-1, IpAddress{}};
     }
-    if (!ready_) {
+    if (!ready_ && op_.submitted) {
+      peer_ = static_cast<int>(GetOperationResult());
+    } else if (!ready_) {
       socklen_t arrlen = sizeof(addr_);
       peer_ = accept4(fd_, reinterpret_cast<struct sockaddr*>(&addr_), &arrlen,
                       SOCK_NONBLOCK | SOCK_CLOEXEC);
@@ -217,10 +568,69 @@ class AcceptAwaitable : public IoAwaitableBase {
 
  private:
   struct sockaddr_in6 addr_;
+  socklen_t addrlen_ = sizeof(addr_);
   bool ready_ = false;
   int peer_ = -1;
 };
 
+// accept4 until EAGAIN or max connections, so a burst of connections is
+// taken in one pass of the loop. connections is cleared first
+class AcceptBatchAwaitable : public IoAwaitableBase {
+ public:
+  using Connections = std::vector<std::pair<int, IpAddress>>;
+
+  AcceptBatchAwaitable(Base::IoService* service, int fd,
+                       Connections& connections, size_t max)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kREAD),
+        connections_(&connections),
+        max_(max) {
+    assert(max_ > 0);
+    connections_->clear();
+  }
+
+  ~AcceptBatchAwaitable() override = default;
+
+  bool await_ready() noexcept { return Drain(); }
+
+  // number of accepted connections. 0 and errno on error
+  size_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return 0;
+    }
+    if (!ready_) Drain();
+    if (connections_->empty()) errno = error_;
+    return connections_->size();
+  }
+
+ private:
+  // return false if nothing happened before EAGAIN
+  bool Drain() {
+    while (connections_->size() < max_) {
+      struct sockaddr_in6 addr;
+      socklen_t arrlen = sizeof(addr);
+      int peer = accept4(fd_, reinterpret_cast<struct sockaddr*>(&addr),
+                         &arrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (peer < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) {
+          error_ = errno;
+          ready_ = true;
+        }
+        break;
+      }
+      connections_->emplace_back(peer, IpAddress(addr));
+      ready_ = true;
+    }
+    return ready_;
+  }
+
+  Connections* connections_;
+  size_t max_;
+  bool ready_ = false;
+  int error_ = EAGAIN;
+};
+
 class SendToAwaitable : public IoAwaitableBase {
  public:
   SendToAwaitable(Base::IoService* service, int fd, const void* buf, size_t len,
@@ -275,7 +685,7 @@ class RecvFromAwaitable : public IoAwaitableBase {
     retValue_ =
         recvfrom(fd_, buf_, len_, flags_, source_->GetSockaddr(), &addrlen_);
     if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
-    return false;
+    return ready_;
   }
 
   ssize_t await_resume() noexcept {
@@ -297,21 +707,201 @@ class RecvFromAwaitable : public IoAwaitableBase {
   int flags_;
 };
 
+// a datagram of RecvBatch and SendBatch
+struct UdpMessage {
+  // the buffer, len is its size on recv and the bytes to send on send
+  void* data = nullptr;
+  size_t len = 0;
+  // the source on recv, the destination on send
+  IpAddress addr;
+  // bytes received or sent
+  size_t bytes = 0;
+  // send: split data into datagrams of segmentSize bytes (UDP_SEGMENT).
+  // recv: size of the datagrams coalesced into data (UDP_GRO), 0 if bytes
+  // is a single datagram
+  uint16_t segmentSize = 0;
+};
+
+// the msghdrs point into the awaitable, which IoTimeoutAwaitable moves.
+// so they are built in await_ready, not in the constructor
+class UdpBatchStorage {
+ public:
+  // datagrams per recvmmsg or sendmmsg at most
+  constexpr static size_t kMaxBatch = 64;
+
+ protected:
+  void Prepare(UdpMessage* msgs, size_t count, bool send) {
+    for (size_t i = 0; i < count; ++i) {
+      auto& msg = msgs[i];
+      iov_[i].iov_base = msg.data;
+      iov_[i].iov_len = msg.len;
+      auto& hdr = hdrs_[i].msg_hdr;
+      hdr = {};
+      hdr.msg_name = msg.addr.GetSockaddr();
+      hdr.msg_namelen = send && msg.addr.IsIpv4()
+                            ? sizeof(struct sockaddr_in)
+                            : sizeof(struct sockaddr_in6);
+      hdr.msg_iov = &iov_[i];
+      hdr.msg_iovlen = 1;
+      hdrs_[i].msg_len = 0;
+      if (send && msg.segmentSize == 0) continue;
+      hdr.msg_control = control_[i].buf;
+      hdr.msg_controllen = sizeof control_[i].buf;
+      if (!send) continue;
+      auto cmsg = CMSG_FIRSTHDR(&hdr);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      memcpy(CMSG_DATA(cmsg), &msg.segmentSize, sizeof(uint16_t));
+      hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+    }
+  }
+
+  void Complete(UdpMessage* msgs, size_t count, bool send) {
+    for (size_t i = 0; i < count; ++i) {
+      msgs[i].bytes = hdrs_[i].msg_len;
+      if (send) continue;
+      msgs[i].segmentSize = 0;
+      auto& hdr = hdrs_[i].msg_hdr;
+      for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+           cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int size;
+          memcpy(&size, CMSG_DATA(cmsg), sizeof size);
+          msgs[i].segmentSize = static_cast<uint16_t>(size);
+        }
+      }
+    }
+  }
+
+  struct mmsghdr hdrs_[kMaxBatch];
+  struct iovec iov_[kMaxBatch];
+  // UDP_GRO gives an int, UDP_SEGMENT takes an uint16_t
+  union Control {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } control_[kMaxBatch];
+};
+
+// recvmmsg up to kMaxBatch datagrams. return the number received, -1 and
+// errno on error
+class RecvBatchAwaitable : public IoAwaitableBase, public UdpBatchStorage {
+ public:
+  RecvBatchAwaitable(Base::IoService* service, int fd, UdpMessage* msgs,
+                     size_t count)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kREAD),
+        msgs_(msgs),
+        count_(std::min(count, kMaxBatch)) {}
+  ~RecvBatchAwaitable() override = default;
+
+  RecvBatchAwaitable(RecvBatchAwaitable&&) = default;
+
+  bool await_ready() noexcept {
+    retValue_ = Recv();
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    return Recv();
+  }
+
+ private:
+  ssize_t Recv() {
+    Prepare(msgs_, count_, false);
+    auto n = recvmmsg(fd_, hdrs_, static_cast<unsigned int>(count_), 0,
+                      nullptr);
+    if (n > 0) Complete(msgs_, static_cast<size_t>(n), false);
+    return n;
+  }
+
+  UdpMessage* msgs_;
+  size_t count_;
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+};
+
+// sendmmsg up to kMaxBatch datagrams. return the number sent, which may be
+// less than count, -1 and errno on error
+class SendBatchAwaitable : public IoAwaitableBase, public UdpBatchStorage {
+ public:
+  SendBatchAwaitable(Base::IoService* service, int fd, UdpMessage* msgs,
+                     size_t count)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kWRITE),
+        msgs_(msgs),
+        count_(std::min(count, kMaxBatch)) {}
+  ~SendBatchAwaitable() override = default;
+
+  SendBatchAwaitable(SendBatchAwaitable&&) = default;
+
+  bool await_ready() noexcept {
+    retValue_ = Send();
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    return Send();
+  }
+
+ private:
+  ssize_t Send() {
+    Prepare(msgs_, count_, true);
+    auto n = sendmmsg(fd_, hdrs_, static_cast<unsigned int>(count_), 0);
+    if (n > 0) Complete(msgs_, static_cast<size_t>(n), true);
+    return n;
+  }
+
+  UdpMessage* msgs_;
+  size_t count_;
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+};
+
 class ConnectAwaitable : public IoAwaitableBase {
  public:
   ConnectAwaitable(Base::IoService* service, int fd, const IpAddress& ip,
                    std::atomic<bool>* connected, IpAddress* localAddress,
                    IpAddress* remoteAddress)
+      : ConnectAwaitable(service, fd, ip.GetSockaddr(),
+                         ip.IsIpv4() ? sizeof(struct sockaddr_in)
+                                     : sizeof(struct sockaddr_in6),
+                         connected) {
+    localAddress_ = localAddress;
+    remoteAddress_ = remoteAddress;
+  }
+
+  // any address family. the addresses of the socket are not recorded
+  ConnectAwaitable(Base::IoService* service, int fd,
+                   const struct sockaddr* addr, socklen_t addrlen,
+                   std::atomic<bool>* connected)
       : IoAwaitableBase(service, fd, IoAwaitableBase::kWRITE),
-        ipAddress_(ip),
-        connected_(connected),
-        localAddress_(localAddress),
-        remoteAddress_(remoteAddress) {}
+        addrlen_(addrlen),
+        connected_(connected) {
+    assert(addrlen_ <= sizeof addr_);
+    memcpy(&addr_, addr, addrlen_);
+  }
 
   bool await_ready() noexcept {
-    retValue_ = connect(fd_, ipAddress_.GetSockaddr(),
-                        ipAddress_.IsIpv4() ? sizeof(struct sockaddr_in)
-                                            : sizeof(struct sockaddr_in6));
+    if (service_->SupportsOperations()) {
+      // connect in the backend, a connect here would make it EALREADY
+      op_.opcode = IoOperation::kConnect;
+      op_.addr = &addr_;
+      op_.len = addrlen_;
+      return false;
+    }
+    retValue_ = connect(fd_, reinterpret_cast<struct sockaddr*>(&addr_),
+                        addrlen_);
     if (retValue_ != -1 || errno != EINPROGRESS) notInprogress_ = true;
     return notInprogress_;
   }
@@ -321,19 +911,24 @@ class ConnectAwaitable : public IoAwaitableBase {
       errno = ETIMEDOUT;
       return -1;
     }
-    if (!notInprogress_) {
+    if (op_.submitted) {
+      retValue_ = -op_.result;
+    } else if (!notInprogress_) {
       socklen_t len = sizeof(int);
       if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &retValue_, &len) == -1)
         return -1;
     }
     if (retValue_ == 0) {
       assert(connected_);
-      assert(localAddress_);
-      assert(remoteAddress_);
       *connected_ = true;
-      socklen_t len = sizeof(struct sockaddr_in6);
-      getsockname(fd_, localAddress_->GetSockaddr(), &len);
-      *remoteAddress_ = ipAddress_;
+      if (localAddress_) {
+        socklen_t len = sizeof(struct sockaddr_in6);
+        getsockname(fd_, localAddress_->GetSockaddr(), &len);
+      }
+      if (remoteAddress_) {
+        *remoteAddress_ = IpAddress();
+        memcpy(remoteAddress_->GetSockaddr(), &addr_, addrlen_);
+      }
     } else {
       errno = retValue_;
       retValue_ = -1;
@@ -342,14 +937,87 @@ class ConnectAwaitable : public IoAwaitableBase {
   }
 
  private:
-  IpAddress ipAddress_;
+  struct sockaddr_storage addr_;
+  socklen_t addrlen_;
   std::atomic<bool>* connected_;
-  IpAddress* localAddress_;
-  IpAddress* remoteAddress_;
+  IpAddress* localAddress_ = nullptr;
+  IpAddress* remoteAddress_ = nullptr;
   int retValue_ = 0;
   bool notInprogress_ = false;
 };
 
+// sendmsg. msg must stay valid until the awaitable completes
+class SendMsgAwaitable : public IoAwaitableBase {
+ public:
+  SendMsgAwaitable(Base::IoService* service, int fd, const struct msghdr* msg,
+                   int flags)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kWRITE),
+        msg_(msg),
+        flags_(flags | MSG_NOSIGNAL) {}
+  ~SendMsgAwaitable() override = default;
+
+  bool await_ready() noexcept {
+    retValue_ = sendmsg(fd_, msg_, flags_);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    op_.opcode = IoOperation::kSendMsg;
+    op_.flags = flags_;
+    op_.addr = const_cast<struct msghdr*>(msg_);
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    if (op_.submitted) return GetOperationResult();
+    return sendmsg(fd_, msg_, flags_);
+  }
+
+ private:
+  const struct msghdr* msg_;
+  int flags_;
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+};
+
+// recvmsg. msg must stay valid until the awaitable completes
+class RecvMsgAwaitable : public IoAwaitableBase {
+ public:
+  RecvMsgAwaitable(Base::IoService* service, int fd, struct msghdr* msg,
+                   int flags)
+      : IoAwaitableBase(service, fd, IoAwaitableBase::kREAD),
+        msg_(msg),
+        flags_(flags) {}
+  ~RecvMsgAwaitable() override = default;
+
+  bool await_ready() noexcept {
+    retValue_ = recvmsg(fd_, msg_, flags_);
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    op_.opcode = IoOperation::kRecvMsg;
+    op_.flags = flags_;
+    op_.addr = msg_;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    if (op_.submitted) return GetOperationResult();
+    return recvmsg(fd_, msg_, flags_);
+  }
+
+ private:
+  struct msghdr* msg_;
+  int flags_;
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+};
+
 class SendFileAwaitable : public IoAwaitableBase {
  public:
   SendFileAwaitable(Base::IoService* service, int outFd, int inFd,
@@ -382,6 +1050,47 @@ class SendFileAwaitable : public IoAwaitableBase {
   ssize_t retValue_ = 0;
 };
 
+// splice up to count bytes from inFd to outFd, one of them a pipe. wait for
+// type on fd, the socket end
+class SpliceAwaitable : public IoAwaitableBase {
+ public:
+  SpliceAwaitable(Base::IoService* service, int fd, IoType type, int inFd,
+                  int outFd, size_t count)
+      : IoAwaitableBase(service, fd, type),
+        inFd_(inFd),
+        outFd_(outFd),
+        count_(count) {}
+
+  ~SpliceAwaitable() override = default;
+
+  bool await_ready() noexcept {
+    retValue_ = DoSplice();
+    if (retValue_ >= 0 || errno != EAGAIN) ready_ = true;
+    return ready_;
+  }
+
+  ssize_t await_resume() noexcept {
+    if (GetTimeout()) {
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (ready_) return retValue_;
+    return DoSplice();
+  }
+
+ private:
+  ssize_t DoSplice() {
+    return splice(inFd_, nullptr, outFd_, nullptr, count_,
+                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  }
+
+  int inFd_;
+  int outFd_;
+  size_t count_;
+  bool ready_ = false;
+  ssize_t retValue_ = 0;
+};
+
 #ifdef COLD_NET_ENABLE_SSL
 
 class HandshakeAwaitable : public IoAwaitableBase {
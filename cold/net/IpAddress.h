@@ -4,6 +4,7 @@
 #include <arpa/inet.h>
 #include <sys/un.h>
 
+#include <functional>
 #include <optional>
 #include <string_view>
 
@@ -30,6 +31,14 @@ class IpAddress {
   uint16_t GetPort() const;
   std::string GetIpPort() const;
 
+  // hash of the ip, without the port
+  size_t HashIp() const {
+    if (IsIpv4()) return std::hash<uint32_t>()(ipv4Addr_.sin_addr.s_addr);
+    return std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<const char*>(&ipv6Addr_.sin6_addr),
+                         sizeof ipv6Addr_.sin6_addr));
+  }
+
   sa_family_t GetFamily() const { return ipv4Addr_.sin_family; }
 
   bool IsIpv4() const { return ipv4Addr_.sin_family == AF_INET; }
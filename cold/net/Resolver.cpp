@@ -0,0 +1,543 @@
+#include "cold/net/Resolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <coroutine>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+
+#include "cold/log/Logger.h"
+#include "cold/net/Endian.h"
+#include "cold/net/TcpSocket.h"
+#include "cold/net/UdpSocket.h"
+#include "cold/time/MonoTime.h"
+
+using namespace Cold;
+
+namespace {
+
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kTypeAAAA = 28;
+constexpr uint16_t kTypeSoa = 6;
+constexpr uint16_t kClassIn = 1;
+constexpr size_t kHeaderSize = 12;
+// without edns an udp answer has at most 512 bytes
+constexpr size_t kMaxUdpAnswer = 512;
+constexpr uint32_t kMaxTtl = 24 * 3600;
+// an answer without addresses is cached for less, a record may be added soon
+constexpr uint32_t kMaxNegativeTtl = 300;
+// answers cached per thread
+constexpr size_t kMaxCacheEntries = 4096;
+
+enum class Status { kOk, kNameError, kTruncated, kFailed };
+
+// the answer to one query
+struct Answer {
+  Status status = Status::kFailed;
+  std::vector<Net::IpAddress> addrs;
+  uint32_t ttl = kMaxTtl;
+};
+
+struct CacheEntry {
+  std::vector<Net::IpAddress> addrs;
+  Base::MonoTime expiry;
+};
+
+// a query in flight, the lookups of the same name wait for it
+struct Pending {
+  bool done = false;
+  std::vector<Net::IpAddress> addrs;
+  std::vector<std::coroutine_handle<>> waiters;
+};
+
+struct PendingAwaiter {
+  std::shared_ptr<Pending> pending;
+
+  bool await_ready() const noexcept { return pending->done; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    pending->waiters.push_back(handle);
+  }
+  std::vector<Net::IpAddress> await_resume() const { return pending->addrs; }
+};
+
+std::mutex g_mutex;
+std::optional<Net::Resolver::Config> g_config;
+std::atomic<uint64_t> g_generation = 1;
+
+struct ThreadState {
+  uint64_t generation = 0;
+  Net::Resolver::Config config;
+  std::unordered_map<std::string, std::vector<Net::IpAddress>> hosts;
+  std::unordered_map<std::string, CacheEntry> cache;
+  std::unordered_map<std::string, std::shared_ptr<Pending>> pending;
+  std::mt19937 random{std::random_device()()};
+};
+
+thread_local ThreadState t_state;
+
+std::vector<std::string_view> SplitWhitespace(std::string_view line) {
+  std::vector<std::string_view> words;
+  size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() && isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    auto begin = i;
+    while (i < line.size() && !isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    if (i > begin) words.push_back(line.substr(begin, i - begin));
+  }
+  return words;
+}
+
+std::string ToLower(std::string_view str) {
+  std::string result(str);
+  for (auto& c : result) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+  return result;
+}
+
+// a literal address, nullopt if str is none
+std::optional<Net::IpAddress> ParseIp(const std::string& str, uint16_t port) {
+  struct in_addr addr4;
+  if (inet_pton(AF_INET, str.data(), &addr4) == 1) {
+    return Net::IpAddress(str, port);
+  }
+  struct in6_addr addr6;
+  if (inet_pton(AF_INET6, str.data(), &addr6) == 1) {
+    return Net::IpAddress(str, port, true);
+  }
+  return std::nullopt;
+}
+
+Net::IpAddress WithPort(Net::IpAddress addr, uint16_t port) {
+  // sin_port and sin6_port are at the same offset
+  reinterpret_cast<struct sockaddr_in*>(addr.GetSockaddr())->sin_port =
+      Net::Host16ToNetwork16(port);
+  return addr;
+}
+
+bool Matches(const Net::IpAddress& addr, Net::Resolver::Family family) {
+  if (family == Net::Resolver::Family::kAny) return true;
+  return addr.IsIpv6() == (family == Net::Resolver::Family::kIpv6);
+}
+
+void LoadHosts(ThreadState& state) {
+  state.hosts.clear();
+  std::ifstream file(state.config.hostsPath);
+  std::string line;
+  while (std::getline(file, line)) {
+    line.resize(std::min(line.size(), line.find('#')));
+    auto words = SplitWhitespace(line);
+    if (words.size() < 2) continue;
+    auto addr = ParseIp(std::string(words[0]), 0);
+    if (!addr) continue;
+    for (size_t i = 1; i < words.size(); ++i) {
+      state.hosts[ToLower(words[i])].push_back(*addr);
+    }
+  }
+}
+
+ThreadState& GetState() {
+  auto& state = t_state;
+  auto generation = g_generation.load(std::memory_order_acquire);
+  if (state.generation == generation) return state;
+  {
+    std::lock_guard lock(g_mutex);
+    if (!g_config) g_config = Net::Resolver::LoadConfig();
+    state.config = *g_config;
+    state.generation = g_generation.load(std::memory_order_relaxed);
+  }
+  state.cache.clear();
+  LoadHosts(state);
+  return state;
+}
+
+void PutUint16(std::string& buf, uint16_t v) {
+  buf.push_back(static_cast<char>(v >> 8));
+  buf.push_back(static_cast<char>(v & 0xff));
+}
+
+uint16_t GetUint16(std::string_view msg, size_t offset) {
+  return static_cast<uint16_t>(
+      (static_cast<uint8_t>(msg[offset]) << 8) |
+      static_cast<uint8_t>(msg[offset + 1]));
+}
+
+uint32_t GetUint32(std::string_view msg, size_t offset) {
+  return (static_cast<uint32_t>(GetUint16(msg, offset)) << 16) |
+         GetUint16(msg, offset + 2);
+}
+
+// empty if name is not a valid domain name
+std::string BuildQuery(std::string_view name, uint16_t type, uint16_t id) {
+  std::string query;
+  PutUint16(query, id);
+  // recursion desired
+  PutUint16(query, 0x0100);
+  PutUint16(query, 1);
+  PutUint16(query, 0);
+  PutUint16(query, 0);
+  PutUint16(query, 0);
+  if (name.empty() || name.size() > 253) return {};
+  size_t start = 0;
+  while (start < name.size()) {
+    auto end = std::min(name.find('.', start), name.size());
+    auto size = end - start;
+    if (size == 0 || size > 63) return {};
+    query.push_back(static_cast<char>(size));
+    query.append(name.substr(start, size));
+    start = end + 1;
+  }
+  query.push_back('\0');
+  PutUint16(query, type);
+  PutUint16(query, kClassIn);
+  return query;
+}
+
+// offset past the name at offset, 0 if it is malformed
+size_t SkipName(std::string_view msg, size_t offset) {
+  while (offset < msg.size()) {
+    auto len = static_cast<uint8_t>(msg[offset]);
+    // a pointer ends the name
+    if ((len & 0xc0) == 0xc0) {
+      return offset + 2 <= msg.size() ? offset + 2 : 0;
+    }
+    if (len & 0xc0) return 0;
+    if (len == 0) return offset + 1;
+    offset += 1 + len;
+  }
+  return 0;
+}
+
+// how long the name has no records of the type asked, from the soa record
+// in the authority section at offset (rfc 2308). 0 without one, it is not
+// cached then
+uint32_t NegativeTtl(std::string_view msg, size_t offset) {
+  auto authorities = GetUint16(msg, 8);
+  for (uint16_t i = 0; i < authorities; ++i) {
+    offset = SkipName(msg, offset);
+    if (offset == 0 || offset + 10 > msg.size()) return 0;
+    auto rrType = GetUint16(msg, offset);
+    auto ttl = GetUint32(msg, offset + 4);
+    auto size = GetUint16(msg, offset + 8);
+    offset += 10;
+    if (offset + size > msg.size()) return 0;
+    if (rrType == kTypeSoa && size >= 4) {
+      // the minimum field ends the rdata
+      auto minimum = GetUint32(msg, offset + size - 4);
+      return std::min({ttl, minimum, kMaxNegativeTtl});
+    }
+    offset += size;
+  }
+  return 0;
+}
+
+// records of type in the answer section, of the name asked or of its
+// aliases, which the server puts in the same answer
+Answer ParseAnswer(std::string_view msg, uint16_t id, uint16_t type) {
+  Answer answer;
+  if (msg.size() < kHeaderSize || GetUint16(msg, 0) != id) return answer;
+  auto flags = GetUint16(msg, 2);
+  // not a response
+  if (!(flags & 0x8000)) return answer;
+  if (flags & 0x0200) {
+    answer.status = Status::kTruncated;
+    return answer;
+  }
+  auto rcode = flags & 0x000f;
+  if (rcode == 3) {
+    answer.status = Status::kNameError;
+    return answer;
+  }
+  if (rcode != 0) return answer;
+  auto questions = GetUint16(msg, 4);
+  auto answers = GetUint16(msg, 6);
+  size_t offset = kHeaderSize;
+  for (uint16_t i = 0; i < questions; ++i) {
+    offset = SkipName(msg, offset);
+    if (offset == 0 || offset + 4 > msg.size()) return answer;
+    offset += 4;
+  }
+  for (uint16_t i = 0; i < answers; ++i) {
+    offset = SkipName(msg, offset);
+    if (offset == 0 || offset + 10 > msg.size()) return answer;
+    auto rrType = GetUint16(msg, offset);
+    auto rrClass = GetUint16(msg, offset + 2);
+    auto ttl = GetUint32(msg, offset + 4);
+    auto size = GetUint16(msg, offset + 8);
+    offset += 10;
+    if (offset + size > msg.size()) return answer;
+    if (rrType == type && rrClass == kClassIn) {
+      if (type == kTypeA && size == 4) {
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        memcpy(&addr.sin_addr, msg.data() + offset, 4);
+        answer.addrs.emplace_back(addr);
+      } else if (type == kTypeAAAA && size == 16) {
+        struct sockaddr_in6 addr {};
+        addr.sin6_family = AF_INET6;
+        memcpy(&addr.sin6_addr, msg.data() + offset, 16);
+        answer.addrs.emplace_back(addr);
+      }
+    }
+    // the ttl of the chain is the smallest one
+    answer.ttl = std::min(answer.ttl, ttl);
+    offset += size;
+  }
+  answer.status = Status::kOk;
+  if (answer.addrs.empty()) answer.ttl = NegativeTtl(msg, offset);
+  return answer;
+}
+
+Base::Task<Answer> QueryUdp(Base::IoService& service,
+                            const Net::IpAddress& nameserver,
+                            const std::string& query, uint16_t id,
+                            uint16_t type, std::chrono::milliseconds timeout) {
+  Net::UdpSocket socket(service, nameserver.IsIpv6());
+  // connected, so only the nameserver is heard and a refusal is seen
+  auto ret = co_await socket.Connect(nameserver);
+  if (ret < 0) co_return Answer();
+  auto n = co_await socket.Write(query.data(), query.size());
+  if (n < 0) co_return Answer();
+  auto deadline = Base::MonoTime::Now() + timeout;
+  char buf[kMaxUdpAnswer];
+  while (true) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - Base::MonoTime::Now());
+    if (left.count() <= 0) co_return Answer();
+    n = co_await socket.ReadWithTimeout(buf, sizeof buf, left);
+    if (n < 0 && errno == EAGAIN) continue;
+    if (n < 0) co_return Answer();
+    std::string_view msg(buf, static_cast<size_t>(n));
+    // a stale or forged datagram, wait for the right one
+    if (msg.size() < kHeaderSize || GetUint16(msg, 0) != id) continue;
+    co_return ParseAnswer(msg, id, type);
+  }
+}
+
+Base::Task<bool> ReadFull(Net::TcpSocket& socket, char* buf, size_t size,
+                          Base::MonoTime deadline) {
+  size_t done = 0;
+  while (done < size) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - Base::MonoTime::Now());
+    if (left.count() <= 0) co_return false;
+    auto n = co_await socket.ReadWithTimeout(buf + done, size - done, left);
+    if (n < 0 && errno == EAGAIN) continue;
+    if (n <= 0) co_return false;
+    done += static_cast<size_t>(n);
+  }
+  co_return true;
+}
+
+// for an answer truncated over udp. the message is prefixed by its length
+Base::Task<Answer> QueryTcp(Base::IoService& service,
+                            const Net::IpAddress& nameserver,
+                            const std::string& query, uint16_t id,
+                            uint16_t type, std::chrono::milliseconds timeout) {
+  auto deadline = Base::MonoTime::Now() + timeout;
+  Net::TcpSocket socket(service, false, nameserver.IsIpv6());
+  auto ret = co_await socket.ConnectWithTimeout(nameserver, timeout);
+  if (ret < 0) co_return Answer();
+  std::string request;
+  PutUint16(request, static_cast<uint16_t>(query.size()));
+  request += query;
+  auto n = co_await socket.WriteN(request.data(), request.size());
+  if (n < 0) co_return Answer();
+  char header[2];
+  auto ok = co_await ReadFull(socket, header, sizeof header, deadline);
+  if (!ok) co_return Answer();
+  std::string msg(GetUint16(std::string_view(header, 2), 0), '\0');
+  ok = co_await ReadFull(socket, msg.data(), msg.size(), deadline);
+  if (!ok) co_return Answer();
+  auto answer = ParseAnswer(msg, id, type);
+  // a truncated tcp answer holds no more than this
+  if (answer.status == Status::kTruncated) answer.status = Status::kFailed;
+  co_return answer;
+}
+
+Base::Task<Answer> Query(Base::IoService& service, ThreadState& state,
+                         const std::string& name, uint16_t type) {
+  // the config may be replaced while waiting
+  auto config = state.config;
+  for (int attempt = 0; attempt < config.attempts; ++attempt) {
+    for (auto& nameserver : config.nameservers) {
+      auto id = static_cast<uint16_t>(state.random());
+      auto query = BuildQuery(name, type, id);
+      if (query.empty()) co_return Answer();
+      auto answer =
+          co_await QueryUdp(service, nameserver, query, id, type,
+                            config.timeout);
+      if (answer.status == Status::kTruncated) {
+        answer = co_await QueryTcp(service, nameserver, query, id, type,
+                                   config.timeout);
+      }
+      if (answer.status == Status::kOk ||
+          answer.status == Status::kNameError) {
+        co_return answer;
+      }
+    }
+  }
+  Base::WARN("Resolver: no answer for {}", name);
+  co_return Answer();
+}
+
+// at most kMaxCacheEntries. a full cache drops its expired entries, then an
+// arbitrary one
+void AddToCache(ThreadState& state, const std::string& key,
+                const Answer& answer) {
+  auto now = Base::MonoTime::Now();
+  if (state.cache.size() >= kMaxCacheEntries && !state.cache.contains(key)) {
+    // an expired entry is only dropped by a lookup of its name, so names
+    // not asked for again pile up until the cache is full
+    std::erase_if(state.cache,
+                  [now](auto& entry) { return !(now < entry.second.expiry); });
+    if (state.cache.size() >= kMaxCacheEntries) {
+      state.cache.erase(state.cache.begin());
+    }
+  }
+  state.cache[key] =
+      CacheEntry{answer.addrs, now + std::chrono::seconds(answer.ttl)};
+}
+
+// ask for name of type, then wake the lookups waiting on pending
+Base::Task<> RunQuery(Base::IoService& service, std::string key,
+                      std::string name, uint16_t type,
+                      std::shared_ptr<Pending> pending) {
+  auto& state = GetState();
+  auto answer = co_await Query(service, state, name, type);
+  if (answer.status == Status::kOk && answer.ttl > 0) {
+    AddToCache(state, key, answer);
+  }
+  pending->done = true;
+  pending->addrs = std::move(answer.addrs);
+  auto it = state.pending.find(key);
+  if (it != state.pending.end() && it->second == pending) {
+    state.pending.erase(it);
+  }
+  auto waiters = std::move(pending->waiters);
+  for (auto waiter : waiters) waiter.resume();
+}
+
+// the query of name of type, shared by the lookups of the same name. it is
+// done already on a cache hit
+std::shared_ptr<Pending> StartLookup(Base::IoService& service,
+                                     const std::string& name,
+                                     uint16_t type) {
+  auto& state = GetState();
+  auto key = name + (type == kTypeA ? "/A" : "/AAAA");
+  auto it = state.cache.find(key);
+  if (it != state.cache.end()) {
+    if (Base::MonoTime::Now() < it->second.expiry) {
+      auto pending = std::make_shared<Pending>();
+      pending->done = true;
+      pending->addrs = it->second.addrs;
+      return pending;
+    }
+    state.cache.erase(it);
+  }
+  auto pendingIt = state.pending.find(key);
+  if (pendingIt != state.pending.end()) return pendingIt->second;
+  auto pending = std::make_shared<Pending>();
+  state.pending.emplace(key, pending);
+  service.CoSpawn(RunQuery(service, key, name, type, pending));
+  return pending;
+}
+
+}  // namespace
+
+Net::Resolver::Config Net::Resolver::LoadConfig(
+    const std::string& resolvConfPath) {
+  Config config;
+  std::ifstream file(resolvConfPath);
+  std::string line;
+  while (std::getline(file, line)) {
+    line.resize(std::min(line.size(), line.find_first_of("#;")));
+    auto words = SplitWhitespace(line);
+    if (words.size() < 2) continue;
+    if (words[0] == "nameserver") {
+      auto addr = ParseIp(std::string(words[1]), 53);
+      if (addr) config.nameservers.push_back(*addr);
+    } else if (words[0] == "options") {
+      for (size_t i = 1; i < words.size(); ++i) {
+        auto option = words[i];
+        auto value = option.substr(option.find(':') + 1);
+        if (option.starts_with("timeout:")) {
+          config.timeout =
+              std::chrono::seconds(atoi(std::string(value).data()));
+        } else if (option.starts_with("attempts:")) {
+          config.attempts = std::max(atoi(std::string(value).data()), 1);
+        }
+      }
+    }
+  }
+  if (config.nameservers.empty()) {
+    config.nameservers.emplace_back("127.0.0.1", 53);
+  }
+  return config;
+}
+
+void Net::Resolver::SetConfig(Config config) {
+  std::lock_guard lock(g_mutex);
+  g_config = std::move(config);
+  g_generation.fetch_add(1, std::memory_order_release);
+}
+
+Net::Resolver::Config Net::Resolver::GetConfig() {
+  std::lock_guard lock(g_mutex);
+  if (!g_config) g_config = LoadConfig();
+  return *g_config;
+}
+
+Base::Task<std::vector<Net::IpAddress>> Net::Resolver::Resolve(
+    Base::IoService& service, std::string host, uint16_t port,
+    Family family) {
+  std::vector<IpAddress> result;
+  if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+  auto literal = ParseIp(host, port);
+  if (literal) {
+    if (Matches(*literal, family)) result.push_back(*literal);
+    co_return result;
+  }
+  auto name = ToLower(host);
+  if (name.ends_with('.')) name.pop_back();
+  auto& state = GetState();
+  auto it = state.hosts.find(name);
+  if (it != state.hosts.end()) {
+    for (auto& addr : it->second) {
+      if (Matches(addr, family)) result.push_back(WithPort(addr, port));
+    }
+    if (!result.empty()) co_return result;
+  }
+  // for kAny both queries are in flight at once
+  std::vector<std::shared_ptr<Pending>> lookups;
+  if (family != Family::kIpv4) {
+    lookups.push_back(StartLookup(service, name, kTypeAAAA));
+  }
+  if (family != Family::kIpv6) {
+    lookups.push_back(StartLookup(service, name, kTypeA));
+  }
+  for (auto& lookup : lookups) {
+    PendingAwaiter awaiter{lookup};
+    auto addrs = co_await awaiter;
+    for (auto& addr : addrs) result.push_back(WithPort(addr, port));
+  }
+  co_return result;
+}
+
+size_t Net::Resolver::CacheSize() { return GetState().cache.size(); }
+
+void Net::Resolver::ClearCache() { GetState().cache.clear(); }
@@ -0,0 +1,59 @@
+#ifndef COLD_NET_RESOLVER
+#define COLD_NET_RESOLVER
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/coro/Task.h"
+#include "cold/net/IpAddress.h"
+
+namespace Cold::Net {
+
+// asynchronous stub resolver, IpAddress::Resolve without blocking the loop.
+// a name is looked up in the hosts file, then asked to the nameservers over
+// udp, and over tcp when the answer is truncated. answers are cached for
+// their ttl, an empty one for the minimum of its soa record and at most 5
+// minutes. concurrent lookups of a name share one query. the cache and the
+// queries in flight belong to the thread, so to its IoService. search
+// domains are not applied, a name is always absolute
+class Resolver {
+ public:
+  enum class Family { kIpv4, kIpv6, kAny };
+
+  struct Config {
+    std::vector<IpAddress> nameservers;
+    std::string hostsPath = "/etc/hosts";
+    // for one query to one nameserver
+    std::chrono::milliseconds timeout{5000};
+    // rounds over the nameservers
+    int attempts = 2;
+  };
+
+  // the nameserver lines and the timeout and attempts options of a
+  // resolv.conf. without a nameserver, the one on the local host
+  static Config LoadConfig(const std::string& resolvConfPath =
+                               "/etc/resolv.conf");
+
+  // for every thread, from its next lookup on. this drops the caches. the
+  // default is LoadConfig()
+  static void SetConfig(Config config);
+  static Config GetConfig();
+
+  // the addresses of host, with port. kAny asks for both families at once
+  // and gives the ipv6 ones first. empty if the name has none or on error.
+  // run it in the thread of service
+  static Base::Task<std::vector<IpAddress>> Resolve(
+      Base::IoService& service, std::string host, uint16_t port,
+      Family family = Family::kIpv4);
+
+  // answers cached by this thread, at most 4096
+  static size_t CacheSize();
+  static void ClearCache();
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_RESOLVER */
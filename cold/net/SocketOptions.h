@@ -3,6 +3,7 @@
 
 #include <linux/tcp.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 
 namespace Cold::Net::SocketOptions {
@@ -55,6 +56,70 @@ struct ReusePort {
   socklen_t len = sizeof(int);
 };
 
+// on a listen socket, wake up the acceptor only when data arrives, or
+// after value seconds
+struct TcpDeferAccept {
+  explicit TcpDeferAccept(int seconds = 0) : value(seconds) {}
+
+  constexpr static int level = IPPROTO_TCP;
+  constexpr static int optName = TCP_DEFER_ACCEPT;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
+// busy poll the device queue for up to value microseconds on a blocking
+// receive. raising it above net.core.busy_read needs CAP_NET_ADMIN
+struct BusyPoll {
+  explicit BusyPoll(int microseconds = 0) : value(microseconds) {}
+
+  constexpr static int level = SOL_SOCKET;
+  constexpr static int optName = SO_BUSY_POLL;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
+// get: the cpu which processed the last packet of the socket. set: on a
+// listen socket, hand connections to the accept queue of that cpu
+struct IncomingCpu {
+  explicit IncomingCpu(int cpu = -1) : value(cpu) {}
+
+  constexpr static int level = SOL_SOCKET;
+  constexpr static int optName = SO_INCOMING_CPU;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
+// allow send with MSG_ZEROCOPY
+struct ZeroCopy {
+  explicit ZeroCopy(bool open = false) : value(open ? 1 : 0) {}
+
+  constexpr static int level = SOL_SOCKET;
+  constexpr static int optName = SO_ZEROCOPY;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
+// udp: split every send into datagrams of value bytes (GSO). a
+// segmentSize of UdpMessage overrides it
+struct UdpSegment {
+  explicit UdpSegment(int size = 0) : value(size) {}
+
+  constexpr static int level = SOL_UDP;
+  constexpr static int optName = UDP_SEGMENT;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
+// udp: let the kernel coalesce datagrams of a flow into one receive (GRO)
+struct UdpGro {
+  explicit UdpGro(bool open = false) : value(open ? 1 : 0) {}
+
+  constexpr static int level = SOL_UDP;
+  constexpr static int optName = UDP_GRO;
+  int value;
+  socklen_t len = sizeof(int);
+};
+
 struct SockError {
   constexpr static int level = SOL_SOCKET;
   constexpr static int optName = SO_ERROR;
@@ -0,0 +1,157 @@
+#include "cold/net/Splice.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <coroutine>
+#include <string>
+#include <vector>
+
+using namespace Cold;
+
+namespace {
+
+void ClosePipe(const Net::PipePool::Pipe& pipe) {
+  close(pipe.readFd);
+  close(pipe.writeFd);
+}
+
+struct PipeCache {
+  PipeCache() = default;
+  ~PipeCache() {
+    for (auto& pipe : pipes) ClosePipe(pipe);
+  }
+
+  std::vector<Net::PipePool::Pipe> pipes;
+};
+
+thread_local PipeCache t_pipes;
+
+// bytes read at most per Splice of a tls socket
+constexpr size_t kCopyBufferSize = 16 * 1024;
+
+Base::Task<ssize_t> CopyThrough(Net::TcpSocket& src, Net::TcpSocket& dst,
+                                size_t maxBytes) {
+  std::string buf(std::min(maxBytes, kCopyBufferSize), '\0');
+  ssize_t n = 0;
+  do {
+    n = co_await src.Read(buf.data(), buf.size());
+  } while (n < 0 && errno == EAGAIN);
+  if (n <= 0) co_return n;
+  auto ret = co_await dst.WriteN(buf.data(), static_cast<size_t>(n));
+  if (ret < 0) co_return ret;
+  co_return n;
+}
+
+// splice from src to dst until eof or error. return the bytes moved
+Base::Task<size_t> Pump(Net::TcpSocket& src, Net::TcpSocket& dst) {
+  size_t total = 0;
+  while (true) {
+    auto n = co_await Net::Splice(src, dst, Net::PipePool::kPipeSize);
+    if (n == 0) {
+      dst.ShutDown();
+      break;
+    }
+    if (n < 0) {
+      src.Close();
+      dst.Close();
+      break;
+    }
+    total += static_cast<size_t>(n);
+  }
+  co_return total;
+}
+
+}  // namespace
+
+Net::PipePool::Pipe Net::PipePool::Acquire() {
+  auto& pipes = t_pipes.pipes;
+  if (!pipes.empty()) {
+    auto pipe = pipes.back();
+    pipes.pop_back();
+    return pipe;
+  }
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+    Base::ERROR("Cannot create pipe. reason: {}",
+                Base::ThisThread::ErrorMsg());
+    return {};
+  }
+  // ignore the failure, e.g. over /proc/sys/fs/pipe-user-pages-soft
+  fcntl(fds[1], F_SETPIPE_SZ, kPipeSize);
+  auto size = fcntl(fds[1], F_GETPIPE_SZ);
+  return {fds[0], fds[1], size > 0 ? static_cast<size_t>(size) : 4096};
+}
+
+void Net::PipePool::Release(Pipe pipe, bool empty) {
+  if (!pipe.IsValid()) return;
+  auto& pipes = t_pipes.pipes;
+  if (!empty || pipes.size() >= kMaxCachedPipes) {
+    ClosePipe(pipe);
+    return;
+  }
+  pipes.push_back(pipe);
+}
+
+Base::Task<ssize_t> Net::Splice(TcpSocket& src, TcpSocket& dst,
+                                size_t maxBytes) {
+  if (src.GetSSL() || dst.GetSSL()) {
+    co_return co_await CopyThrough(src, dst, maxBytes);
+  }
+  auto pipe = PipePool::Acquire();
+  if (!pipe.IsValid()) co_return -1;
+  // the pipe is empty, so EAGAIN means src is
+  ssize_t n = 0;
+  do {
+    n = co_await SpliceAwaitable(&src.GetIoService(), src.NativeHandle(),
+                                 IoAwaitableBase::kREAD, src.NativeHandle(),
+                                 pipe.writeFd,
+                                 std::min(maxBytes, pipe.capacity));
+    // woken by a zero copy completion
+  } while (n < 0 && errno == EAGAIN);
+  if (n <= 0) {
+    PipePool::Release(pipe);
+    co_return n;
+  }
+  auto left = static_cast<size_t>(n);
+  while (left > 0) {
+    auto ret = co_await SpliceAwaitable(
+        &dst.GetIoService(), dst.NativeHandle(), IoAwaitableBase::kWRITE,
+        pipe.readFd, dst.NativeHandle(), left);
+    if (ret < 0 && errno == EAGAIN) continue;
+    if (ret <= 0) {
+      PipePool::Release(pipe, false);
+      co_return -1;
+    }
+    left -= static_cast<size_t>(ret);
+  }
+  PipePool::Release(pipe);
+  co_return n;
+}
+
+Base::Task<std::pair<size_t, size_t>> Net::Forward(TcpSocket& a,
+                                                   TcpSocket& b) {
+  // both directions run in the loop of a
+  struct Join {
+    bool done = false;
+    size_t bytes = 0;
+    std::coroutine_handle<> waiter;
+
+    bool await_ready() const noexcept { return done; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+      waiter = handle;
+    }
+    void await_resume() const noexcept {}
+  } join;
+  a.GetIoService().CoSpawn(
+      [](TcpSocket& src, TcpSocket& dst, Join& j) -> Base::Task<> {
+        j.bytes = co_await Pump(src, dst);
+        j.done = true;
+        // the frame of Forward, and j, may be gone after this
+        if (j.waiter) j.waiter.resume();
+      }(b, a, join));
+  auto fromA = co_await Pump(a, b);
+  co_await join;
+  co_return std::pair(fromA, join.bytes);
+}
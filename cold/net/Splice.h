@@ -0,0 +1,51 @@
+#ifndef COLD_NET_SPLICE
+#define COLD_NET_SPLICE
+
+#include <cstddef>
+#include <utility>
+
+#include "cold/coro/Task.h"
+#include "cold/net/TcpSocket.h"
+
+namespace Cold::Net {
+
+// pipes for splice. every thread, so every IoService, caches the pipes
+// given back to it. a pipe is given back empty.
+class PipePool {
+ public:
+  struct Pipe {
+    int readFd = -1;
+    int writeFd = -1;
+    // bytes the pipe holds at most
+    size_t capacity = 0;
+
+    bool IsValid() const { return readFd >= 0; }
+  };
+
+  // asked with F_SETPIPE_SZ, the kernel may give less
+  constexpr static int kPipeSize = 256 * 1024;
+  // max pipes cached per thread
+  constexpr static size_t kMaxCachedPipes = 16;
+
+  // an invalid pipe on error
+  static Pipe Acquire();
+  // close the pipe instead if it still holds data
+  static void Release(Pipe pipe, bool empty = true);
+};
+
+// move up to maxBytes from src to dst through a pipe, without copying them
+// into user space. return the bytes moved, 0 on eof of src, -1 on error.
+// all bytes taken from src are written to dst before it returns.
+// tls sockets copy through user space, splice sees only the records
+[[nodiscard]] Base::Task<ssize_t> Splice(TcpSocket& src, TcpSocket& dst,
+                                         size_t maxBytes);
+
+// splice in both directions until both sides reached eof. the eof of one
+// side is passed on to the other by ShutDown. an error closes both. return
+// the bytes moved from a to b and from b to a. run it in the IoService of a
+[[nodiscard]] Base::Task<std::pair<size_t, size_t>> Forward(TcpSocket& a,
+                                                            TcpSocket& b);
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_SPLICE */
@@ -0,0 +1,157 @@
+#include "cold/net/TcpClient.h"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "cold/net/Resolver.h"
+#include "cold/time/Timer.h"
+
+using namespace Cold;
+
+namespace {
+
+// the attempts of one ConnectFirst. the attempts in flight share it, the
+// sockets of the losers are closed when the last one completes
+struct Race {
+  explicit Race(Base::IoService& s) : service(&s) {}
+
+  Base::IoService* service;
+  std::vector<std::unique_ptr<Net::TcpSocket>> sockets;
+  size_t running = 0;
+  std::optional<size_t> winner;
+  // without an address
+  int lastError = EHOSTUNREACH;
+  // bumped by the completions and by the stagger timer
+  uint64_t events = 0;
+  std::coroutine_handle<> waiter;
+  // a ResumeWaiter is spawned already
+  bool waking = false;
+};
+
+Base::Task<> ResumeWaiter(std::shared_ptr<Race> race) {
+  race->waking = false;
+  if (auto waiter = std::exchange(race->waiter, nullptr)) waiter.resume();
+  co_return;
+}
+
+// the waiter is resumed from the loop. resumed here, ConnectFirst and its
+// caller would run on the stack of the attempt or the timer
+void Notify(const std::shared_ptr<Race>& race) {
+  ++race->events;
+  if (race->waiter && !race->waking) {
+    race->waking = true;
+    race->service->CoSpawn(ResumeWaiter(race));
+  }
+}
+
+// an event of the race after the first seen ones
+struct RaceAwaiter {
+  Race& race;
+  uint64_t seen;
+
+  bool await_ready() const noexcept { return race.events != seen; }
+  void await_suspend(std::coroutine_handle<> handle) noexcept {
+    race.waiter = handle;
+  }
+  void await_resume() const noexcept {}
+};
+
+Base::Task<> DoAttempt(std::shared_ptr<Race> race, size_t index,
+                       Net::IpAddress addr) {
+  auto ret = co_await race->sockets[index]->Connect(addr);
+  --race->running;
+  // cancelled, or established after the winner
+  if (race->winner) co_return;
+  if (ret < 0) {
+    race->lastError = errno;
+  } else {
+    race->winner = index;
+  }
+  Notify(race);
+}
+
+Base::Task<> WakeUp(std::shared_ptr<Race> race) {
+  Notify(race);
+  co_return;
+}
+
+// the families alternate, starting with the one of the first address
+std::vector<Net::IpAddress> Interleave(
+    const std::vector<Net::IpAddress>& addrs) {
+  std::vector<Net::IpAddress> first;
+  std::vector<Net::IpAddress> second;
+  for (auto& addr : addrs) {
+    if (addr.IsIpv6() == addrs[0].IsIpv6()) {
+      first.push_back(addr);
+    } else {
+      second.push_back(addr);
+    }
+  }
+  std::vector<Net::IpAddress> result;
+  for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+    if (i < first.size()) result.push_back(first[i]);
+    if (i < second.size()) result.push_back(second[i]);
+  }
+  return result;
+}
+
+}  // namespace
+
+Base::Task<> Net::TcpClient::ConnectAny(std::string host, uint16_t port,
+                                        std::chrono::milliseconds stagger) {
+  auto addrs = co_await Resolver::Resolve(socket_.GetIoService(),
+                                          std::move(host), port,
+                                          Resolver::Family::kAny);
+  co_await ConnectAny(std::move(addrs), stagger);
+}
+
+Base::Task<std::optional<Net::TcpSocket>> Net::TcpClient::ConnectFirst(
+    Base::IoService& service, std::vector<IpAddress> addrs,
+    std::chrono::milliseconds stagger, bool enableSSL) {
+  addrs = Interleave(addrs);
+  auto race = std::make_shared<Race>(service);
+  Base::Timer timer(service);
+  size_t next = 0;
+  // one event per round, several may come before the waiter is resumed
+  uint64_t handled = 0;
+  while (true) {
+    if (next < addrs.size()) {
+      auto& addr = addrs[next];
+      race->sockets.push_back(
+          std::make_unique<TcpSocket>(service, enableSSL, addr.IsIpv6()));
+      ++race->running;
+      service.CoSpawn(DoAttempt(race, next, addr));
+      ++next;
+      timer.Cancel();
+      if (next < addrs.size()) {
+        timer.ExpiresAfter(stagger);
+        timer.AsyncWait(WakeUp(race));
+      }
+    } else if (race->running == 0) {
+      break;
+    }
+    // a failure or the timer starts the next attempt
+    RaceAwaiter awaiter{*race, handled};
+    co_await awaiter;
+    ++handled;
+    if (race->winner) break;
+  }
+  timer.Cancel();
+  if (!race->winner) {
+    errno = race->lastError;
+    co_return std::nullopt;
+  }
+  // shutdown aborts a connect in progress and wakes its attempt
+  for (size_t i = 0; i < race->sockets.size(); ++i) {
+    auto& socket = *race->sockets[i];
+    if (i != *race->winner && socket.IsValid()) {
+      shutdown(socket.NativeHandle(), SHUT_RDWR);
+    }
+  }
+  std::optional<TcpSocket> winner(std::move(*race->sockets[*race->winner]));
+  co_return winner;
+}
@@ -1,12 +1,20 @@
 #ifndef COLD_NET_TCPCLIENT
 #define COLD_NET_TCPCLIENT
 
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "cold/net/TcpSocket.h"
 
 namespace Cold::Net {
 
 class TcpClient {
  public:
+  // the connection attempt delay of RFC 8305
+  constexpr static std::chrono::milliseconds kDefaultStagger{250};
+
   TcpClient(Base::IoService& service, bool enableSSL = false, bool ipv6 = false)
       : socket_(service, enableSSL, ipv6) {}
 
@@ -24,18 +32,37 @@ class TcpClient {
       co_await OnConnectFailed();
       co_return;
     }
-#ifdef COLD_NET_ENABLE_SSL
-    if (socket_.IsEnableSSL()) {
-      bool ok = co_await socket_.DoHandshake();
-      if (!ok) {
-        co_await OnConnectFailed();
-        co_return;
-      }
+    co_await FinishConnect();
+  }
+
+  // happy eyeballs (RFC 8305). the addresses are tried in turn, ipv6 and
+  // ipv4 interleaved. a new attempt starts every stagger, or at once when
+  // the ones in flight have failed. the first established connection wins
+  // and the others are cancelled
+  Base::Task<> ConnectAny(std::vector<IpAddress> addrs,
+                          std::chrono::milliseconds stagger = kDefaultStagger) {
+    auto winner = co_await ConnectFirst(socket_.GetIoService(),
+                                        std::move(addrs), stagger,
+                                        socket_.IsEnableSSL());
+    if (!winner) {
+      co_await OnConnectFailed();
+      co_return;
     }
-#endif
-    co_await OnConnect();
+    socket_ = std::move(*winner);
+    co_await FinishConnect();
   }
 
+  // the addresses of host, ipv6 and ipv4, by Resolver
+  Base::Task<> ConnectAny(std::string host, uint16_t port,
+                          std::chrono::milliseconds stagger = kDefaultStagger);
+
+  // the race of ConnectAny. the established socket, or nullopt with errno
+  // set by the last attempt
+  static Base::Task<std::optional<TcpSocket>> ConnectFirst(
+      Base::IoService& service, std::vector<IpAddress> addrs,
+      std::chrono::milliseconds stagger = kDefaultStagger,
+      bool enableSSL = false);
+
  protected:
   TcpSocket& GetSocket() { return socket_; }
 
@@ -60,6 +87,20 @@ class TcpClient {
   }
 
   TcpSocket socket_;
+
+ private:
+  Base::Task<> FinishConnect() {
+#ifdef COLD_NET_ENABLE_SSL
+    if (socket_.IsEnableSSL()) {
+      bool ok = co_await socket_.DoHandshake();
+      if (!ok) {
+        co_await OnConnectFailed();
+        co_return;
+      }
+    }
+#endif
+    co_await OnConnect();
+  }
 };
 
 }  // namespace Cold::Net
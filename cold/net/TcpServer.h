@@ -4,7 +4,9 @@
 #include "cold/coro/IoServicePool.h"
 #include "cold/net/Acceptor.h"
 #include "cold/net/IpAddress.h"
+#include "cold/net/SocketOptions.h"
 #include "cold/net/TcpSocket.h"
+#include "cold/util/Config.h"
 
 namespace Cold::Net {
 
@@ -13,7 +15,23 @@ class TcpServer {
   TcpServer(const Net::IpAddress& addr, size_t poolSize = 0,
             bool reusePort = false, bool enableSSL = false)
       : pool_(poolSize),
-        acceptor_(pool_.GetMainIoService(), addr, reusePort, enableSSL) {}
+        acceptor_(pool_.GetMainIoService(), addr, reusePort, enableSSL),
+        addr_(addr),
+        reusePort_(reusePort),
+        enableSSL_(enableSSL) {
+    ReadConfig();
+  }
+
+  // listen on an AF_UNIX stream socket, see Acceptor. the reuseport
+  // acceptors are not available
+  TcpServer(const Net::UnixAddress& addr, size_t poolSize = 0,
+            bool enableSSL = false)
+      : pool_(poolSize),
+        acceptor_(pool_.GetMainIoService(), addr, enableSSL),
+        reusePort_(false),
+        enableSSL_(enableSSL) {
+    ReadConfig();
+  }
 
   virtual ~TcpServer() = default;
 
@@ -24,24 +42,99 @@ class TcpServer {
     if (started_) {
       Base::FATAL("TcpServer: Already started");
     }
-    acceptor_.Listen();
-    pool_.GetMainIoService().CoSpawn(DoAccept());
+    if (reusePortAcceptors_ && (!reusePort_ || pool_.GetPoolSize() == 0)) {
+      Base::WARN("TcpServer: reuseport acceptors need reusePort and a pool");
+      reusePortAcceptors_ = false;
+    }
+    if (reusePortAcceptors_) {
+      StartReusePortAcceptors();
+    } else {
+      acceptor_.Listen();
+      pool_.GetMainIoService().CoSpawn(DoAccept());
+    }
     started_ = true;
     pool_.Start();
   }
 
   bool IsStarted() const { return started_; }
 
+  // run each connection in the worker pinned to the cpu which received
+  // its packets (SO_INCOMING_CPU). the workers need a cpu affinity, see
+  // IoServicePool::SetCpuAffinity. must be called before Start
+  void EnableIncomingCpuSteering(bool on) {
+    assert(!started_);
+    incomingCpuSteering_ = on;
+  }
+
+  bool IsIncomingCpuSteeringEnabled() const { return incomingCpuSteering_; }
+
+  // every worker of the pool listens on its own SO_REUSEPORT socket and
+  // accepts locally, the kernel spreads the connections over them. needs
+  // reusePort and a pool. with cpuSteering, a cbpf program chooses the
+  // listener of worker cpu % pool size by the cpu which received the SYN,
+  // see IoServicePool::PinWorkersToCpus. must be called before Start
+  void EnableReusePortAcceptors(bool on, bool cpuSteering = false) {
+    assert(!started_);
+    reusePortAcceptors_ = on;
+    reusePortCpuSteering_ = cpuSteering;
+  }
+
+  bool IsReusePortAcceptorsEnabled() const { return reusePortAcceptors_; }
+
  protected:
+  // the connections are spread over the pool by its dispatch policy, see
+  // IoServicePool::SetDispatchPolicy
   virtual Base::Task<> DoAccept() {
+    std::vector<std::pair<int, Net::IpAddress>> connections;
     while (true) {
-      auto socket = co_await acceptor_.Accept();
-      if (socket) {
-        socket.GetIoService().CoSpawn(OnConnect(std::move(socket)));
+      co_await acceptor_.AcceptFdBatch(connections);
+      for (auto& [sockfd, addr] : connections) {
+        auto& service = SelectIoService(sockfd, addr);
+        // counted here, so a burst of connections sees the load at once
+        service.AddConnection();
+        // the socket is created in the thread of its IoService
+        service.CoSpawn(HandleConnection(service, sockfd, std::move(addr)));
       }
     }
   }
 
+  Base::IoService& SelectIoService(int sockfd, const Net::IpAddress& addr) {
+    if (incomingCpuSteering_) {
+      SocketOptions::IncomingCpu cpu;
+      if (getsockopt(sockfd, cpu.level, cpu.optName, &cpu.value, &cpu.len) ==
+          0) {
+        return pool_.GetIoServiceForCpu(cpu.value);
+      }
+    }
+    return pool_.SelectIoService(addr.HashIp());
+  }
+
+  // the accept loop of a worker in the reuseport mode
+  Base::Task<> DoAcceptLocal(Net::Acceptor& acceptor) {
+    auto& service = acceptor.GetIoService();
+    std::vector<std::pair<int, Net::IpAddress>> connections;
+    while (true) {
+      co_await acceptor.AcceptFdBatch(connections);
+      for (auto& [sockfd, addr] : connections) {
+        service.AddConnection();
+        service.CoSpawn(
+            HandleConnection(service, sockfd, std::move(addr), acceptor));
+      }
+    }
+  }
+
+  Base::Task<> HandleConnection(Base::IoService& service, int sockfd,
+                                Net::IpAddress addr) {
+    return HandleConnection(service, sockfd, std::move(addr), acceptor_);
+  }
+
+  Base::Task<> HandleConnection(Base::IoService& service, int sockfd,
+                                Net::IpAddress addr, Net::Acceptor& acceptor) {
+    auto socket = co_await acceptor.MakeSocket(service, sockfd, addr);
+    if (socket) co_await OnConnect(std::move(socket));
+    service.RemoveConnection();
+  }
+
   virtual Base::Task<> OnConnect(Net::TcpSocket socket) {
     Base::INFO("TcpServer: Connection accepted. addr: {}",
                socket.GetRemoteAddress().GetIpPort());
@@ -51,8 +144,51 @@ class TcpServer {
   Base::IoServicePool pool_;
 
  private:
+  void ReadConfig() {
+    auto& config = Base::Config::GetGloablDefaultConfig();
+    if (config.Contains("/net/incoming-cpu-steering")) {
+      incomingCpuSteering_ =
+          config.GetConfig("/net/incoming-cpu-steering").get<bool>();
+    }
+    if (config.Contains("/net/reuseport-acceptors")) {
+      reusePortAcceptors_ =
+          config.GetConfig("/net/reuseport-acceptors").get<bool>();
+    }
+    if (config.Contains("/net/reuseport-cpu-steering")) {
+      reusePortCpuSteering_ =
+          config.GetConfig("/net/reuseport-cpu-steering").get<bool>();
+    }
+  }
+
+  void StartReusePortAcceptors() {
+    // the workers are not running yet, so their watchers can be used here.
+    // the listen order is the index in the reuseport group
+    for (size_t i = 0; i < pool_.GetPoolSize(); ++i) {
+      auto& service = pool_.GetIoServiceForHash(i);
+      acceptors_.push_back(
+          std::make_unique<Net::Acceptor>(service, addr_, true, enableSSL_));
+      acceptors_.back()->Listen();
+    }
+    if (reusePortCpuSteering_ &&
+        !acceptors_.front()->AttachReusePortCpuProgram(acceptors_.size())) {
+      Base::WARN("TcpServer: Cannot attach reuseport program. reason: {}",
+                 Base::ThisThread::ErrorMsg());
+    }
+    for (auto& acceptor : acceptors_) {
+      acceptor->GetIoService().CoSpawn(DoAcceptLocal(*acceptor));
+    }
+  }
+
   Net::Acceptor acceptor_;
+  // one per worker in the reuseport mode
+  std::vector<std::unique_ptr<Net::Acceptor>> acceptors_;
+  Net::IpAddress addr_;
+  bool reusePort_;
+  bool enableSSL_;
+  bool reusePortAcceptors_ = false;
+  bool reusePortCpuSteering_ = false;
   bool started_ = false;
+  bool incomingCpuSteering_ = false;
 };
 
 }  // namespace Cold::Net
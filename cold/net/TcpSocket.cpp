@@ -0,0 +1,154 @@
+#include "cold/net/TcpSocket.h"
+
+#include <unistd.h>
+
+#include "cold/net/SocketOptions.h"
+
+using namespace Cold;
+
+namespace {
+
+// ids wrap around
+bool IdBefore(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+}  // namespace
+
+Net::TcpSocket::~TcpSocket() { LingerIfZeroCopyPending(); }
+
+Net::TcpSocket& Net::TcpSocket::operator=(TcpSocket&& other) {
+  if (this == &other) return *this;
+  LingerIfZeroCopyPending();
+  BasicSocket::operator=(std::move(other));
+  zeroCopy_ = std::move(other.zeroCopy_);
+  return *this;
+}
+
+void Net::TcpSocket::LingerIfZeroCopyPending() {
+  if (!zeroCopy_ || zeroCopy_->held.empty() || fd_ < 0) return;
+  // the kernel may still send from the held data
+  ioService_->CoSpawn(LingerZeroCopy(ioService_, fd_, std::move(zeroCopy_)));
+  fd_ = -1;
+}
+
+bool Net::TcpSocket::EnableZeroCopy(size_t threshold) {
+  // tls encrypts into its own buffer, there is nothing to send in place
+  if (ssl_) return false;
+  if (!zeroCopy_) {
+    if (!SetOption(SocketOptions::ZeroCopy(true))) return false;
+    zeroCopy_ = std::make_unique<ZeroCopyState>();
+    // EPOLLERR now means a completion, route it to the error waiter
+    ioService_->ListenErrorEvent(fd_, std::noop_coroutine());
+  }
+  zeroCopy_->threshold = threshold;
+  zeroCopy_->enabled = true;
+  return true;
+}
+
+Base::Task<ssize_t> Net::TcpSocket::SendZeroCopy(const char* buf, size_t n) {
+  if (!IsZeroCopyEnabled() || n < zeroCopy_->threshold) {
+    co_return co_await WriteN(buf, n);
+  }
+  auto ret = co_await DoSendZeroCopy(buf, n);
+  // the ids already taken still pin buf when a send failed
+  auto ok = co_await WaitZeroCopyCompletions(zeroCopy_->nextId);
+  if (!ok) co_return -1;
+  co_return ret;
+}
+
+Base::Task<ssize_t> Net::TcpSocket::SendZeroCopy(std::string data) {
+  if (!IsZeroCopyEnabled() || data.size() < zeroCopy_->threshold) {
+    co_return co_await WriteN(data.data(), data.size());
+  }
+  auto& state = *zeroCopy_;
+  ReapZeroCopyCompletions();
+  // references to deque elements survive push_back and pop_front
+  auto& entry = state.held.emplace_back(
+      ZeroCopyState::HeldData{0, true, std::move(data)});
+  auto ret = co_await DoSendZeroCopy(entry.data.data(), entry.data.size());
+  entry.endId = state.nextId;
+  entry.sending = false;
+  state.Release();
+  co_return ret;
+}
+
+Base::Task<bool> Net::TcpSocket::WaitZeroCopyCompletions() {
+  if (!zeroCopy_) co_return true;
+  co_return co_await WaitZeroCopyCompletions(zeroCopy_->nextId);
+}
+
+Base::Task<ssize_t> Net::TcpSocket::DoSendZeroCopy(const char* buf,
+                                                   size_t n) {
+  auto& state = *zeroCopy_;
+  size_t byteAlreadyWrite = 0;
+  while (byteAlreadyWrite < n) {
+    auto ret = co_await SendZeroCopyAwaitable(
+        ioService_, fd_, buf + byteAlreadyWrite, n - byteAlreadyWrite,
+        connected_);
+    if (ret > 0) {
+      ++state.nextId;
+      state.completed.push_back(false);
+    } else if (ret < 0 && errno == ENOBUFS) {
+      // the pending completions used up the option memory of the socket
+      ret = co_await Write(buf + byteAlreadyWrite, n - byteAlreadyWrite);
+    }
+    if (ret < 0) co_return ret;
+    byteAlreadyWrite += static_cast<size_t>(ret);
+  }
+  co_return static_cast<ssize_t>(n);
+}
+
+void Net::TcpSocket::ReapZeroCopyCompletions() {
+  auto& state = *zeroCopy_;
+  // await_ready reads the queued completions and never waits
+  ZeroCopyCompletionAwaitable reap(ioService_, fd_, state.completions);
+  if (reap.await_ready()) state.Complete();
+}
+
+Base::Task<bool> Net::TcpSocket::WaitZeroCopyCompletions(uint32_t endId) {
+  auto& state = *zeroCopy_;
+  while (IdBefore(state.firstPendingId, endId)) {
+    auto n = co_await ZeroCopyCompletionAwaitable(ioService_, fd_,
+                                                  state.completions);
+    if (n == 0 && errno != EAGAIN) co_return false;
+    state.Complete();
+  }
+  co_return true;
+}
+
+Base::Task<> Net::TcpSocket::LingerZeroCopy(
+    Base::IoService* service, int fd, std::unique_ptr<ZeroCopyState> state) {
+  while (!state->held.empty()) {
+    auto n = co_await IoTimeoutAwaitable(
+        service, ZeroCopyCompletionAwaitable(service, fd, state->completions),
+        kZeroCopyLingerTime);
+    if (n == 0 && errno != EAGAIN) break;
+    state->Complete();
+  }
+  service->StopListeningAll(fd);
+  close(fd);
+}
+
+void Net::TcpSocket::ZeroCopyState::Complete() {
+  for (const auto& completion : completions) {
+    if (completion.copied) enabled = false;
+    for (auto id = completion.lo;; ++id) {
+      auto offset = static_cast<size_t>(id - firstPendingId);
+      if (offset < completed.size()) completed[offset] = true;
+      if (id == completion.hi) break;
+    }
+  }
+  while (!completed.empty() && completed.front()) {
+    completed.pop_front();
+    ++firstPendingId;
+  }
+  Release();
+}
+
+void Net::TcpSocket::ZeroCopyState::Release() {
+  while (!held.empty() && !held.front().sending &&
+         !IdBefore(firstPendingId, held.front().endId)) {
+    held.pop_front();
+  }
+}
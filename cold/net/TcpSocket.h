@@ -1,7 +1,13 @@
 #ifndef COLD_NET_TCPSOCKET
 #define COLD_NET_TCPSOCKET
 
+#include <algorithm>
 #include <atomic>
+#include <climits>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "cold/coro/IoService.h"
 #include "cold/log/Logger.h"
@@ -35,9 +41,12 @@ class TcpSocket : public Net::BasicSocket {
   }
 
   TcpSocket(TcpSocket&& other) = default;
-  TcpSocket& operator=(TcpSocket&& other) = default;
+  // the old fd lingers like in the destructor
+  TcpSocket& operator=(TcpSocket&& other);
 
-  ~TcpSocket() override = default;
+  // data of zero copy sends not yet completed is kept, with the fd, until
+  // the kernel releases it
+  ~TcpSocket() override;
 
   void Close() override {
     BasicSocket::Close();
@@ -84,6 +93,82 @@ class TcpSocket : public Net::BasicSocket {
     co_return static_cast<ssize_t>(n);
   }
 
+  // write every byte of the buffers. a short write goes on from the first
+  // unwritten byte. return the total, or -1 on error
+  [[nodiscard]] Base::Task<ssize_t> WriteVN(const struct iovec* iov,
+                                            int iovcnt) {
+    std::vector<struct iovec> pending(iov, iov + iovcnt);
+    size_t total = 0;
+    for (const auto& buf : pending) total += buf.iov_len;
+    size_t index = 0;
+    size_t byteAlreadyWrite = 0;
+    while (byteAlreadyWrite < total) {
+      auto count = std::min(pending.size() - index, size_t{IOV_MAX});
+      auto ret =
+          co_await WriteV(pending.data() + index, static_cast<int>(count));
+      if (ret < 0) co_return ret;
+      byteAlreadyWrite += static_cast<size_t>(ret);
+      AdvanceIovecs(pending, index, static_cast<size_t>(ret));
+    }
+    co_return static_cast<ssize_t>(total);
+  }
+
+  template <typename REP, typename PERIOD>
+  [[nodiscard]] Base::Task<ssize_t> WriteVNWithTimeout(
+      const struct iovec* iov, int iovcnt,
+      std::chrono::duration<REP, PERIOD> duration) {
+    std::vector<struct iovec> pending(iov, iov + iovcnt);
+    size_t total = 0;
+    for (const auto& buf : pending) total += buf.iov_len;
+    size_t index = 0;
+    size_t byteAlreadyWrite = 0;
+    while (byteAlreadyWrite < total) {
+      auto count = std::min(pending.size() - index, size_t{IOV_MAX});
+      auto ret = co_await WriteVWithTimeout(
+          pending.data() + index, static_cast<int>(count), duration);
+      if (ret < 0) co_return ret;
+      byteAlreadyWrite += static_cast<size_t>(ret);
+      AdvanceIovecs(pending, index, static_cast<size_t>(ret));
+    }
+    co_return static_cast<ssize_t>(total);
+  }
+
+  constexpr static size_t kDefaultZeroCopyThreshold = 16 * 1024;
+  // a destroyed socket gives up its held data after this long without a
+  // completion
+  constexpr static auto kZeroCopyLingerTime = std::chrono::seconds(10);
+
+  // opt in to MSG_ZEROCOPY. SendZeroCopy of less than threshold bytes
+  // copies like Write, pinning the pages does not pay off for them. fail
+  // on a tls socket or a kernel without SO_ZEROCOPY. completions are
+  // queued as socket errors, they only wake the completion waiter and never
+  // a pending Read or Write
+  bool EnableZeroCopy(size_t threshold = kDefaultZeroCopyThreshold);
+
+  // false after the kernel reported a zero copy send as copied, e.g. on
+  // loopback or through a device without scatter gather. then sending
+  // from user pages only adds the completion overhead and later sends copy
+  bool IsZeroCopyEnabled() const { return zeroCopy_ && zeroCopy_->enabled; }
+
+  // number of zero copy sends the kernel has not released yet
+  size_t PendingZeroCopySends() const {
+    return zeroCopy_ ? zeroCopy_->completed.size() : 0;
+  }
+
+  // send n bytes of buf without copying them into the kernel. return when
+  // the kernel released buf, so buf may be reused right after. return n, or
+  // -1 on error
+  [[nodiscard]] Base::Task<ssize_t> SendZeroCopy(const char* buf, size_t n);
+
+  // send data without copying it into the kernel. data is kept until the
+  // kernel releases it, so this returns once data is queued. return the
+  // size of data, or -1 on error
+  [[nodiscard]] Base::Task<ssize_t> SendZeroCopy(std::string data);
+
+  // wait until the kernel released every zero copy send. return false on
+  // error
+  [[nodiscard]] Base::Task<bool> WaitZeroCopyCompletions();
+
 #ifdef COLD_NET_ENABLE_SSL
   [[nodiscard]] Base::Task<bool> DoHandshake() {
     assert(ssl_);
@@ -102,6 +187,62 @@ class TcpSocket : public Net::BasicSocket {
     co_return true;
   }
 #endif
+
+ protected:
+  // an fd of any stream family, not connected yet
+  TcpSocket(Base::IoService& service, int fd, bool enableSSL)
+      : BasicSocket(service, fd, enableSSL) {}
+
+ private:
+  struct ZeroCopyState {
+    struct HeldData {
+      // the data is released once the ids before endId completed
+      uint32_t endId;
+      bool sending;
+      std::string data;
+    };
+
+    // mark the ids of completions and release the data no send pins anymore
+    void Complete();
+    void Release();
+
+    size_t threshold = 0;
+    bool enabled = true;
+    // id of the next zero copy send
+    uint32_t nextId = 0;
+    // ids before it completed
+    uint32_t firstPendingId = 0;
+    // the completion of ids firstPendingId to nextId
+    std::deque<bool> completed;
+    std::deque<HeldData> held;
+    std::vector<ZeroCopyCompletion> completions;
+  };
+
+  // send every byte with MSG_ZEROCOPY. return n, or -1 on error
+  Base::Task<ssize_t> DoSendZeroCopy(const char* buf, size_t n);
+  // read the completions already queued without waiting
+  void ReapZeroCopyCompletions();
+  // wait until the ids before endId completed
+  Base::Task<bool> WaitZeroCopyCompletions(uint32_t endId);
+  static Base::Task<> LingerZeroCopy(Base::IoService* service, int fd,
+                                     std::unique_ptr<ZeroCopyState> state);
+  // hand the fd and the held data to LingerZeroCopy if a zero copy send is
+  // not completed yet. the fd is closed there
+  void LingerIfZeroCopyPending();
+
+  // drop n written bytes from the front of iov[index...]
+  static void AdvanceIovecs(std::vector<struct iovec>& iov, size_t& index,
+                            size_t n) {
+    while (index < iov.size() && n >= iov[index].iov_len) {
+      n -= iov[index].iov_len;
+      ++index;
+    }
+    if (n == 0) return;
+    iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + n;
+    iov[index].iov_len -= n;
+  }
+
+  std::unique_ptr<ZeroCopyState> zeroCopy_;
 };
 
 }  // namespace Cold::Net
@@ -0,0 +1,176 @@
+#ifndef COLD_NET_UDPSERVER
+#define COLD_NET_UDPSERVER
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "cold/coro/IoServicePool.h"
+#include "cold/net/Buffer.h"
+#include "cold/net/IpAddress.h"
+#include "cold/net/SocketOptions.h"
+#include "cold/net/UdpSocket.h"
+#include "cold/time/Timer.h"
+#include "cold/util/Config.h"
+
+namespace Cold::Net {
+
+// every worker of the pool, or the main IoService without a pool, binds its
+// own SO_REUSEPORT UdpSocket to addr and receives in batches, the kernel
+// spreads the flows over the sockets. each datagram goes to OnDatagram.
+class UdpServer {
+ public:
+  // buffers per RecvBatch
+  constexpr static size_t kRecvBatch = 32;
+  // with GRO a buffer holds up to 64K of coalesced datagrams
+  constexpr static size_t kGroBufferSize = 65536;
+  // pause after a receive error which may last, e.g. ENOMEM
+  constexpr static auto kRecvErrorBackoff = std::chrono::milliseconds(10);
+
+  UdpServer(const Net::IpAddress& addr, size_t poolSize = 0)
+      : pool_(poolSize), addr_(addr) {
+    auto& config = Base::Config::GetGloablDefaultConfig();
+    if (config.Contains("/net/udp-gro")) {
+      gro_ = config.GetConfig("/net/udp-gro").get<bool>();
+    }
+    if (config.Contains("/net/udp-max-datagram-size")) {
+      maxDatagramSize_ =
+          config.GetConfig("/net/udp-max-datagram-size").get<size_t>();
+    }
+  }
+
+  virtual ~UdpServer() = default;
+
+  UdpServer(UdpServer const&) = delete;
+  UdpServer& operator=(UdpServer const&) = delete;
+
+  void Start() {
+    if (started_) {
+      Base::FATAL("UdpServer: Already started");
+    }
+    // the workers are not running yet, so their watchers can be used here
+    auto count = std::max(pool_.GetPoolSize(), size_t(1));
+    for (size_t i = 0; i < count; ++i) {
+      auto& service = pool_.GetIoServiceForHash(i);
+      auto socket = std::make_unique<Net::UdpSocket>(service, addr_.IsIpv6());
+      socket->SetOption(SocketOptions::ReusePort(true));
+      if (!socket->Bind(addr_)) {
+        Base::FATAL("UdpServer: Cannot bind {}. reason: {}", addr_.GetIpPort(),
+                    Base::ThisThread::ErrorMsg());
+      }
+      if (gro_ && !socket->SetOption(SocketOptions::UdpGro(true))) {
+        Base::WARN("UdpServer: Cannot enable UDP_GRO. reason: {}",
+                   Base::ThisThread::ErrorMsg());
+      }
+      sockets_.push_back(std::move(socket));
+    }
+    for (auto& socket : sockets_) {
+      socket->GetIoService().CoSpawn(DoRecv(*socket));
+    }
+    started_ = true;
+    pool_.Start();
+  }
+
+  void Stop() { pool_.Stop(); }
+
+  bool IsStarted() const { return started_; }
+
+  // let the kernel coalesce the datagrams of a flow (UDP_GRO). OnDatagram
+  // still sees them one by one. must be called before Start
+  void EnableGro(bool on) {
+    assert(!started_);
+    gro_ = on;
+  }
+
+  bool IsGroEnabled() const { return gro_; }
+
+  // longer datagrams are truncated. must be called before Start
+  void SetMaxDatagramSize(size_t size) {
+    assert(!started_);
+    maxDatagramSize_ = size;
+  }
+
+  size_t GetMaxDatagramSize() const { return maxDatagramSize_; }
+
+ protected:
+  // data points into the receive buffer of the socket and is valid until
+  // the task returns, the next batch is received after that. copy it to
+  // keep it or to hand it to another task
+  virtual Base::Task<> OnDatagram(Net::UdpSocket& socket,
+                                  std::string_view data,
+                                  const Net::IpAddress& source) {
+    Base::INFO("UdpServer: Datagram received. size: {}, addr: {}",
+               data.size(), source.GetIpPort());
+    co_return;
+  }
+
+  Base::IoServicePool pool_;
+
+ private:
+  // the receive buffers, taken from the BufferPool of the worker
+  struct RecvBuffers {
+    explicit RecvBuffers(size_t size) : msgs(kRecvBatch) {
+      for (auto& msg : msgs) {
+        msg.len = size;
+        msg.data = BufferPool::Allocate(msg.len);
+      }
+    }
+
+    ~RecvBuffers() {
+      for (auto& msg : msgs) {
+        BufferPool::Deallocate(static_cast<char*>(msg.data), msg.len);
+      }
+    }
+
+    RecvBuffers(const RecvBuffers&) = delete;
+    RecvBuffers& operator=(const RecvBuffers&) = delete;
+
+    std::vector<Net::UdpMessage> msgs;
+  };
+
+  Base::Task<> DoRecv(Net::UdpSocket& socket) {
+    RecvBuffers buffers(gro_ ? kGroBufferSize : maxDatagramSize_);
+    auto& msgs = buffers.msgs;
+    while (true) {
+      auto n = co_await socket.RecvBatch(msgs.data(), msgs.size());
+      if (n < 0) {
+        const int error = errno;
+        if (error == EAGAIN || error == EINTR) continue;
+        Base::ERROR("UdpServer: RecvBatch error. reason: {}",
+                    Base::ThisThread::ErrorMsg());
+        // the socket is gone, every later receive fails the same way
+        if (error == EBADF || error == ENOTSOCK) co_return;
+        co_await Base::Sleep(socket.GetIoService(), kRecvErrorBackoff);
+        continue;
+      }
+      for (size_t i = 0; i < static_cast<size_t>(n); ++i) {
+        auto& msg = msgs[i];
+        auto data = static_cast<const char*>(msg.data);
+        auto bytes = std::min(msg.bytes, msg.len);
+        // split what GRO has coalesced
+        size_t segment = msg.segmentSize ? msg.segmentSize : bytes;
+        size_t offset = 0;
+        do {
+          auto size = std::min(segment, bytes - offset);
+          co_await OnDatagram(socket, std::string_view(data + offset, size),
+                              msg.addr);
+          offset += size;
+        } while (offset < bytes);
+      }
+    }
+  }
+
+  Net::IpAddress addr_;
+  // one per worker
+  std::vector<std::unique_ptr<Net::UdpSocket>> sockets_;
+  size_t maxDatagramSize_ = 2048;
+  bool gro_ = false;
+  bool started_ = false;
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_UDPSERVER */
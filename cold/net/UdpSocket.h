@@ -41,6 +41,18 @@ class UdpSocket : public BasicSocket {
     return RecvFromAwaitable(ioService_, fd_, buf, len, source, flags);
   }
 
+  // receive up to count datagrams in one syscall. see UdpMessage
+  auto RecvBatch(UdpMessage* msgs, size_t count) {
+    assert(!connected_);
+    return RecvBatchAwaitable(ioService_, fd_, msgs, count);
+  }
+
+  // send up to count datagrams in one syscall. see UdpMessage
+  auto SendBatch(UdpMessage* msgs, size_t count) {
+    assert(!connected_);
+    return SendBatchAwaitable(ioService_, fd_, msgs, count);
+  }
+
   template <typename REP, typename PERIOD>
   auto SendToWithTimeout(const void* buf, size_t len, const IpAddress& dest,
                          std::chrono::duration<REP, PERIOD> duration,
@@ -56,6 +68,18 @@ class UdpSocket : public BasicSocket {
     return IoTimeoutAwaitable(ioService_, RecvFrom(buf, len, source, flags),
                               duration);
   }
+
+  template <typename REP, typename PERIOD>
+  auto RecvBatchWithTimeout(UdpMessage* msgs, size_t count,
+                            std::chrono::duration<REP, PERIOD> duration) {
+    return IoTimeoutAwaitable(ioService_, RecvBatch(msgs, count), duration);
+  }
+
+  template <typename REP, typename PERIOD>
+  auto SendBatchWithTimeout(UdpMessage* msgs, size_t count,
+                            std::chrono::duration<REP, PERIOD> duration) {
+    return IoTimeoutAwaitable(ioService_, SendBatch(msgs, count), duration);
+  }
 };
 
 }  // namespace Cold::Net
@@ -0,0 +1,31 @@
+#include "cold/net/UnixAddress.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace Cold;
+
+Net::UnixAddress::UnixAddress(std::string_view path) {
+  addr_.sun_family = AF_UNIX;
+  // a file path needs room for the terminating null
+  auto capacity = sizeof addr_.sun_path - (path.starts_with('@') ? 0 : 1);
+  assert(path.size() <= capacity);
+  auto size = std::min(path.size(), capacity);
+  memcpy(addr_.sun_path, path.data(), size);
+  if (path.starts_with('@')) addr_.sun_path[0] = '\0';
+  len_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) +
+                                size + (addr_.sun_path[0] ? 1 : 0));
+}
+
+std::string Net::UnixAddress::GetPath() const {
+  if (IsUnnamed()) return {};
+  auto size = len_ - offsetof(struct sockaddr_un, sun_path);
+  if (IsAbstract()) {
+    std::string path(addr_.sun_path, size);
+    path[0] = '@';
+    return path;
+  }
+  // the kernel may or may not count the null
+  return std::string(addr_.sun_path, strnlen(addr_.sun_path, size));
+}
@@ -0,0 +1,58 @@
+#ifndef COLD_NET_UNIXADDRESS
+#define COLD_NET_UNIXADDRESS
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Cold::Net {
+
+// address of an AF_UNIX socket. a path starting with '@' names a socket in
+// the abstract namespace, which has no file and goes away with its last fd.
+// the default address is unnamed, as the end of a socketpair or a socket
+// which is not bound
+class UnixAddress {
+ public:
+  UnixAddress() { addr_.sun_family = AF_UNIX; }
+
+  // a path longer than sun_path is asserted and truncated
+  explicit UnixAddress(std::string_view path);
+
+  const struct sockaddr* GetSockaddr() const {
+    return reinterpret_cast<const struct sockaddr*>(&addr_);
+  }
+
+  struct sockaddr* GetSockaddr() {
+    return reinterpret_cast<struct sockaddr*>(&addr_);
+  }
+
+  // bytes of the address to pass to bind, connect and sendto
+  socklen_t GetLength() const { return len_; }
+
+  // set by accept, recvfrom and getsockname
+  void SetLength(socklen_t len) { len_ = len; }
+
+  constexpr static socklen_t GetCapacity() {
+    return sizeof(struct sockaddr_un);
+  }
+
+  bool IsUnnamed() const {
+    return len_ <= offsetof(struct sockaddr_un, sun_path);
+  }
+
+  bool IsAbstract() const { return !IsUnnamed() && addr_.sun_path[0] == '\0'; }
+
+  // '@' and the name for the abstract namespace, empty if unnamed
+  std::string GetPath() const;
+
+ private:
+  struct sockaddr_un addr_ {};
+  socklen_t len_ = sizeof(sa_family_t);
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_UNIXADDRESS */
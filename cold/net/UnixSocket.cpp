@@ -0,0 +1,192 @@
+#include "cold/net/UnixSocket.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+
+using namespace Cold;
+
+namespace {
+
+// a cmsghdr member would be a flexible array in the coroutine frame
+struct FdControl {
+  alignas(struct cmsghdr) char buf[CMSG_SPACE(sizeof(int) *
+                                              Net::kMaxPassedFds)];
+};
+
+Base::Task<ssize_t> DoSendFds(Base::IoService* service, int fd,
+                              const void* buf, size_t len,
+                              const std::vector<int>& fds,
+                              const Net::UnixAddress* dest) {
+  assert(fds.size() <= Net::kMaxPassedFds);
+  struct iovec iov {
+    const_cast<void*>(buf), len
+  };
+  struct msghdr msg {};
+  if (dest) {
+    msg.msg_name = const_cast<struct sockaddr*>(dest->GetSockaddr());
+    msg.msg_namelen = dest->GetLength();
+  }
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  FdControl control;
+  if (!fds.empty()) {
+    auto size = sizeof(int) * fds.size();
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(size);
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(size);
+    memcpy(CMSG_DATA(cmsg), fds.data(), size);
+  }
+  ssize_t n = 0;
+  do {
+    n = co_await Net::SendMsgAwaitable(service, fd, &msg, 0);
+    // woken by an event of the other direction
+  } while (n < 0 && errno == EAGAIN);
+  co_return n;
+}
+
+// without fds, fds sent along are closed by the kernel
+Base::Task<ssize_t> DoRecvFds(Base::IoService* service, int fd, void* buf,
+                              size_t len, std::vector<int>* fds,
+                              Net::UnixAddress* source) {
+  struct iovec iov {
+    buf, len
+  };
+  struct msghdr msg {};
+  if (source) {
+    msg.msg_name = source->GetSockaddr();
+    msg.msg_namelen = Net::UnixAddress::GetCapacity();
+  }
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  FdControl control;
+  if (fds) {
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+  }
+  ssize_t n = 0;
+  do {
+    n = co_await Net::RecvMsgAwaitable(service, fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && errno == EAGAIN);
+  if (n < 0) co_return n;
+  if (source) source->SetLength(msg.msg_namelen);
+  if (!fds) co_return n;
+  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    auto begin = fds->size();
+    fds->resize(begin + count);
+    memcpy(fds->data() + begin, CMSG_DATA(cmsg), count * sizeof(int));
+  }
+  if (msg.msg_flags & MSG_CTRUNC) {
+    Base::WARN("Passed fds truncated, at most {} are received",
+               Net::kMaxPassedFds);
+  }
+  co_return n;
+}
+
+}  // namespace
+
+Net::UnixStreamSocket::UnixStreamSocket(Base::IoService& service,
+                                        bool enableSSL)
+    : TcpSocket(service,
+                socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0),
+                enableSSL) {
+  if (fd_ < 0) {
+    Base::ERROR("create UnixStreamSocket error. errno: {} Reason: {}", errno,
+                Base::ThisThread::ErrorMsg());
+  }
+}
+
+std::optional<std::pair<Net::UnixStreamSocket, Net::UnixStreamSocket>>
+Net::UnixStreamSocket::Pair(Base::IoService& service) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                 fds) < 0) {
+    return std::nullopt;
+  }
+  return std::pair(
+      UnixStreamSocket(TcpSocket(service, IpAddress(), IpAddress(), fds[0])),
+      UnixStreamSocket(TcpSocket(service, IpAddress(), IpAddress(), fds[1])));
+}
+
+Base::Task<ssize_t> Net::UnixStreamSocket::SendFds(
+    const void* buf, size_t len, const std::vector<int>& fds) {
+  assert(!ssl_);
+  assert(len > 0);
+  return DoSendFds(ioService_, fd_, buf, len, fds, nullptr);
+}
+
+Base::Task<ssize_t> Net::UnixStreamSocket::RecvFds(void* buf, size_t len,
+                                                   std::vector<int>& fds) {
+  assert(!ssl_);
+  return DoRecvFds(ioService_, fd_, buf, len, &fds, nullptr);
+}
+
+std::optional<struct ucred> Net::UnixStreamSocket::GetPeerCredentials() const {
+  struct ucred cred;
+  socklen_t len = sizeof cred;
+  if (getsockopt(fd_, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+    return std::nullopt;
+  }
+  return cred;
+}
+
+Net::UnixDatagramSocket::UnixDatagramSocket(Base::IoService& service)
+    : BasicSocket(service,
+                  socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0),
+                  false) {
+  if (fd_ < 0) {
+    Base::ERROR("create UnixDatagramSocket error. errno: {}, reason: {}",
+                errno, Base::ThisThread::ErrorMsg());
+    return;
+  }
+  ioService_->ListenReadEvent(fd_, std::noop_coroutine());
+}
+
+Net::UnixDatagramSocket::UnixDatagramSocket(Base::IoService& service, int fd)
+    : BasicSocket(service, fd, false) {
+  connected_ = true;
+  ioService_->ListenReadEvent(fd_, std::noop_coroutine());
+}
+
+std::optional<std::pair<Net::UnixDatagramSocket, Net::UnixDatagramSocket>>
+Net::UnixDatagramSocket::Pair(Base::IoService& service) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) <
+      0) {
+    return std::nullopt;
+  }
+  return std::pair(UnixDatagramSocket(service, fds[0]),
+                   UnixDatagramSocket(service, fds[1]));
+}
+
+Base::Task<ssize_t> Net::UnixDatagramSocket::SendTo(const void* buf,
+                                                    size_t len,
+                                                    const UnixAddress& dest) {
+  static const std::vector<int> kNoFds;
+  return DoSendFds(ioService_, fd_, buf, len, kNoFds, &dest);
+}
+
+Base::Task<ssize_t> Net::UnixDatagramSocket::RecvFrom(void* buf, size_t len,
+                                                      UnixAddress& source) {
+  return DoRecvFds(ioService_, fd_, buf, len, nullptr, &source);
+}
+
+Base::Task<ssize_t> Net::UnixDatagramSocket::SendFds(
+    const void* buf, size_t len, const std::vector<int>& fds,
+    const UnixAddress* dest) {
+  return DoSendFds(ioService_, fd_, buf, len, fds, dest);
+}
+
+Base::Task<ssize_t> Net::UnixDatagramSocket::RecvFds(void* buf, size_t len,
+                                                     std::vector<int>& fds,
+                                                     UnixAddress* source) {
+  return DoRecvFds(ioService_, fd_, buf, len, &fds, source);
+}
@@ -0,0 +1,94 @@
+#ifndef COLD_NET_UNIXSOCKET
+#define COLD_NET_UNIXSOCKET
+
+#include <sys/socket.h>
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cold/coro/Task.h"
+#include "cold/net/TcpSocket.h"
+#include "cold/net/UnixAddress.h"
+
+namespace Cold::Net {
+
+// fds passed in one message at most (SCM_RIGHTS)
+constexpr size_t kMaxPassedFds = 64;
+
+// a connected AF_UNIX stream socket. it is a TcpSocket, so everything built
+// on streams (TcpServer, HttpServer, RpcServer, Splice) takes it as is. a
+// TcpSocket accepted by an AF_UNIX Acceptor becomes one again by moving it
+// into UnixStreamSocket, which adds no state
+class UnixStreamSocket : public TcpSocket {
+ public:
+  UnixStreamSocket() = default;
+
+  // not connected yet, see Connect
+  explicit UnixStreamSocket(Base::IoService& service, bool enableSSL = false);
+
+  explicit UnixStreamSocket(TcpSocket&& socket)
+      : TcpSocket(std::move(socket)) {}
+
+  UnixStreamSocket(UnixStreamSocket&&) = default;
+  UnixStreamSocket& operator=(UnixStreamSocket&&) = default;
+  ~UnixStreamSocket() override = default;
+
+  // a connected pair (socketpair). nullopt on error
+  static std::optional<std::pair<UnixStreamSocket, UnixStreamSocket>> Pair(
+      Base::IoService& service);
+
+  // send len bytes of buf, at least 1, with fds attached. the fds stay open
+  // here. return the bytes sent, -1 on error. not on a tls socket
+  [[nodiscard]] Base::Task<ssize_t> SendFds(const void* buf, size_t len,
+                                            const std::vector<int>& fds);
+
+  // receive up to len bytes, the fds attached are appended to fds with
+  // FD_CLOEXEC set and belong to the caller. return the bytes received, 0
+  // on eof, -1 on error. not on a tls socket
+  [[nodiscard]] Base::Task<ssize_t> RecvFds(void* buf, size_t len,
+                                            std::vector<int>& fds);
+
+  // pid, uid and gid of the peer when it connected (SO_PEERCRED)
+  std::optional<struct ucred> GetPeerCredentials() const;
+};
+
+// an AF_UNIX datagram socket. datagrams are reliable and ordered, and a
+// send blocks instead of dropping when the receiver is full
+class UnixDatagramSocket : public BasicSocket {
+ public:
+  UnixDatagramSocket() = default;
+
+  explicit UnixDatagramSocket(Base::IoService& service);
+
+  UnixDatagramSocket(UnixDatagramSocket&&) = default;
+  UnixDatagramSocket& operator=(UnixDatagramSocket&&) = default;
+  ~UnixDatagramSocket() override = default;
+
+  // a connected pair (socketpair). nullopt on error
+  static std::optional<std::pair<UnixDatagramSocket, UnixDatagramSocket>>
+  Pair(Base::IoService& service);
+
+  [[nodiscard]] Base::Task<ssize_t> SendTo(const void* buf, size_t len,
+                                           const UnixAddress& dest);
+
+  // source is unnamed if the sender is not bound
+  [[nodiscard]] Base::Task<ssize_t> RecvFrom(void* buf, size_t len,
+                                             UnixAddress& source);
+
+  // to the connected peer, or to dest if given
+  [[nodiscard]] Base::Task<ssize_t> SendFds(
+      const void* buf, size_t len, const std::vector<int>& fds,
+      const UnixAddress* dest = nullptr);
+
+  [[nodiscard]] Base::Task<ssize_t> RecvFds(void* buf, size_t len,
+                                            std::vector<int>& fds,
+                                            UnixAddress* source = nullptr);
+
+ private:
+  UnixDatagramSocket(Base::IoService& service, int fd);
+};
+
+}  // namespace Cold::Net
+
+#endif /* COLD_NET_UNIXSOCKET */
@@ -94,7 +94,7 @@ Net::Http::HttpRequest::CreateNewSession() const {
   HttpCookie cookie;
   cookie.key = "SessionId";
   cookie.value = session->GetSessionId();
-  cookie.path = "/";
+  cookie.path = std::string("/");
   cookie.httpOnly = true;
   response_->AddCookie(std::move(cookie));
   return session;
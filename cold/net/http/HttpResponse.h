@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "cold/net/BufferedSocket.h"
 #include "cold/net/TcpSocket.h"
 #include "cold/net/http/HttpCommon.h"
 #include "cold/net/http/RawHttpResponse.h"
@@ -23,6 +24,13 @@ class HttpResponseBody {
       std::map<std::string, std::string>& headers) const = 0;
   // SendComplete should return true else returnf false
   virtual Base::Task<bool> Send(Net::TcpSocket& socket) = 0;
+  // send after the bytes buffered in socket. bodies held in memory override
+  // it to join the headers in one write
+  virtual Base::Task<bool> SendBuffered(Net::BufferedSocket& socket) {
+    auto ok = co_await socket.Flush();
+    if (ok) ok = co_await Send(socket.GetSocket());
+    co_return ok;
+  }
   // for debug
   virtual std::string ToRawBody() const { return ""; }
 };
@@ -40,6 +48,10 @@ class TextBody : public HttpResponseBody {
     co_return n == static_cast<ssize_t>(body_.size());
   }
 
+  Base::Task<bool> SendBuffered(Net::BufferedSocket& socket) override {
+    co_return co_await socket.Write(body_);
+  }
+
   std::string ToRawBody() const override { return body_; }
 
   void SetContent(std::string body) { body_ = std::move(body); }
@@ -130,6 +142,11 @@ class HttpResponse {
     co_return true;
   }
 
+  Base::Task<bool> SendBody(Net::BufferedSocket& socket) {
+    if (body_) co_return co_await body_->SendBuffered(socket);
+    co_return true;
+  }
+
   bool IsKeepAlive() const { return connectionStatus_ == kKeepAlive; }
 
   void SendRedirect(std::string_view url) {
@@ -1,5 +1,6 @@
 #include "cold/net/http/HttpServer.h"
 
+#include "cold/net/BufferedSocket.h"
 #include "cold/net/http/HttpRequestParser.h"
 #include "cold/util/Config.h"
 
@@ -13,23 +14,44 @@ Base::Task<> Net::Http::HttpServer::DoHttp(Net::TcpSocket socket) {
   static const int kWriteTimeoutMs =
       Base::Config::GetGloablDefaultConfig().GetOrDefault(
           "/http/write-timeout-ms", 15000);
+  BufferedSocket stream(socket);
+  stream.SetReadTimeout(std::chrono::milliseconds(kReadTimeoutMs));
+  stream.SetWriteTimeout(std::chrono::milliseconds(kWriteTimeoutMs));
   std::string headerBuf;
-  char buf[65536];
   while (true) {
     HttpResponse response;
-    auto n = co_await socket.ReadWithTimeout(
-        buf, sizeof buf, std::chrono::milliseconds(kReadTimeoutMs));
-    if (n <= 0) {
-      socket.Close();
-      co_return;
+    bool badRequest = false;
+    // answer every pipelined request before reading again. their responses
+    // are coalesced and flushed once
+    if (!parser.HasRequest()) {
+      auto flushed = co_await stream.Flush();
+      if (!flushed) {
+        socket.Close();
+        co_return;
+      }
+      auto n = co_await stream.Fill();
+      if (n <= 0) {
+        socket.Close();
+        co_return;
+      }
+      // llhttp keeps what it needs, so the bytes can go right away
+      auto data = stream.Peek();
+      badRequest = !parser.Parse(data.data(), data.size());
+      stream.Consume(data.size());
+      if (!badRequest && !parser.HasRequest()) continue;
     }
-    if (!parser.Parse(buf, static_cast<size_t>(n))) {  // Bad Request
+    if (badRequest) {  // Bad Request
       response.SetStatus(HttpStatus::BAD_REQUEST);
       response.SetCloseConnection(true);
-    } else if (parser.HasRequest()) {
+    } else {
       auto rawRequest = parser.TakeRequest();
 #ifdef COLD_NET_ENABLE_SSL
       if (wsSeerver_ && wsSeerver_->CheckWhetherUpgradeRequest(rawRequest)) {
+        auto flushed = co_await stream.Flush();
+        if (!flushed) {
+          socket.Close();
+          co_return;
+        }
         co_await wsSeerver_->OnReceivedUpgradeRequest(std::move(rawRequest),
                                                       std::move(socket));
         co_return;
@@ -39,8 +61,6 @@ Base::Task<> Net::Http::HttpServer::DoHttp(Net::TcpSocket socket) {
       response.SetCloseConnection(!request.IsKeepAlive());
       response.SetVersion(std::string(request.GetVersion()));
       context_.ForwardTo(request.GetUrl(), request, response);
-    } else {
-      continue;
     }
     // Send response
     headerBuf.clear();
@@ -52,17 +72,14 @@ Base::Task<> Net::Http::HttpServer::DoHttp(Net::TcpSocket socket) {
         it->second(response);
     }
     response.MakeHeaders(headerBuf);
-    if (co_await socket.WriteNWithTimeout(
-            headerBuf.data(), headerBuf.size(),
-            std::chrono::milliseconds(kWriteTimeoutMs)) <= 0) {
-      socket.Close();
-      co_return;
-    }
-    if (!co_await response.SendBody(socket)) {
+    auto ok = co_await stream.Write(headerBuf);
+    if (ok) ok = co_await response.SendBody(stream);
+    if (!ok) {
       socket.Close();
       co_return;
     }
     if (!response.IsKeepAlive()) {
+      co_await stream.Flush();
       socket.Close();
       co_return;
     }
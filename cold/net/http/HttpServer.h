@@ -14,19 +14,12 @@ class HttpServer : public TcpServer {
  public:
   HttpServer(const Net::IpAddress& addr, size_t poolSize = 0,
              bool reusePort = false, bool enableSSL = false)
-      : TcpServer(addr, poolSize, reusePort, enableSSL) {
-    defaultErrorPageHandler_ = [](HttpResponse& response) {
-      auto body = std::make_unique<TextBody>();
-      auto status = static_cast<int>(response.GetStatus());
-      auto message = response.GetStatusMessage();
-      body->SetContent(fmt::format(
-          "<html><head><title>{} {}</title></head><body><center><h1>{} "
-          "{}</h1></center><hr><center>Cold/1.0.0</center></body></html>",
-          status, message, status, message));
-      response.SetBody(std::move(body));
-      response.SetHeader("Content-type", "text/html;charset=utf-8");
-    };
-  }
+      : TcpServer(addr, poolSize, reusePort, enableSSL) {}
+
+  // serve http on an AF_UNIX socket, see TcpServer
+  HttpServer(const Net::UnixAddress& addr, size_t poolSize = 0,
+             bool enableSSL = false)
+      : TcpServer(addr, poolSize, enableSSL) {}
 
   ~HttpServer() = default;
 
@@ -82,7 +75,18 @@ class HttpServer : public TcpServer {
  private:
   ServletContext context_;
   std::map<HttpStatus, std::function<void(HttpResponse&)>> errorPageHandler_;
-  std::function<void(HttpResponse&)> defaultErrorPageHandler_;
+  std::function<void(HttpResponse&)> defaultErrorPageHandler_ =
+      [](HttpResponse& response) {
+        auto body = std::make_unique<TextBody>();
+        auto status = static_cast<int>(response.GetStatus());
+        auto message = response.GetStatusMessage();
+        body->SetContent(fmt::format(
+            "<html><head><title>{} {}</title></head><body><center><h1>{} "
+            "{}</h1></center><hr><center>Cold/1.0.0</center></body></html>",
+            status, message, status, message));
+        response.SetBody(std::move(body));
+        response.SetHeader("Content-type", "text/html;charset=utf-8");
+      };
 
 #ifdef COLD_NET_ENABLE_SSL
  public:
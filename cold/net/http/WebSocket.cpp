@@ -1,66 +1,65 @@
 #include "cold/net/http/WebSocket.h"
 
+#include "cold/net/BufferedSocket.h"
 #include "cold/net/http/WebSocketParser.h"
 
 using namespace Cold;
 
 Base::Task<> Net::Http::WebSocket::DoRead() {
   WebSocketParser parser;
-  char buf[65536];
-  lastPingTime_ = Base::Time::Now();
+  BufferedSocket reader(socket_);
+  lastPingTime_ = socket_.GetIoService().Now();
   static int timeout = Base::Config::GetGloablDefaultConfig().GetOrDefault(
       "/websocket/pingpong-timeout-second", 10);
   socket_.GetIoService().CoSpawn(SendPing(shared_from_this()));
   while (socket_.IsConnected()) {
-    if (Base::Time::Now() - lastPingTime_ > std::chrono::seconds(timeout)) {
+    if (socket_.GetIoService().Now() - lastPingTime_ >
+        std::chrono::seconds(timeout)) {
       OnError();
       co_return;
     }
-    auto n = co_await socket_.Read(buf, sizeof buf);
+    auto n = co_await reader.Fill();
     if (n <= 0) {
       socket_.Close();
       co_return;
     }
     // parse frame
-    if (!parser.Parse(buf, static_cast<size_t>(n))) {
+    if (!parser.Parse(reader.GetReadBuffer())) {
       OnError();
       co_return;
     }
-    if (!parser.HasFrame()) continue;
-    auto frame = parser.TakeFrame();
-    assert(frame.fin == 1);
-    switch (frame.opcode) {
-      case 0x1:  // text
-      case 0x2:  // binary
-        onRecv_(shared_from_this(), frame.payload.data(), frame.payload.size());
-        break;
-      case 0x8:
-        onClose_(shared_from_this());
-        socket_.Close();
-        break;
-      case 0x9:  // ping
-        SendPong();
-        break;
-      case 0xa:  // pong
-        break;
-      default:
-        OnError();
-        break;
+    // one read may carry several frames
+    while (parser.HasFrame() && socket_.IsConnected()) {
+      auto frame = parser.TakeFrame();
+      assert(frame.fin == 1);
+      switch (frame.opcode) {
+        case 0x1:  // text
+        case 0x2:  // binary
+          onRecv_(shared_from_this(), frame.payload.data(),
+                  frame.payload.size());
+          break;
+        case 0x8:
+          onClose_(shared_from_this());
+          socket_.Close();
+          break;
+        case 0x9:  // ping
+          SendPong();
+          break;
+        case 0xa:  // pong
+          break;
+        default:
+          OnError();
+          break;
+      }
     }
   }
 }
 
 void Net::Http::WebSocket::Send(const char* data, size_t len, bool binary) {
   if (!socket_.IsConnected()) return;
-  auto aa = shared_from_this();
   socket_.GetIoService().CoSpawn(
       [](std::string buf, WebSocketPtr self, bool b) -> Base::Task<> {
-        WebSocketFrame frame;
-        frame.fin = 1;
-        frame.mask = 0;
-        frame.opcode = b ? 0x2 : 0x1;
-        frame.payloadView = buf;
-        WebSocketParser::MakeFrameToBuffer(frame, self->writeTempBuffer_);
+        self->QueueFrame(b ? 0x2 : 0x1, std::move(buf));
         if (self->isWriting_) co_return;
         co_await self->DoWrite();
       }(std::string(data, len), shared_from_this(), binary));
@@ -69,39 +68,76 @@ void Net::Http::WebSocket::Send(const char* data, size_t len, bool binary) {
 void Net::Http::WebSocket::SendPong() {
   if (!socket_.IsConnected()) return;
   socket_.GetIoService().CoSpawn([](WebSocketPtr self) -> Base::Task<> {
-    WebSocketFrame frame;
-    frame.fin = 1;
-    frame.mask = 0;
-    frame.opcode = 0xa;
-    WebSocketParser::MakeFrameToBuffer(frame, self->writeTempBuffer_);
+    self->QueueFrame(0xa);
     if (self->isWriting_) co_return;
     co_await self->DoWrite();
   }(shared_from_this()));
 }
 
+void Net::Http::WebSocket::QueueFrame(uint8_t opcode, std::string payload) {
+  WebSocketFrame frame;
+  frame.fin = 1;
+  frame.mask = 0;
+  frame.opcode = opcode;
+  frame.payloadView = payload;
+  auto header = WebSocketParser::MakeFrameHeader(frame);
+  // a small payload is copied behind its header. a large one keeps its own
+  // chunk and goes out from where it is by writev
+  if (payload.size() <= kInlinePayloadSize) {
+    header.append(payload);
+    writeTempChunks_.push_back(std::move(header));
+  } else {
+    writeTempChunks_.push_back(std::move(header));
+    writeTempChunks_.push_back(std::move(payload));
+  }
+}
+
 Base::Task<> Net::Http::WebSocket::DoWrite() {
   isWriting_ = true;
+  std::vector<struct iovec> iov;
   while (socket_.IsConnected()) {
-    writeBuffer_.swap(writeTempBuffer_);
-    if (writeBuffer_.empty()) break;
-    if (co_await socket_.WriteN(writeBuffer_.data(), writeBuffer_.size()) !=
-        static_cast<ssize_t>(writeBuffer_.size())) {
+    writeChunks_.swap(writeTempChunks_);
+    if (writeChunks_.empty()) break;
+    iov.clear();
+    bool ok = true;
+    for (auto& chunk : writeChunks_) {
+      if (chunk.size() > kInlinePayloadSize && socket_.IsZeroCopyEnabled()) {
+        // a large payload leaves from its chunk without a copy, after the
+        // chunks before it
+        ok = co_await WriteIovecs(iov);
+        if (!ok) break;
+        auto n = co_await socket_.SendZeroCopy(std::move(chunk));
+        ok = n >= 0;
+        if (!ok) break;
+        continue;
+      }
+      iov.push_back({chunk.data(), chunk.size()});
+    }
+    if (ok) {
+      ok = co_await WriteIovecs(iov);
+    }
+    if (!ok) {
       OnError();
       break;
     }
-    writeBuffer_.clear();
+    writeChunks_.clear();
   }
   isWriting_ = false;
 }
 
+Base::Task<bool> Net::Http::WebSocket::WriteIovecs(
+    std::vector<struct iovec>& iov) {
+  size_t total = 0;
+  for (const auto& buf : iov) total += buf.iov_len;
+  auto n = co_await socket_.WriteVN(iov.data(), static_cast<int>(iov.size()));
+  iov.clear();
+  co_return n == static_cast<ssize_t>(total);
+}
+
 void Net::Http::WebSocket::Close() {
   onClose_(shared_from_this());
   socket_.GetIoService().CoSpawn([](WebSocketPtr self) -> Base::Task<> {
-    WebSocketFrame frame;
-    frame.fin = 1;
-    frame.mask = 0;
-    frame.opcode = 0x8;
-    WebSocketParser::MakeFrameToBuffer(frame, self->writeTempBuffer_);
+    self->QueueFrame(0x8);
     if (self->isWriting_) co_return;
     co_await self->DoWrite();
     self->socket_.Close();
@@ -121,12 +157,8 @@ Base::Task<> Net::Http::WebSocket::SendPing(WebSocketPtr self) {
     if (sec < 0) sec = 10;
     timer.ExpiresAfter(std::chrono::seconds(sec));
     co_await timer.AsyncWaitable([](WebSocketPtr s) -> Base::Task<> {
-      s->lastPingTime_ = Base::Time::Now();
-      WebSocketFrame frame;
-      frame.fin = 1;
-      frame.mask = 0;
-      frame.opcode = 0x9;
-      WebSocketParser::MakeFrameToBuffer(frame, s->writeTempBuffer_);
+      s->lastPingTime_ = s->socket_.GetIoService().Now();
+      s->QueueFrame(0x9);
       if (s->isWriting_) co_return;
       co_await s->DoWrite();
     }(self));
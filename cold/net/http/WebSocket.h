@@ -36,8 +36,12 @@ class WebSocket : public std::enable_shared_from_this<WebSocket> {
   // call by server not user
   Base::Task<> DoRead();
   Base::Task<> DoWrite();
+  // write every byte of iov and clear it
+  Base::Task<bool> WriteIovecs(std::vector<struct iovec>& iov);
 
   void SendPong();
+  // append a frame to the chunks of the next DoWrite
+  void QueueFrame(uint8_t opcode, std::string payload = {});
   Base::Task<> SendPing(WebSocketPtr self);
   void OnError();
 
@@ -48,9 +52,11 @@ class WebSocket : public std::enable_shared_from_this<WebSocket> {
   std::function<void(WebSocketPtr, const char* data, size_t len)> onRecv_;
 
   bool isWriting_ = false;
-  std::vector<char> writeTempBuffer_;
-  std::vector<char> writeBuffer_;
-  Base::Time lastPingTime_;
+  constexpr static size_t kInlinePayloadSize = 1024;
+  // frames queued while a write is in flight, and the frames being written
+  std::vector<std::string> writeTempChunks_;
+  std::vector<std::string> writeChunks_;
+  Base::MonoTime lastPingTime_;
 };
 
 }  // namespace Cold::Net::Http
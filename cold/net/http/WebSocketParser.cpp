@@ -7,15 +7,20 @@
 using namespace Cold;
 
 bool Net::Http::WebSocketParser::Parse(const char* data, size_t len) {
-  buffer_.insert(buffer_.end(), data, data + len);
-  auto state = DoParse();
+  buffer_.Append(data, len);
+  return Parse(buffer_);
+}
+
+bool Net::Http::WebSocketParser::Parse(Buffer& buffer) {
+  auto state = DoParse(buffer);
   while (state == kSuccess) {
-    state = DoParse();
+    state = DoParse(buffer);
   }
   return state != kError;
 }
 
-Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse() {
+Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse(
+    Buffer& buffer) {
   if (newFrame_) {
     frames_.push_back({});
   }
@@ -26,29 +31,30 @@ Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse() {
   // 1 + 2 + 8 = 11 byte byte MASK (PAYLOAD LENGTH 7 bit or 2 byte or 8 byte)
   // 4 byte MASKING KEY
   // rest: PAYLOAD DATA == PAYLOAD LENGTH
-  if (buffer_.size() < expectLen) return kNeedMore;
+  if (buffer.ReadableBytes() < expectLen) return kNeedMore;
   // 0     1    2    3    4 5 6 7   0      1  2   3  4  5  6  7  8
   // FIN RSV1 RSV2 RSV3   opcode   mask        payload length
   // fin 1000 0000
-  frame.fin = (buffer_[0] & 0x80);
+  auto data = buffer.Peek();
+  frame.fin = (data[0] & 0x80);
   // rsv for extension ignore it
-  //   int rsv1 = (buffer_[0] & 0x40);
-  //   int rsv2 = (buffer_[0] & 0x20);
-  //   int rsv3 = (buffer_[0] & 0x10);
-  frame.opcode = buffer_[0] & 0x0f;
+  //   int rsv1 = (data[0] & 0x40);
+  //   int rsv2 = (data[0] & 0x20);
+  //   int rsv3 = (data[0] & 0x10);
+  frame.opcode = data[0] & 0x0f;
   // reserved opcode
   if ((3 <= frame.opcode && frame.opcode <= 7) || (frame.opcode == 0xb))
     return kError;
-  frame.mask = (buffer_[1] & 0x80);
+  frame.mask = (data[1] & 0x80);
   expectLen += frame.mask ? 4 : 0;
-  frame.payloadLen = buffer_[1] & 0x7f;
+  frame.payloadLen = data[1] & 0x7f;
   uint8_t more = 0;
   if (frame.payloadLen == 126)
     more = 2;
   else if (frame.payloadLen == 127)
     more = 8;
   expectLen += more;
-  if (buffer_.size() < expectLen) return kNeedMore;
+  if (buffer.ReadableBytes() < expectLen) return kNeedMore;
   char* ptr = nullptr;
   uint16_t payloadLen16 = 0;
   uint64_t payloadLen64 = 0;
@@ -56,17 +62,17 @@ Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse() {
     ptr = more == 2 ? reinterpret_cast<char*>(&payloadLen16)
                     : reinterpret_cast<char*>(&payloadLen64);
     for (size_t i = 0; i < more; ++i) {
-      ptr[i] = buffer_[2 + i];
+      ptr[i] = data[2 + i];
     }
     frame.payloadLen = more == 2 ? Host16ToNetwork16(payloadLen16)
                                  : Host64ToNetwork64(payloadLen64);
   }
   expectLen += frame.payloadLen;
-  if (buffer_.size() < expectLen) return kNeedMore;
+  if (buffer.ReadableBytes() < expectLen) return kNeedMore;
   for (size_t i = 0; i < 4 && frame.mask; ++i) {
-    frame.maskingKey[i] = buffer_[2 + more + i];
+    frame.maskingKey[i] = data[2 + more + i];
   }
-  std::string_view payload(buffer_.data() + 2 + more + (frame.mask ? 4 : 0),
+  std::string_view payload(data + 2 + more + (frame.mask ? 4 : 0),
                            frame.payloadLen);
   frame.payload.reserve(frame.payloadLen);
   if (frame.mask) {
@@ -77,8 +83,7 @@ Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse() {
   } else {
     frame.payload.append(payload);
   }
-  buffer_.erase(buffer_.begin(),
-                buffer_.begin() + static_cast<long>(expectLen));
+  buffer.Consume(expectLen);
   newFrame_ = true;
   if (frame.fin == 1) {
     // merge all frames to last one
@@ -98,9 +103,12 @@ Net::Http::WebSocketParser::ParseState Net::Http::WebSocketParser::DoParse() {
   return kSuccess;
 }
 
-void Net::Http::WebSocketParser::MakeFrameToBuffer(
-    WebSocketFrame& frame, std::vector<char>& writeBuffer) {
-  assert(frame.fin == 1);
+namespace {
+
+// fin, opcode, mask bit and payload length
+template <typename BUFFER>
+void AppendFrameHeader(const Net::Http::WebSocketFrame& frame,
+                       BUFFER& writeBuffer) {
   writeBuffer.push_back(static_cast<char>(0x80 | frame.opcode));
   uint8_t maskAndLen = frame.mask ? 0x80 : 0;
   auto size = frame.payloadView.size();
@@ -110,16 +118,25 @@ void Net::Http::WebSocketParser::MakeFrameToBuffer(
   } else if (size < 65536) {
     maskAndLen |= 126;
     writeBuffer.push_back(static_cast<char>(maskAndLen));
-    uint16_t cur = Host16ToNetwork16(static_cast<uint16_t>(size));
+    uint16_t cur = Net::Host16ToNetwork16(static_cast<uint16_t>(size));
     auto ptr = reinterpret_cast<const char*>(&cur);
     writeBuffer.insert(writeBuffer.end(), ptr, ptr + 2);
   } else {
     maskAndLen |= 127;
-    auto cur = Host64ToNetwork64(static_cast<uint64_t>(size));
+    auto cur = Net::Host64ToNetwork64(static_cast<uint64_t>(size));
     auto ptr = reinterpret_cast<const char*>(&cur);
     writeBuffer.push_back(static_cast<char>(maskAndLen));
     writeBuffer.insert(writeBuffer.end(), ptr, ptr + 8);
   }
+}
+
+}  // namespace
+
+void Net::Http::WebSocketParser::MakeFrameToBuffer(
+    WebSocketFrame& frame, std::vector<char>& writeBuffer) {
+  assert(frame.fin == 1);
+  AppendFrameHeader(frame, writeBuffer);
+  auto size = frame.payloadView.size();
   if (frame.mask) {
     uint8_t maskingKey[4];
     for (size_t i = 0; i < 4; ++i) {
@@ -134,4 +151,12 @@ void Net::Http::WebSocketParser::MakeFrameToBuffer(
     writeBuffer.insert(writeBuffer.end(), frame.payloadView.begin(),
                        frame.payloadView.end());
   }
-}
\ No newline at end of file
+}
+
+std::string Net::Http::WebSocketParser::MakeFrameHeader(
+    const WebSocketFrame& frame) {
+  assert(frame.fin == 1 && !frame.mask);
+  std::string header;
+  AppendFrameHeader(frame, header);
+  return header;
+}
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "cold/net/Buffer.h"
+
 namespace Cold::Net::Http {
 
 struct WebSocketFrame {
@@ -29,9 +31,17 @@ class WebSocketParser {
 
   bool Parse(const char* data, size_t len);
 
+  // parse the frames in buffer in place and consume them. a partial frame
+  // stays in buffer until more bytes arrive
+  bool Parse(Buffer& buffer);
+
   static void MakeFrameToBuffer(WebSocketFrame& frame,
                                 std::vector<char>& writeBuffer);
 
+  // header of an unmasked frame. the payload can then be written from where
+  // it is, without copying it behind the header
+  static std::string MakeFrameHeader(const WebSocketFrame& frame);
+
   bool HasFrame() const { return !completeFrames_.empty(); }
 
   WebSocketFrame TakeFrame() {
@@ -41,8 +51,8 @@ class WebSocketParser {
   }
 
  private:
-  ParseState DoParse();
-  std::vector<char> buffer_;
+  ParseState DoParse(Buffer& buffer);
+  Buffer buffer_;
   std::queue<WebSocketFrame> completeFrames_;
   std::vector<WebSocketFrame> frames_;
   bool newFrame_ = true;
@@ -1,5 +1,6 @@
 #include "cold/net/http/WebSocketServer.h"
 
+#include "cold/net/BufferedSocket.h"
 #include "cold/net/http/HttpRequestParser.h"
 #include "cold/net/http/HttpResponse.h"
 #include "cold/net/http/WebSocket.h"
@@ -12,20 +13,26 @@ Base::Task<> Net::Http::WebSocketServer::StandAloneWsServerContext::OnConnect(
   static const int kReadTimeoutMs =
       Base::Config::GetGloablDefaultConfig().GetOrDefault(
           "/http/read-timeout-ms", 15000);
-  char buf[65536];
+  BufferedSocket reader(socket);
+  reader.SetReadTimeout(std::chrono::milliseconds(kReadTimeoutMs));
+  HttpRequestParser parser;
   while (true) {
-    auto n = co_await socket.ReadWithTimeout(
-        buf, sizeof buf, std::chrono::milliseconds(kReadTimeoutMs));
+    auto n = co_await reader.Fill();
     if (n <= 0) {
       socket.Close();
       co_return;
     }
-    HttpRequestParser parser;
-    if (!parser.Parse(buf, static_cast<size_t>(n))) {
+    // llhttp keeps what it needs, so the bytes can go right away
+    auto data = reader.Peek();
+    auto ok = parser.Parse(data.data(), data.size());
+    reader.Consume(data.size());
+    if (!ok) {
       socket.Close();
+      co_return;
     } else if (parser.HasRequest()) {
       auto rawRequest = parser.TakeRequest();
       onUpgradeRequest_(rawRequest, std::move(socket));
+      co_return;
     }
   }
 }
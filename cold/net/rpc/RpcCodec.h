@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "cold/net/Buffer.h"
 #include "cold/net/Endian.h"
 #include "google/protobuf/message.h"
 
@@ -33,21 +34,21 @@ class RpcCodec {
   RpcCodec& operator=(RpcCodec const&) = delete;
 
   std::pair<bool, std::string_view> ParseMessage(const char* buf, size_t len) {
-    readBuf_.insert(readBuf_.end(), buf, buf + len);
+    readBuf_.Append(buf, len);
     uint64_t messageSize = 0;
-    if (readBuf_.size() < sizeof(messageSize)) return {false, {}};
-    memcpy(&messageSize, readBuf_.data(), sizeof(messageSize));
+    if (readBuf_.ReadableBytes() < sizeof(messageSize)) return {false, {}};
+    memcpy(&messageSize, readBuf_.Peek(), sizeof(messageSize));
     messageSize = Net::Network64ToHost64(messageSize);
-    if (readBuf_.size() < messageSize + sizeof(messageSize)) return {false, {}};
-    return {true, std::string_view{readBuf_.data() + sizeof(messageSize),
+    if (readBuf_.ReadableBytes() < messageSize + sizeof(messageSize)) {
+      return {false, {}};
+    }
+    return {true, std::string_view{readBuf_.Peek() + sizeof(messageSize),
                                    messageSize}};
   }
 
   void TakeMessage(std::string_view message) {
-    assert(readBuf_.size() >= message.size());
-    auto size = message.size() + sizeof(uint64_t);
-    readBuf_.erase(readBuf_.begin(),
-                   readBuf_.begin() + static_cast<long>(size));
+    assert(readBuf_.ReadableBytes() >= message.size());
+    readBuf_.Consume(message.size() + sizeof(uint64_t));
   }
 
   bool WriteMessageToBuffer(const google::protobuf::Message& message) {
@@ -62,13 +63,13 @@ class RpcCodec {
         static_cast<int>(message.ByteSizeLong()));
   }
 
-  const std::vector<char>& GetReadBuffer() const { return readBuf_; }
+  const Buffer& GetReadBuffer() const { return readBuf_; }
   const std::vector<char>& GetWriteBuffer() const { return writeBuf_; }
-  std::vector<char>& GetMutableReadBuffer() { return readBuf_; }
+  Buffer& GetMutableReadBuffer() { return readBuf_; }
   std::vector<char>& GetMutableWriteBuffer() { return writeBuf_; }
 
  private:
-  std::vector<char> readBuf_;
+  Buffer readBuf_;
   std::vector<char> writeBuf_;
 };
 
@@ -18,6 +18,11 @@ class RpcServer : public TcpServer {
             bool reusePort = false, bool enableSSL = false)
       : TcpServer(addr, poolSize, reusePort, enableSSL) {}
 
+  // serve rpc on an AF_UNIX socket, see TcpServer
+  RpcServer(const Net::UnixAddress& addr, size_t poolSize = 0,
+            bool enableSSL = false)
+      : TcpServer(addr, poolSize, enableSSL) {}
+
   ~RpcServer() override = default;
 
   RpcServer(RpcServer const&) = delete;
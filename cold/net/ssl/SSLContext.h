@@ -51,6 +51,9 @@ class SSLContext {
     SSL_load_error_strings();
     context_ = SSL_CTX_new(TLS_method());
     if (!context_) Base::FATAL("SSL_CTX_new failed");
+    // WriteV coalesces the buffers into a new record buffer per call, so a
+    // retried write may come from a different address with the same bytes
+    SSL_CTX_set_mode(context_, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
   }
   SSL_CTX* context_ = nullptr;
   bool certLoaded_ = false;
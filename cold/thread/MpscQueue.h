@@ -0,0 +1,68 @@
+#ifndef COLD_THREAD_MPSCQUEUE
+#define COLD_THREAD_MPSCQUEUE
+
+#include <atomic>
+
+// intrusive multi-producer single-consumer queue from Dmitry Vyukov
+// https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+
+namespace Cold::Base {
+
+struct MpscQueueNode {
+  std::atomic<MpscQueueNode*> mpscNext{nullptr};
+};
+
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  ~MpscQueue() = default;
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // thread safe. wait free
+  void Push(MpscQueueNode* node) {
+    node->mpscNext.store(nullptr, std::memory_order_relaxed);
+    auto prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->mpscNext.store(node, std::memory_order_release);
+  }
+
+  // consumer only. return nullptr when the queue is empty or a producer is
+  // in the middle of Push. use Empty() to tell them apart
+  MpscQueueNode* Pop() {
+    auto tail = tail_;
+    auto next = tail->mpscNext.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->mpscNext.load(std::memory_order_acquire);
+    }
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+    Push(&stub_);
+    next = tail->mpscNext.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  // consumer only
+  bool Empty() const {
+    return tail_ == &stub_ && head_.load(std::memory_order_acquire) == &stub_;
+  }
+
+ private:
+  alignas(64) std::atomic<MpscQueueNode*> head_;
+  alignas(64) MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_THREAD_MPSCQUEUE */
@@ -1,5 +1,6 @@
 #include "cold/thread/Thread.h"
 
+#include <sched.h>
 #include <unistd.h>
 
 #include <cstring>
@@ -37,6 +38,32 @@ const char* Base::ThisThread::ErrorMsg() {
   return strerror_r(errno, t_errorMsg, sizeof(t_errorMsg));
 }
 
+bool Base::ThisThread::SetCpuAffinity(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      errno = EINVAL;
+      return false;
+    }
+    CPU_SET(static_cast<size_t>(cpu), &set);
+  }
+  return sched_setaffinity(0, sizeof set, &set) == 0;
+}
+
+std::vector<int> Base::ThisThread::GetCpuAffinity() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof set, &set) != 0) return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(static_cast<size_t>(cpu), &set)) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+int Base::ThisThread::CurrentCpu() { return sched_getcpu(); }
+
 std::atomic<int> Base::Thread::numCreated_ = 0;
 
 Base::Thread::Thread(ThreadTask task, std::string threadName)
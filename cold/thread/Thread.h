@@ -4,6 +4,7 @@
 #include <atomic>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "cold/thread/Condition.h"
 #include "cold/thread/Lock.h"
@@ -14,6 +15,12 @@ pid_t ThreadId();
 const std::string& ThreadIdStr();
 const std::string& ThreadName();
 const char* ErrorMsg();
+// pin the calling thread to cpus. return false on error
+bool SetCpuAffinity(const std::vector<int>& cpus);
+// the cpus the calling thread is allowed to run on
+std::vector<int> GetCpuAffinity();
+// the cpu the calling thread is running on. -1 on error
+int CurrentCpu();
 }  // namespace ThisThread
 
 class Thread {
@@ -0,0 +1,31 @@
+#include "cold/time/LoopClock.h"
+
+#include <utility>
+
+using namespace Cold;
+
+namespace {
+thread_local const Base::LoopClock* t_loopClock = nullptr;
+}
+
+void Base::LoopClock::Update() {
+  auto mono = ReadMonoTime();
+  auto wall = coarse_ ? Time::NowCoarse() : Time::Now();
+  mono_.store(mono.GetStdTimePoint().time_since_epoch().count(),
+              std::memory_order_relaxed);
+  wall_.store(wall.GetStdTimePoint().time_since_epoch().count(),
+              std::memory_order_relaxed);
+}
+
+const Base::LoopClock* Base::LoopClock::SetThreadClock(
+    const LoopClock* clock) {
+  return std::exchange(t_loopClock, clock);
+}
+
+Base::MonoTime Base::LoopClock::MonoNow() {
+  return t_loopClock ? t_loopClock->GetMonoTime() : MonoTime::Now();
+}
+
+Base::Time Base::LoopClock::WallNow() {
+  return t_loopClock ? t_loopClock->GetWallTime() : Time::Now();
+}
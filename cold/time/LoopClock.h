@@ -0,0 +1,61 @@
+#ifndef COLD_TIME_LOOPCLOCK
+#define COLD_TIME_LOOPCLOCK
+
+#include <atomic>
+#include <cstdint>
+
+#include "cold/time/MonoTime.h"
+#include "cold/time/Time.h"
+
+namespace Cold::Base {
+
+// time of an IoService loop. the loop reads the clocks once per iteration
+// and every timer and log message of the iteration reuses the result, so
+// they cost no clock_gettime
+class LoopClock {
+ public:
+  explicit LoopClock(bool coarse = false) : coarse_(coarse) { Update(); }
+  ~LoopClock() = default;
+
+  LoopClock(const LoopClock&) = delete;
+  LoopClock& operator=(const LoopClock&) = delete;
+
+  // owner thread only
+  void Update();
+
+  // thread safe
+  MonoTime GetMonoTime() const {
+    auto ns = mono_.load(std::memory_order_relaxed);
+    return MonoTime(MonoTime::TimePoint(MonoTime::Clock::duration(ns)));
+  }
+
+  Time GetWallTime() const {
+    auto ns = wall_.load(std::memory_order_relaxed);
+    return Time(Time::TimePoint(Time::Clock::duration(ns)));
+  }
+
+  // read the clock without the cache, from the same source as Update
+  MonoTime ReadMonoTime() const {
+    return coarse_ ? MonoTime::NowCoarse() : MonoTime::Now();
+  }
+
+  bool IsCoarse() const { return coarse_; }
+
+  // the clock of the loop running in the calling thread. IoService sets it
+  // in Start. return the previous one
+  static const LoopClock* SetThreadClock(const LoopClock* clock);
+
+  // cached time of the loop running in the calling thread, otherwise read
+  // the clocks
+  static MonoTime MonoNow();
+  static Time WallNow();
+
+ private:
+  bool coarse_;
+  std::atomic<int64_t> mono_ = 0;
+  std::atomic<int64_t> wall_ = 0;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_TIME_LOOPCLOCK */
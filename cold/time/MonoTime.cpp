@@ -0,0 +1,26 @@
+#include "cold/time/MonoTime.h"
+
+#include <time.h>
+
+#include <cassert>
+#include <cstdio>
+
+using namespace Cold;
+
+Base::MonoTime Base::MonoTime::NowCoarse() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  using namespace std::chrono;
+  auto d = seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+  return MonoTime(TimePoint(duration_cast<Clock::duration>(d)));
+}
+
+std::string Base::MonoTime::Dump() const {
+  auto nano = TimeSinceEpochNanoSeconds();
+  char buf[64];
+  auto sec = static_cast<long long>(nano / Time::kNanoSecondsPerSecond);
+  auto ns = static_cast<long long>(nano % Time::kNanoSecondsPerSecond);
+  auto ret = snprintf(buf, sizeof buf, "%lld.%09llds", sec, ns);
+  assert(ret > 0);
+  return {buf, static_cast<size_t>(ret)};
+}
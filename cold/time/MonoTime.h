@@ -0,0 +1,86 @@
+#ifndef COLD_TIME_MONOTIME
+#define COLD_TIME_MONOTIME
+
+#include <chrono>
+#include <string>
+
+#include "cold/time/Time.h"
+
+namespace Cold::Base {
+
+// a point of CLOCK_MONOTONIC. unlike Time it never jumps with the wall
+// clock, timers use it
+class MonoTime {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  constexpr MonoTime() = default;
+  constexpr explicit MonoTime(TimePoint p) : timePoint_(p) {}
+  ~MonoTime() = default;
+
+  static MonoTime Now() { return MonoTime(Clock::now()); }
+
+  // CLOCK_MONOTONIC_COARSE. cheaper than Now() but only advances once per
+  // kernel tick (1-4ms)
+  static MonoTime NowCoarse();
+
+  // the monotonic time at which the wall clock shows time
+  static MonoTime FromTime(Time time) {
+    return Now() + (time - Time::Now());
+  }
+
+  auto TimeSinceEpochDuration() const { return timePoint_.time_since_epoch(); }
+  constexpr int64_t TimeSinceEpochMilliSeconds() const {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(timePoint_.time_since_epoch()).count();
+  }
+  constexpr int64_t TimeSinceEpochNanoSeconds() const {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(timePoint_.time_since_epoch()).count();
+  }
+
+  template <typename REP, typename PERIOD>
+  constexpr MonoTime operator+(
+      std::chrono::duration<REP, PERIOD> duration) const {
+    return MonoTime(timePoint_ +
+                    std::chrono::duration_cast<Clock::duration>(duration));
+  }
+
+  template <typename REP, typename PERIOD>
+  constexpr MonoTime operator-(
+      std::chrono::duration<REP, PERIOD> duration) const {
+    return MonoTime(timePoint_ -
+                    std::chrono::duration_cast<Clock::duration>(duration));
+  }
+
+  template <typename REP, typename PERIOD>
+  constexpr MonoTime& operator+=(std::chrono::duration<REP, PERIOD> duration) {
+    timePoint_ += std::chrono::duration_cast<Clock::duration>(duration);
+    return *this;
+  }
+
+  template <typename REP, typename PERIOD>
+  constexpr MonoTime& operator-=(std::chrono::duration<REP, PERIOD> duration) {
+    timePoint_ -= std::chrono::duration_cast<Clock::duration>(duration);
+    return *this;
+  }
+
+  constexpr TimePoint::duration operator-(const MonoTime& other) const {
+    return timePoint_ - other.timePoint_;
+  }
+
+  constexpr auto operator<=>(const MonoTime&) const = default;
+
+  constexpr TimePoint GetStdTimePoint() const { return timePoint_; }
+
+  // seconds since boot, e.g. "1234.567890123s"
+  std::string Dump() const;
+
+ private:
+  TimePoint timePoint_;
+};  // class MonoTime
+
+}  // namespace Cold::Base
+
+#endif /* COLD_TIME_MONOTIME */
@@ -1,9 +1,19 @@
 #include "cold/time/Time.h"
 
+#include <time.h>
+
 #include <cassert>
 
 using namespace Cold;
 
+Base::Time Base::Time::NowCoarse() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+  using namespace std::chrono;
+  auto d = seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+  return Time(TimePoint(duration_cast<Clock::duration>(d)));
+}
+
 bool Base::Time::FromExploded(bool isLocal, const TimeExploded& ex,
                               Time* time) {
   struct tm t {};
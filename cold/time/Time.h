@@ -35,6 +35,10 @@ class Time {
 
   static Time Now() { return Time(Clock::now()); }
 
+  // CLOCK_REALTIME_COARSE. cheaper than Now() but only advances once per
+  // kernel tick (1-4ms)
+  static Time NowCoarse();
+
   static Time FromTimeT(time_t t) { return Time(Clock::from_time_t(t)); }
 
   static bool FromUTCExplode(const TimeExploded& ex, Time* time) {
@@ -4,14 +4,16 @@
 
 using namespace Cold;
 
-size_t Base::Timer::numCreated_ = 0;
+std::atomic<size_t> Base::Timer::numCreated_ = 0;
 
 Base::Timer::Timer(IoService& service)
     : service_(&service), timerId_(++numCreated_) {}
 
 Base::Timer::~Timer() { Cancel(); }
 
-void Base::Timer::Timer::ExpiresAt(Time time) {
+Base::MonoTime Base::Timer::Now() const { return service_->Now(); }
+
+void Base::Timer::Timer::ExpiresAt(MonoTime time) {
   expiry_ = time;
   service_->UpdateTimer(*this);
 }
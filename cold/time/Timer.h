@@ -1,10 +1,12 @@
 #ifndef COLD_TIME_TIMER
 #define COLD_TIME_TIMER
 
+#include <atomic>
 #include <chrono>
 #include <coroutine>
 
 #include "cold/coro/Task.h"
+#include "cold/time/MonoTime.h"
 #include "cold/time/Time.h"
 
 namespace Cold::Base {
@@ -25,8 +27,10 @@ class Timer {
       : service_(other.service_),
         timerId_(other.timerId_),
         expiry_(other.expiry_),
-        task_(std::move(other.task_)) {
+        task_(std::move(other.task_)),
+        queueNode_(other.queueNode_) {
     other.timerId_ = 0;
+    other.queueNode_ = nullptr;
   }
 
   Timer& operator=(Timer&& other) {
@@ -38,23 +42,29 @@ class Timer {
     timerId_ = other.timerId_;
     expiry_ = other.expiry_;
     task_ = std::move(other.task_);
+    queueNode_ = other.queueNode_;
     other.timerId_ = 0;
+    other.queueNode_ = nullptr;
     return *this;
   }
 
   template <typename T>
   struct TimerAwaitable;
 
+  // relative to the cached loop time of the IoService
   template <typename REP, typename PERIOD>
   void ExpiresAfter(std::chrono::duration<REP, PERIOD> duration) {
-    ExpiresAt(Time::Now() + duration);
+    ExpiresAt(Now() + duration);
   }
 
-  void ExpiresAt(Time time);
+  void ExpiresAt(MonoTime time);
+  // wall clock time is converted to monotonic time once. a later jump of
+  // the wall clock does not move the expiry
+  void ExpiresAt(Time time) { ExpiresAt(MonoTime::FromTime(time)); }
 
   void AsyncWait(Task<> task);
 
-  Time GetExpiry() const { return expiry_; }
+  MonoTime GetExpiry() const { return expiry_; }
 
   size_t GetTimerId() const { return timerId_; }
 
@@ -64,12 +74,16 @@ class Timer {
   [[nodiscard]] TimerAwaitable<T> AsyncWaitable(Task<T> task);
 
  private:
-  static size_t numCreated_;
+  MonoTime Now() const;
+
+  static std::atomic<size_t> numCreated_;
 
   IoService* service_;
   size_t timerId_;
-  Time expiry_;
+  MonoTime expiry_;
   Task<> task_;
+  // where the TimerQueue keeps the timer, if it is intrusive
+  void* queueNode_ = nullptr;
 };
 
 template <typename T>
@@ -0,0 +1,90 @@
+#include "cold/time/TimerHeap.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "cold/log/Logger.h"
+
+using namespace Cold;
+
+void Base::TimerHeap::AddTimer(Timer& timer) {
+  TimerNode node{timer.GetTimerId(), timer.GetExpiry(), TakeTask(timer)};
+  auto it = timerIdToIndexMap_.find(timer.GetTimerId());
+  if (it == timerIdToIndexMap_.end()) {
+    size_t last = timeHeap_.size();
+    timeHeap_.push_back(std::move(node));
+    timerIdToIndexMap_[timeHeap_.back().timerId] = last;
+    Fixup(last);
+  } else {
+    Base::ERROR("Timer is already in TimerQueue. TimerId: {}",
+                timer.GetTimerId());
+  }
+}
+
+void Base::TimerHeap::CancelTimer(Timer& timer) {
+  auto it = timerIdToIndexMap_.find(timer.GetTimerId());
+  // timer already complete
+  if (it == timerIdToIndexMap_.end()) return;
+  auto index = it->second;
+  assert(index < timeHeap_.size() &&
+         timeHeap_[index].timerId == timer.GetTimerId());
+  timeHeap_[index].Invalid();
+}
+
+void Base::TimerHeap::UpdateTimer(Timer& timer) {
+  auto it = timerIdToIndexMap_.find(timer.GetTimerId());
+  if (it == timerIdToIndexMap_.end()) {
+    return;
+  }
+  auto index = it->second;
+  assert(index < timeHeap_.size() &&
+         timeHeap_[index].timerId == timer.GetTimerId());
+  // update expiry time
+  timeHeap_[index].expiry = timer.GetExpiry();
+  FixDown(index);
+  Fixup(index);
+}
+
+void Base::TimerHeap::Fixup(size_t son) {
+  for (size_t parent = 0; son > 0;) {
+    parent = (son - 1) / 2;
+    if (!(timeHeap_[parent] > timeHeap_[son])) break;
+    std::swap(timerIdToIndexMap_[timeHeap_[parent].timerId],
+              timerIdToIndexMap_[timeHeap_[son].timerId]);
+    std::swap(timeHeap_[parent], timeHeap_[son]);
+    son = parent;
+  }
+}
+
+void Base::TimerHeap::FixDown(size_t parent) {
+  auto last = timeHeap_.size();
+  for (auto son = parent * 2 + 1; son < last; son = parent * 2 + 1) {
+    if (son + 1 < last && timeHeap_[son] > timeHeap_[son + 1]) ++son;
+    if (timeHeap_[son] > timeHeap_[parent]) break;
+    std::swap(timerIdToIndexMap_[timeHeap_[parent].timerId],
+              timerIdToIndexMap_[timeHeap_[son].timerId]);
+    std::swap(timeHeap_[parent], timeHeap_[son]);
+    parent = son;
+  }
+}
+
+int64_t Base::TimerHeap::HandleTimeout(
+    MonoTime now, std::vector<Task<>>& timeoutCoroutines) {
+  while (!timeHeap_.empty() && now >= timeHeap_[0].expiry) {
+    auto& node = timeHeap_[0];
+    if (node.valid) {
+      timeoutCoroutines.push_back(std::move(node.task));
+    }
+    assert(timerIdToIndexMap_.count(node.timerId));
+    timerIdToIndexMap_.erase(node.timerId);
+    std::swap(timeHeap_.front(), timeHeap_.back());
+    if (timeHeap_.size() > 1) timerIdToIndexMap_[timeHeap_.front().timerId] = 0;
+    timeHeap_.pop_back();
+    FixDown(0);
+  }
+  assert(timeHeap_.empty() || timeHeap_[0].expiry > now);
+  if (timeHeap_.empty()) return -1;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             timeHeap_[0].expiry - now)
+      .count();
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef COLD_TIME_TIMERHEAP
+#define COLD_TIME_TIMERHEAP
+
+#include <map>
+
+#include "cold/time/TimerQueue.h"
+
+namespace Cold::Base {
+
+// binary heap. a canceled timer is only marked invalid and stays in the
+// heap until it expires
+class TimerHeap : public TimerQueue {
+ public:
+  TimerHeap() = default;
+  ~TimerHeap() override = default;
+
+  void AddTimer(Timer& timer) override;
+  void CancelTimer(Timer& timer) override;
+  void UpdateTimer(Timer& timer) override;
+
+  int64_t HandleTimeout(MonoTime now,
+                        std::vector<Task<>>& timeoutCoroutines) override;
+
+  size_t Size() const override { return timeHeap_.size(); }
+
+ private:
+  struct TimerNode {
+    size_t timerId;
+    MonoTime expiry;
+    Task<> task;
+    bool valid = true;
+
+    bool operator>(const TimerNode& rhs) {
+      if (expiry == rhs.expiry) {
+        return timerId > rhs.timerId;
+      }
+      return expiry > rhs.expiry;
+    }
+
+    void Invalid() { valid = false; }
+  };
+
+  void Fixup(size_t son);
+  void FixDown(size_t parent);
+
+  std::vector<TimerNode> timeHeap_;
+  std::map<size_t, size_t> timerIdToIndexMap_;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_TIME_TIMERHEAP */
\ No newline at end of file
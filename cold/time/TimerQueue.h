@@ -1,52 +1,43 @@
 #ifndef COLD_TIME_TIMERQUEUE
 #define COLD_TIME_TIMERQUEUE
 
-#include <map>
+#include <memory>
 #include <vector>
 
 #include "cold/time/Timer.h"
 
 namespace Cold::Base {
+
+enum class TimerQueueType { kHeap, kTimingWheel };
+
+// timers of an IoService. not thread safe, IoService locks it
 class TimerQueue {
  public:
   TimerQueue() = default;
-  ~TimerQueue() = default;
+  virtual ~TimerQueue() = default;
 
   TimerQueue(const TimerQueue&) = delete;
   TimerQueue& operator=(const TimerQueue&) = delete;
 
-  void AddTimer(Timer& timer);
-  void CancelTimer(Timer& timer);
-  void UpdateTimer(Timer& timer);
-
-  // return wait time ms
-  int HandleTimeout(std::vector<Task<>>& timeoutCoroutines);
-
- private:
-  constexpr static int kDefaultTickMilliSeconds = 500;
-  struct TimerNode {
-    size_t timerId;
-    Time expiry;
-    Task<> task;
-    bool valid = true;
+  static std::unique_ptr<TimerQueue> Create(TimerQueueType type);
 
-    bool operator>(const TimerNode& rhs) {
-      if (expiry == rhs.expiry) {
-        return timerId > rhs.timerId;
-      }
-      return expiry > rhs.expiry;
-    }
+  virtual void AddTimer(Timer& timer) = 0;
+  virtual void CancelTimer(Timer& timer) = 0;
+  virtual void UpdateTimer(Timer& timer) = 0;
 
-    void Invalid() { valid = false; }
-  };
+  // take the timers expired at now. return nanoseconds until the next
+  // timer, -1 if there is none
+  virtual int64_t HandleTimeout(MonoTime now,
+                                std::vector<Task<>>& timeoutCoroutines) = 0;
 
-  void Fixup(size_t son);
-  void FixDown(size_t parent);
+  // number of stored timers, including canceled ones not yet removed
+  virtual size_t Size() const = 0;
 
-  std::vector<TimerNode> timeHeap_;
-  std::map<size_t, size_t> timerIdToIndexMap_;
+ protected:
+  static Task<> TakeTask(Timer& timer) { return std::move(timer.task_); }
+  static void*& QueueNode(Timer& timer) { return timer.queueNode_; }
 };
 
 }  // namespace Cold::Base
 
-#endif /* COLD_TIME_TIMERQUEUE */
\ No newline at end of file
+#endif /* COLD_TIME_TIMERQUEUE */
@@ -0,0 +1,198 @@
+#include "cold/time/TimingWheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+
+#include "cold/log/Logger.h"
+
+using namespace Cold;
+
+namespace {
+constexpr auto kRoundUp = std::chrono::nanoseconds(999999);
+}
+
+// the coarse clock never runs ahead of the precise one, so the wheel does
+// not start after the loop time of either source
+Base::TimingWheel::TimingWheel()
+    : currentTick_(ToTick(MonoTime::NowCoarse())) {}
+
+Base::TimingWheel::~TimingWheel() {
+  auto deleteList = [](TimerNode* node) {
+    while (node) {
+      auto next = node->next;
+      delete node;
+      node = next;
+    }
+  };
+  for (auto& level : slots_) {
+    for (auto head : level) deleteList(head);
+  }
+  deleteList(expired_);
+  deleteList(freeNodes_);
+}
+
+uint64_t Base::TimingWheel::ToTick(MonoTime time) {
+  using namespace std::chrono;
+  auto ms = duration_cast<milliseconds>(time.TimeSinceEpochDuration()).count();
+  return ms < 0 ? 0 : static_cast<uint64_t>(ms);
+}
+
+Base::TimingWheel::TimerNode* Base::TimingWheel::FindNode(Timer& timer) {
+  auto node = static_cast<TimerNode*>(QueueNode(timer));
+  if (!node || node->timerId != timer.GetTimerId()) return nullptr;
+  return node;
+}
+
+void Base::TimingWheel::AddTimer(Timer& timer) {
+  if (FindNode(timer)) {
+    Base::ERROR("Timer is already in TimerQueue. TimerId: {}",
+                timer.GetTimerId());
+    return;
+  }
+  auto node = AllocNode();
+  node->timerId = timer.GetTimerId();
+  // round up, a timer never fires before its expiry
+  node->expireTick = ToTick(timer.GetExpiry() + kRoundUp);
+  node->task = TakeTask(timer);
+  QueueNode(timer) = node;
+  ++size_;
+  Link(node);
+}
+
+void Base::TimingWheel::CancelTimer(Timer& timer) {
+  auto node = FindNode(timer);
+  // timer already complete
+  if (!node) return;
+  QueueNode(timer) = nullptr;
+  Unlink(node);
+  FreeNode(node);
+}
+
+void Base::TimingWheel::UpdateTimer(Timer& timer) {
+  auto node = FindNode(timer);
+  if (!node) return;
+  Unlink(node);
+  node->expireTick = ToTick(timer.GetExpiry() + kRoundUp);
+  Link(node);
+}
+
+int64_t Base::TimingWheel::HandleTimeout(
+    MonoTime nowTime, std::vector<Task<>>& timeoutCoroutines) {
+  const auto now = ToTick(nowTime);
+  Advance(now);
+  while (expired_) {
+    auto node = expired_;
+    Unlink(node);
+    timeoutCoroutines.push_back(std::move(node->task));
+    FreeNode(node);
+  }
+  if (size_ == 0) return -1;
+  auto next = NextEventTick();
+  assert(next > now);
+  // wait until the start of the tick, not a whole tick from now
+  constexpr int64_t kNanoSecondsPerTick = 1000000;
+  return static_cast<int64_t>(next) * kNanoSecondsPerTick -
+         nowTime.TimeSinceEpochNanoSeconds();
+}
+
+void Base::TimingWheel::Link(TimerNode* node) {
+  TimerNode** head = &expired_;
+  node->level = -1;
+  if (node->expireTick > currentTick_) {
+    auto delta = node->expireTick - currentTick_;
+    auto expire = node->expireTick;
+    int level = 0;
+    while (level < kLevels - 1 &&
+           delta >= (1ull << (kSlotBits * (level + 1)))) {
+      ++level;
+    }
+    // out of range. wait in the farthest slot of the last level
+    constexpr auto kMaxDelta = 1ull << (kSlotBits * kLevels);
+    if (delta >= kMaxDelta) expire = currentTick_ + kMaxDelta - 1;
+    node->level = level;
+    node->slot = (expire >> (kSlotBits * level)) & kSlotMask;
+    head = &slots_[level][node->slot];
+    occupied_[level] |= 1ull << node->slot;
+  }
+  node->prev = nullptr;
+  node->next = *head;
+  if (*head) (*head)->prev = node;
+  *head = node;
+}
+
+void Base::TimingWheel::Unlink(TimerNode* node) {
+  TimerNode** head = node->level < 0 ? &expired_
+                                     : &slots_[node->level][node->slot];
+  if (node->prev) node->prev->next = node->next;
+  if (node->next) node->next->prev = node->prev;
+  if (*head == node) *head = node->next;
+  if (node->level >= 0 && !*head) {
+    occupied_[node->level] &= ~(1ull << node->slot);
+  }
+  node->prev = node->next = nullptr;
+}
+
+void Base::TimingWheel::Advance(uint64_t tick) {
+  while (currentTick_ < tick) {
+    // nothing fires or cascades in the ticks between, skip them
+    currentTick_ = std::min(NextSlotTick(), tick);
+    // cascade from the highest level whose lower levels wrap at this tick
+    int level = 0;
+    while (level < kLevels - 1 &&
+           (currentTick_ & ((1ull << (kSlotBits * (level + 1))) - 1)) == 0) {
+      ++level;
+    }
+    for (; level > 0; --level) Cascade(level);
+    auto slot = currentTick_ & kSlotMask;
+    while (auto node = slots_[0][slot]) {
+      Unlink(node);
+      Link(node);
+    }
+  }
+}
+
+void Base::TimingWheel::Cascade(int level) {
+  auto slot = (currentTick_ >> (kSlotBits * level)) & kSlotMask;
+  while (auto node = slots_[level][slot]) {
+    Unlink(node);
+    Link(node);
+  }
+}
+
+uint64_t Base::TimingWheel::NextEventTick() const {
+  return expired_ ? currentTick_ : NextSlotTick();
+}
+
+uint64_t Base::TimingWheel::NextSlotTick() const {
+  auto next = std::numeric_limits<uint64_t>::max();
+  for (int level = 0; level < kLevels; ++level) {
+    if (!occupied_[level]) continue;
+    auto shift = kSlotBits * level;
+    // the next slot of this level to expire or cascade
+    auto period = (currentTick_ >> shift) + 1;
+    auto start = static_cast<int>(period & kSlotMask);
+    auto offset = std::countr_zero(std::rotr(occupied_[level], start));
+    auto tick = (period + static_cast<uint64_t>(offset)) << shift;
+    if (tick < next) next = tick;
+  }
+  return next;
+}
+
+Base::TimingWheel::TimerNode* Base::TimingWheel::AllocNode() {
+  if (!freeNodes_) return new TimerNode();
+  auto node = freeNodes_;
+  freeNodes_ = node->next;
+  node->next = nullptr;
+  return node;
+}
+
+void Base::TimingWheel::FreeNode(TimerNode* node) {
+  --size_;
+  node->timerId = 0;
+  node->task = Task<>();
+  node->prev = nullptr;
+  node->next = freeNodes_;
+  freeNodes_ = node;
+}
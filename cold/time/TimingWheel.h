@@ -0,0 +1,79 @@
+#ifndef COLD_TIME_TIMINGWHEEL
+#define COLD_TIME_TIMINGWHEEL
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cold/time/TimerQueue.h"
+
+namespace Cold::Base {
+
+// hierarchical timing wheel with 1ms ticks. 4 levels of 64 slots cover
+// about 4.6 hours, later timers wait in the last level and are placed again
+// when it cascades. add, update and cancel are O(1), cancel removes the
+// timer at once. the timer points to its node, found without a lookup.
+class TimingWheel : public TimerQueue {
+ public:
+  TimingWheel();
+  ~TimingWheel() override;
+
+  void AddTimer(Timer& timer) override;
+  void CancelTimer(Timer& timer) override;
+  void UpdateTimer(Timer& timer) override;
+
+  int64_t HandleTimeout(MonoTime now,
+                        std::vector<Task<>>& timeoutCoroutines) override;
+
+  size_t Size() const override { return size_; }
+
+ private:
+  constexpr static int kLevels = 4;
+  constexpr static int kSlotBits = 6;
+  constexpr static uint64_t kSlots = 1 << kSlotBits;
+  constexpr static uint64_t kSlotMask = kSlots - 1;
+
+  struct TimerNode {
+    // 0 in the free list. a timer which fired still points to its node,
+    // which may be taken by another timer since
+    size_t timerId = 0;
+    uint64_t expireTick = 0;
+    Task<> task;
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    // -1 for expired list
+    int level = 0;
+    uint64_t slot = 0;
+  };
+
+  static uint64_t ToTick(MonoTime time);
+
+  void Link(TimerNode* node);
+  void Unlink(TimerNode* node);
+
+  // the node of timer, nullptr if it is not in the wheel
+  static TimerNode* FindNode(Timer& timer);
+
+  void Advance(uint64_t tick);
+  void Cascade(int level);
+
+  // the earliest tick something may fire or cascade
+  uint64_t NextEventTick() const;
+  // the same for the slots, after currentTick_
+  uint64_t NextSlotTick() const;
+
+  TimerNode* AllocNode();
+  void FreeNode(TimerNode* node);
+
+  uint64_t currentTick_;
+  TimerNode* slots_[kLevels][kSlots] = {};
+  // bit i is set when slots_[level][i] is not empty
+  uint64_t occupied_[kLevels] = {};
+  // timers already expired when added
+  TimerNode* expired_ = nullptr;
+  size_t size_ = 0;
+  TimerNode* freeNodes_ = nullptr;
+};
+
+}  // namespace Cold::Base
+
+#endif /* COLD_TIME_TIMINGWHEEL */
@@ -0,0 +1,192 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "cold/net/Acceptor.h"
+#include "cold/net/Splice.h"
+#include "cold/net/TcpServer.h"
+#include "cold/time/Time.h"
+
+using namespace Cold;
+
+// the read/write loop which Splice replaces
+Base::Task<size_t> Copy(Net::TcpSocket& src, Net::TcpSocket& dst) {
+  std::string buf(64 * 1024, '\0');
+  size_t total = 0;
+  while (true) {
+    auto n = co_await src.Read(buf.data(), buf.size());
+    if (n == 0) {
+      dst.ShutDown();
+      break;
+    }
+    if (n < 0) {
+      src.Close();
+      dst.Close();
+      break;
+    }
+    auto ret = co_await dst.WriteN(buf.data(), static_cast<size_t>(n));
+    if (ret < 0) {
+      src.Close();
+      dst.Close();
+      break;
+    }
+    total += static_cast<size_t>(n);
+  }
+  co_return total;
+}
+
+Base::Task<> Proxy(Net::TcpSocket client, Net::IpAddress backendAddr,
+                   bool splice) {
+  Net::TcpSocket backend(client.GetIoService());
+  auto ret = co_await backend.Connect(backendAddr);
+  if (ret < 0) {
+    Base::ERROR("Cannot connect to backend {}. reason: {}",
+                backendAddr.GetIpPort(), Base::ThisThread::ErrorMsg());
+    client.Close();
+    co_return;
+  }
+  if (splice) {
+    co_await Net::Forward(client, backend);
+    co_return;
+  }
+  // the other direction may outlive this coroutine
+  auto sockets = std::make_shared<std::pair<Net::TcpSocket, Net::TcpSocket>>(
+      std::move(client), std::move(backend));
+  sockets->first.GetIoService().CoSpawn(
+      [](std::shared_ptr<std::pair<Net::TcpSocket, Net::TcpSocket>> s)
+          -> Base::Task<> { co_await Copy(s->second, s->first); }(sockets));
+  co_await Copy(sockets->first, sockets->second);
+}
+
+class ProxyServer : public Net::TcpServer {
+ public:
+  ProxyServer(const Net::IpAddress& addr, const Net::IpAddress& backendAddr,
+              bool splice)
+      : Net::TcpServer(addr), backendAddr_(backendAddr), splice_(splice) {}
+  ~ProxyServer() override = default;
+
+  Base::Task<> OnConnect(Net::TcpSocket socket) override {
+    co_await Proxy(std::move(socket), backendAddr_, splice_);
+  }
+
+ private:
+  Net::IpAddress backendAddr_;
+  bool splice_;
+};
+
+// bench: client -> proxy -> sink, each in its own thread
+
+Base::Task<> Sink(Net::Acceptor& acceptor) {
+  auto socket = co_await acceptor.Accept();
+  std::string buf(64 * 1024, '\0');
+  while (true) {
+    auto n = co_await socket.Read(buf.data(), buf.size());
+    if (n <= 0) break;
+  }
+  socket.Close();
+}
+
+Base::Task<> ProxyOnce(Net::Acceptor& acceptor, Net::IpAddress backendAddr,
+                       bool splice) {
+  auto socket = co_await acceptor.Accept();
+  co_await Proxy(std::move(socket), backendAddr, splice);
+}
+
+Base::Task<> Send(Base::IoService& service, Net::IpAddress proxyAddr,
+                  size_t megabytes, double& seconds) {
+  Net::TcpSocket socket(service);
+  auto ret = co_await socket.Connect(proxyAddr);
+  if (ret < 0) {
+    Base::ERROR("Cannot connect to proxy. reason: {}",
+                Base::ThisThread::ErrorMsg());
+    service.Stop();
+    co_return;
+  }
+  std::string chunk(1024 * 1024, 'x');
+  auto start = Base::Time::Now();
+  for (size_t i = 0; i < megabytes; ++i) {
+    auto n = co_await socket.WriteN(chunk.data(), chunk.size());
+    if (n < 0) break;
+  }
+  socket.ShutDown();
+  // the eof of the sink comes back through the proxy
+  char buf[16];
+  while (true) {
+    auto n = co_await socket.Read(buf, sizeof buf);
+    if (n <= 0) break;
+  }
+  auto elapsed = Base::Time::Now() - start;
+  seconds = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                    .count()) /
+            1e6;
+  socket.Close();
+  service.Stop();
+}
+
+double Bench(bool splice, size_t megabytes) {
+  Base::IoService sinkService;
+  Base::IoService proxyService;
+  Base::IoService clientService;
+  Net::IpAddress sinkAddr(17001, true);
+  Net::IpAddress proxyAddr(17002, true);
+  Net::Acceptor sinkAcceptor(sinkService, sinkAddr, false);
+  Net::Acceptor proxyAcceptor(proxyService, proxyAddr, false);
+  sinkAcceptor.Listen();
+  proxyAcceptor.Listen();
+  sinkService.CoSpawn(Sink(sinkAcceptor));
+  proxyService.CoSpawn(ProxyOnce(proxyAcceptor, sinkAddr, splice));
+  double seconds = 0;
+  clientService.CoSpawn(Send(clientService, proxyAddr, megabytes, seconds));
+  std::thread sinkThread([&]() { sinkService.Start(); });
+  std::thread proxyThread([&]() { proxyService.Start(); });
+  // the client sees eof once the sink and the proxy are done
+  clientService.Start();
+  sinkService.Stop();
+  proxyService.Stop();
+  sinkThread.join();
+  proxyThread.join();
+  return seconds;
+}
+
+int main(int argc, char** argv) {
+  auto& config = Base::Config::GetGloablDefaultConfig();
+  if (argc < 2) {
+    Base::INFO("Usage: {} <proxy|bench>", argv[0]);
+    return -1;
+  }
+  if (strcmp(argv[1], "proxy") == 0) {
+    auto port = config.GetOrDefault<uint16_t>("/proxy/listen-port", 7777);
+    auto host = config.GetOrDefault<std::string>("/proxy/backend-host",
+                                                 std::string("localhost"));
+    auto backendPort =
+        config.GetOrDefault<uint16_t>("/proxy/backend-port", 8888);
+    auto splice = config.GetOrDefault<bool>("/proxy/splice", true);
+    auto backendAddr =
+        Net::IpAddress::Resolve(host, std::to_string(backendPort).data());
+    if (!backendAddr) {
+      Base::ERROR("Cannot resolve backend. host: {}, port: {}", host,
+                  backendPort);
+      return -1;
+    }
+    Net::IpAddress addr(port);
+    ProxyServer server(addr, *backendAddr, splice);
+    Base::INFO("TcpProxy run at {}, backend: {}, splice: {}",
+               addr.GetIpPort(), backendAddr->GetIpPort(), splice);
+    server.Start();
+  } else if (strcmp(argv[1], "bench") == 0) {
+    auto megabytes =
+        config.GetOrDefault<size_t>("/proxy/bench-megabytes", 2048);
+    for (auto splice : {false, true}) {
+      auto seconds = Bench(splice, megabytes);
+      Base::INFO("{}: {} MB in {:.3f} seconds. Speed: {:.3f} MB/s",
+                 splice ? "splice" : "read/write", megabytes, seconds,
+                 static_cast<double>(megabytes) / seconds);
+    }
+  } else {
+    Base::INFO("Usage: {} <proxy|bench>", argv[0]);
+    return -1;
+  }
+  return 0;
+}
@@ -1,5 +1,8 @@
 #include "examples/simple/simplehttp/RequestParser.h"
 
+#include <algorithm>
+#include <array>
+
 #include "examples/simple/simplehttp/HttpRequest.h"
 
 bool RequestParser::CheckMethod(std::string_view method, HttpRequest& request) {
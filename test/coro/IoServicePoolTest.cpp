@@ -0,0 +1,179 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <unistd.h>
+
+#include <thread>
+
+#include "cold/coro/DispatchPolicy.h"
+#include "cold/coro/Io.h"
+#include "cold/coro/IoServicePool.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+constexpr int kTasks = 100;
+
+Base::Task<> Count(Base::IoServicePool& pool, std::atomic<int>& count) {
+  if (++count == kTasks) pool.Stop();
+  co_return;
+}
+
+Base::Task<> SpawnAndBlock(Base::IoServicePool& pool,
+                           std::atomic<int>& count) {
+  for (int i = 0; i < kTasks; ++i) {
+    pool.CoSpawn(Count(pool, count));
+  }
+  // the other worker has to steal
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  co_return;
+}
+
+Base::Task<> ReadFromOwner(Base::IoServicePool& pool, Base::IoService& owner,
+                           int fd, bool& inOwner, std::string& result) {
+  Base::AsyncIO io(owner, fd);
+  char buf[16];
+  auto n = co_await io.AsyncRead(buf, sizeof buf);
+  inOwner = owner.InLoopThread();
+  if (n > 0) result.assign(buf, static_cast<size_t>(n));
+  pool.Stop();
+}
+
+Base::Task<> DelayWrite(Base::IoService& service, int fd) {
+  co_await Base::Sleep(service, std::chrono::milliseconds(20));
+  Base::AsyncIO io(service, fd);
+  co_await io.AsyncWrite("hi", 2);
+}
+
+TEST_CASE("test work stealing") {
+  Base::IoServicePool pool(2);
+  pool.EnableWorkStealing(true);
+  std::atomic<int> count = 0;
+  pool.GetIoServiceForHash(0).CoSpawn(SpawnAndBlock(pool, count));
+  pool.Start();
+  CHECK(count == kTasks);
+  CHECK(pool.GetStealCount() > 0);
+}
+
+TEST_CASE("test io resumes in owner service") {
+  Base::IoServicePool pool(2);
+  pool.EnableWorkStealing(true);
+  auto& first = pool.GetIoServiceForHash(0);
+  auto& second = pool.GetIoServiceForHash(1);
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+  bool inOwner = false;
+  std::string result;
+  // the reader runs in the second service but the fd belongs to the first
+  second.CoSpawn(ReadFromOwner(pool, first, fds[0], inOwner, result));
+  first.CoSpawn(DelayWrite(first, fds[1]));
+  pool.Start();
+  CHECK(inOwner);
+  CHECK(result == "hi");
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST_CASE("test pool spawn without work stealing") {
+  Base::IoServicePool pool(2);
+  std::atomic<int> count = 0;
+  for (int i = 0; i < kTasks; ++i) {
+    pool.CoSpawn(Count(pool, count));
+  }
+  pool.Start();
+  CHECK(count == kTasks);
+  CHECK(pool.GetStealCount() == 0);
+}
+
+Base::Task<> RecordCpus(Base::IoServicePool& pool, std::vector<int>& affinity,
+                        std::atomic<int>& done) {
+  affinity = Base::ThisThread::GetCpuAffinity();
+  if (++done == static_cast<int>(pool.GetPoolSize())) pool.Stop();
+  co_return;
+}
+
+TEST_CASE("test cpu affinity") {
+  auto cpus = Base::ThisThread::GetCpuAffinity();
+  REQUIRE(!cpus.empty());
+  Base::IoServicePool pool(2);
+  pool.SetCpuAffinity({{cpus.front()}, {cpus.back()}});
+  CHECK(&pool.GetIoServiceForCpu(cpus.front()) ==
+        &pool.GetIoServiceForHash(0));
+  if (cpus.size() > 1) {
+    CHECK(&pool.GetIoServiceForCpu(cpus.back()) ==
+          &pool.GetIoServiceForHash(1));
+  }
+  std::vector<std::vector<int>> affinity(2);
+  std::atomic<int> done = 0;
+  for (size_t i = 0; i < 2; ++i) {
+    pool.GetIoServiceForHash(i).CoSpawn(RecordCpus(pool, affinity[i], done));
+  }
+  pool.Start();
+  CHECK(affinity[0] == std::vector<int>{cpus.front()});
+  CHECK(affinity[1] == std::vector<int>{cpus.back()});
+  // the main service is not pinned
+  CHECK(Base::ThisThread::GetCpuAffinity() == cpus);
+}
+
+Base::Task<> Nothing() { co_return; }
+
+TEST_CASE("test dispatch policy") {
+  std::vector<std::unique_ptr<Base::IoService>> owners;
+  std::vector<Base::IoService*> services;
+  for (int i = 0; i < 4; ++i) {
+    owners.push_back(std::make_unique<Base::IoService>());
+    services.push_back(owners.back().get());
+  }
+  using Type = Base::DispatchPolicyType;
+
+  auto roundRobin = Base::DispatchPolicy::Create(Type::kRoundRobin);
+  for (size_t i = 0; i < 8; ++i) {
+    CHECK(roundRobin->Select(services, 0) == i % 4);
+  }
+
+  for (auto i : {0, 1, 3}) services[i]->AddConnection();
+  auto leastConnections = Base::DispatchPolicy::Create(Type::kLeastConnections);
+  for (int i = 0; i < 4; ++i) CHECK(leastConnections->Select(services, 0) == 2);
+  CHECK(services[0]->GetLoad().connections == 1);
+
+  // spawned from a thread which runs no service, so they stay queued
+  for (auto i : {0, 1, 2}) services[i]->CoSpawn(Nothing());
+  CHECK(services[0]->GetLoad().queuedTasks == 1);
+  auto leastQueued = Base::DispatchPolicy::Create(Type::kLeastQueuedTasks);
+  for (int i = 0; i < 4; ++i) CHECK(leastQueued->Select(services, 0) == 3);
+
+  // loads are 3, 2, 2, 2. the two choices differ, so the most loaded
+  // service always loses
+  services[2]->AddConnection();
+  services[3]->CoSpawn(Nothing());
+  services[0]->AddConnection();
+  auto twoChoices = Base::DispatchPolicy::Create(Type::kPowerOfTwoChoices);
+  std::vector<int> hits(4);
+  for (int i = 0; i < 1000; ++i) ++hits[twoChoices->Select(services, 0)];
+  CHECK(hits[0] == 0);
+  CHECK(hits[1] > 0);
+
+  auto consistentHash = Base::DispatchPolicy::Create(Type::kConsistentHash);
+  std::vector<int> owner(1000);
+  std::vector<int> used(4);
+  for (size_t i = 0; i < owner.size(); ++i) {
+    owner[i] = static_cast<int>(consistentHash->Select(services, i));
+    ++used[static_cast<size_t>(owner[i])];
+  }
+  for (size_t i = 0; i < owner.size(); ++i) {
+    CHECK(consistentHash->Select(services, i) ==
+          static_cast<size_t>(owner[i]));
+  }
+  for (auto count : used) CHECK(count > 0);
+
+  for (auto i : {0, 0, 1, 2, 3}) services[i]->RemoveConnection();
+}
+
+TEST_CASE("test pool select io service") {
+  Base::IoServicePool empty;
+  CHECK(&empty.SelectIoService() == &empty.GetMainIoService());
+  Base::IoServicePool pool(3);
+  pool.SetDispatchPolicy(Base::DispatchPolicyType::kLeastConnections);
+  pool.GetIoServiceForHash(0).AddConnection();
+  pool.GetIoServiceForHash(2).AddConnection();
+  CHECK(&pool.SelectIoService() == &pool.GetIoServiceForHash(1));
+  CHECK(&pool.GetNextIoService() != &pool.GetNextIoService());
+}
@@ -0,0 +1,369 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "cold/coro/Io.h"
+#include "cold/coro/IoService.h"
+#include "cold/coro/IoUringWatcher.h"
+#include "cold/thread/Thread.h"
+#include "cold/time/Timer.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+Base::IoServiceOptions MakeOptions(Base::IoBackend backend) {
+  Base::IoServiceOptions options;
+  options.backend = backend;
+  return options;
+}
+
+Base::Task<> DoRead(Base::IoService& service, int fd, std::string& result) {
+  Base::AsyncIO io(service, fd);
+  char buf[64];
+  auto n = co_await io.AsyncRead(buf, sizeof buf);
+  if (n > 0) result.assign(buf, static_cast<size_t>(n));
+  service.Stop();
+}
+
+Base::Task<> DoWrite(Base::IoService& service, int fd) {
+  co_await Base::Sleep(service, std::chrono::milliseconds(10));
+  Base::AsyncIO io(service, fd);
+  co_await io.AsyncWrite("hello", 5);
+}
+
+uint64_t NumFrames() {
+  auto& stats = Base::FramePool::ThisThreadStats();
+  return stats.allocated + stats.recycled;
+}
+
+// every read with timeout is checked to create no coroutine frame
+Base::Task<> DoReadTimeoutNoFrame(Base::IoService& service, int fd,
+                                  int writeFd, int& checked) {
+  Base::AsyncIO io(service, fd);
+  char buf[64];
+  auto frames = NumFrames();
+  // timed out
+  auto ret = co_await io.AsyncReadWithTimeout(buf, sizeof buf,
+                                              std::chrono::milliseconds(5));
+  if (ret == -1 && errno == ETIMEDOUT && NumFrames() == frames) ++checked;
+  // ready at once
+  if (write(writeFd, "a", 1) != 1) perror("write");
+  ret = co_await io.AsyncReadWithTimeout(buf, sizeof buf,
+                                         std::chrono::seconds(1));
+  if (ret == 1 && NumFrames() == frames) ++checked;
+  // ready after suspended
+  Base::Thread writer([writeFd]() {
+    usleep(10000);
+    if (write(writeFd, "b", 1) != 1) perror("write");
+  });
+  writer.Start();
+  ret = co_await io.AsyncReadWithTimeout(buf, sizeof buf,
+                                         std::chrono::seconds(1));
+  if (ret == 1 && NumFrames() == frames) ++checked;
+  writer.Join();
+  service.Stop();
+}
+
+Base::Task<> DoReadTimeout(Base::IoService& service, int fd, ssize_t& ret,
+                           int& err) {
+  Base::AsyncIO io(service, fd);
+  char buf[64];
+  ret = co_await io.AsyncReadWithTimeout(buf, sizeof buf,
+                                         std::chrono::milliseconds(20));
+  err = errno;
+  service.Stop();
+}
+
+TEST_CASE("test pipe read write on every backend") {
+  for (auto backend : {Base::IoBackend::kEpoll, Base::IoBackend::kIoUring}) {
+    // falls back to epoll, e.g. io_uring is blocked by seccomp
+    if (backend == Base::IoBackend::kIoUring &&
+        !Base::IoUringWatcher::IsSupported()) {
+      continue;
+    }
+    Base::IoService service(MakeOptions(backend));
+    CHECK(service.GetBackend() == backend);
+    int fds[2];
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+    std::string result;
+    service.CoSpawn(DoRead(service, fds[0], result));
+    service.CoSpawn(DoWrite(service, fds[1]));
+    service.Start();
+    CHECK(result == "hello");
+    close(fds[0]);
+    close(fds[1]);
+  }
+}
+
+// the pipe fills up again and again, so the writer waits on an fd that is
+// registered already
+Base::Task<> DoWriteMany(Base::IoService& service, int fd, size_t total,
+                         size_t& written) {
+  Base::AsyncIO io(service, fd);
+  std::string chunk(16384, 'x');
+  while (written < total) {
+    auto n = co_await io.AsyncWrite(chunk.data(),
+                                    std::min(chunk.size(), total - written));
+    if (n <= 0) break;
+    written += static_cast<size_t>(n);
+  }
+  service.Stop();
+}
+
+TEST_CASE("test repeated write waits on every backend") {
+  constexpr size_t kTotal = 4 * 1024 * 1024;
+  for (auto backend : {Base::IoBackend::kEpoll, Base::IoBackend::kIoUring}) {
+    Base::IoService service(MakeOptions(backend));
+    int fds[2];
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+    size_t written = 0;
+    size_t received = 0;
+    Base::Thread reader([&]() {
+      char buf[4096];
+      while (received < kTotal) {
+        auto n = read(fds[0], buf, sizeof buf);
+        if (n > 0) {
+          received += static_cast<size_t>(n);
+        } else {
+          usleep(100);
+        }
+      }
+    });
+    reader.Start();
+    service.CoSpawn(DoWriteMany(service, fds[1], kTotal, written));
+    service.Start();
+    reader.Join();
+    CHECK(written == kTotal);
+    CHECK(received == kTotal);
+    close(fds[0]);
+    close(fds[1]);
+  }
+}
+
+TEST_CASE("test read timeout on every backend") {
+  for (auto backend : {Base::IoBackend::kEpoll, Base::IoBackend::kIoUring}) {
+    Base::IoService service(MakeOptions(backend));
+    int fds[2];
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+    ssize_t ret = 0;
+    int err = 0;
+    service.CoSpawn(DoReadTimeout(service, fds[0], ret, err));
+    service.Start();
+    CHECK(ret == -1);
+    CHECK(err == ETIMEDOUT);
+    close(fds[0]);
+    close(fds[1]);
+  }
+}
+
+TEST_CASE("test read timeout creates no coroutine") {
+  for (auto backend : {Base::IoBackend::kEpoll, Base::IoBackend::kIoUring}) {
+    Base::IoService service(MakeOptions(backend));
+    int fds[2];
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+    int checked = 0;
+    service.CoSpawn(DoReadTimeoutNoFrame(service, fds[0], fds[1], checked));
+    service.Start();
+    CHECK(checked == 3);
+    close(fds[0]);
+    close(fds[1]);
+  }
+}
+
+// suspends in the loop of another service, so the read is registered in
+// the loop of owner later
+Base::Task<> DoReadFromOtherLoop(Base::IoService& owner, int fd,
+                                 bool withTimeout, std::string& result) {
+  Base::AsyncIO io(owner, fd);
+  char buf[64];
+  ssize_t n = 0;
+  if (withTimeout) {
+    n = co_await io.AsyncReadWithTimeout(buf, sizeof buf,
+                                         std::chrono::seconds(1));
+  } else {
+    n = co_await io.AsyncRead(buf, sizeof buf);
+  }
+  if (n > 0) result.assign(buf, static_cast<size_t>(n));
+  owner.Stop();
+}
+
+TEST_CASE("test edge before deferred registration on every backend") {
+  for (auto backend : {Base::IoBackend::kEpoll, Base::IoBackend::kIoUring}) {
+    for (bool withTimeout : {false, true}) {
+      Base::IoService owner(MakeOptions(backend));
+      Base::IoService other;
+      int fds[2];
+      REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+      std::atomic<bool> blocked = false;
+      std::atomic<bool> release = false;
+      // keep the owner loop busy while the data comes, so the edge is seen
+      // before the registration runs
+      owner.CoSpawn([](Base::IoService& s, int fd, std::atomic<bool>& b,
+                       std::atomic<bool>& r) -> Base::Task<> {
+        // the fd is known to the watcher, only a new edge wakes a waiter
+        s.ListenReadEvent(fd, std::noop_coroutine());
+        b = true;
+        while (!r) usleep(100);
+        co_return;
+      }(owner, fds[0], blocked, release));
+      Base::Thread ownerThread([&]() { owner.Start(); });
+      Base::Thread otherThread([&]() { other.Start(); });
+      ownerThread.Start();
+      otherThread.Start();
+      while (!blocked) usleep(100);
+      std::string result;
+      other.CoSpawn(DoReadFromOtherLoop(owner, fds[0], withTimeout, result));
+      while (owner.GetLoad().queuedTasks == 0) usleep(100);
+      REQUIRE(write(fds[1], "hello", 5) == 5);
+      release = true;
+      ownerThread.Join();
+      other.Stop();
+      otherThread.Join();
+      CHECK(result == "hello");
+      close(fds[0]);
+      close(fds[1]);
+    }
+  }
+}
+
+Base::Task<> DoCancelOverFullRing(Base::IoService& service,
+                                  const std::vector<int>& writeFds, int fd,
+                                  bool& canceled) {
+  // ready at once, so their cqes fill the ring before the cancel is seen
+  for (auto writeFd : writeFds) {
+    service.ListenWriteEvent(writeFd, std::noop_coroutine());
+  }
+  char buf[16];
+  Base::IoOperation op;
+  op.opcode = Base::IoOperation::kRecv;
+  op.addr = buf;
+  op.len = sizeof buf;
+  REQUIRE(service.SubmitOperation(fd, std::noop_coroutine(), op));
+  service.StopListeningReadEvent(fd);
+  canceled = !op.completed;
+  // the write waiters are handled by the next WatchIo
+  co_await Base::Sleep(service, std::chrono::milliseconds(10));
+  service.Stop();
+}
+
+TEST_CASE("test cancel an operation with a full completion ring") {
+  if (!Base::IoUringWatcher::IsSupported()) return;
+  Base::IoService service(MakeOptions(Base::IoBackend::kIoUring));
+  // more than the 2048 entries of the completion ring
+  std::vector<int> readFds;
+  std::vector<int> writeFds;
+  for (int i = 0; i < 2200; ++i) {
+    int fds[2];
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+    readFds.push_back(fds[0]);
+    writeFds.push_back(fds[1]);
+  }
+  // blocking, so the recv waits in the kernel until it is canceled
+  int sv[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == 0);
+  bool canceled = false;
+  service.CoSpawn(DoCancelOverFullRing(service, writeFds, sv[0], canceled));
+  service.Start();
+  CHECK(canceled);
+  for (auto fd : readFds) close(fd);
+  for (auto fd : writeFds) close(fd);
+  close(sv[0]);
+  close(sv[1]);
+}
+
+TEST_CASE("test spawn from many threads") {
+  constexpr int kThreads = 4;
+  constexpr int kTasksPerThread = 10000;
+  Base::IoService service;
+  std::atomic<int> count = 0;
+  auto task = [](Base::IoService& s, std::atomic<int>& c) -> Base::Task<> {
+    if (++c == kThreads * kTasksPerThread) s.Stop();
+    co_return;
+  };
+  std::vector<std::unique_ptr<Base::Thread>> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(std::make_unique<Base::Thread>([&]() {
+      for (int j = 0; j < kTasksPerThread; ++j) {
+        service.CoSpawn(task(service, count));
+      }
+    }));
+  }
+  for (auto& thread : threads) thread->Start();
+  service.Start();
+  for (auto& thread : threads) thread->Join();
+  CHECK(count == kThreads * kTasksPerThread);
+}
+
+TEST_CASE("test spawn in loop thread") {
+  Base::IoService service;
+  CHECK(!service.InLoopThread());
+  int count = 0;
+  service.CoSpawn([](Base::IoService& s, int& c) -> Base::Task<> {
+    CHECK(s.InLoopThread());
+    for (int i = 0; i < 100; ++i) {
+      s.CoSpawn([](int& v) -> Base::Task<> {
+        ++v;
+        co_return;
+      }(c));
+    }
+    co_await Base::Sleep(s, std::chrono::milliseconds(10));
+    s.Stop();
+  }(service, count));
+  service.Start();
+  CHECK(count == 100);
+}
+
+TEST_CASE("test busy poll") {
+  Base::IoServiceOptions options;
+  options.busyPollMicroSeconds = 1000;
+  Base::IoService service(options);
+  constexpr int kTasks = 100;
+  std::atomic<int> count = 0;
+  auto task = [](Base::IoService& s, std::atomic<int>& c) -> Base::Task<> {
+    if (++c == kTasks) s.Stop();
+    co_return;
+  };
+  // the loop idles for a while, then tasks arrive within the spin budget
+  Base::Thread thread([&]() {
+    usleep(30000);
+    for (int i = 0; i < kTasks; ++i) {
+      service.CoSpawn(task(service, count));
+      usleep(20);
+    }
+  });
+  thread.Start();
+  service.Start();
+  thread.Join();
+  auto stats = service.GetBusyPollStats();
+  CHECK(count == kTasks);
+  CHECK(stats.spinHits > 0);
+  CHECK(stats.spinMisses > 0);
+  CHECK(stats.blockingWaits > 0);
+  CHECK(stats.spinNanoSeconds >= 1000000 / 16);
+  CHECK(stats.spinNanoSeconds <= 1000000);
+}
+
+TEST_CASE("test live tasks") {
+  Base::IoService service;
+  for (int i = 0; i < 10; ++i) {
+    service.CoSpawn([](Base::IoService& s) -> Base::Task<> {
+      co_await Base::Sleep(s, std::chrono::milliseconds(10));
+    }(service));
+  }
+  size_t liveWhenSleeping = 0;
+  size_t liveAtEnd = 0;
+  service.CoSpawn([](Base::IoService& s, size_t& sleeping,
+                     size_t& end) -> Base::Task<> {
+    co_await Base::Sleep(s, std::chrono::milliseconds(1));
+    sleeping = s.GetNumLiveTasks();
+    co_await Base::Sleep(s, std::chrono::milliseconds(50));
+    end = s.GetNumLiveTasks();
+    s.Stop();
+  }(service, liveWhenSleeping, liveAtEnd));
+  service.Start();
+  // both counts include the checker itself and the timer task resuming it
+  CHECK(liveWhenSleeping == liveAtEnd + 10);
+  CHECK(service.GetNumLiveTasks() == 0);
+}
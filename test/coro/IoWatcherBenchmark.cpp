@@ -0,0 +1,113 @@
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "cold/coro/IoEventTable.h"
+#include "cold/coro/IoWatcher.h"
+#include "cold/time/Time.h"
+#include "third_party/fmt/include/fmt/format.h"
+
+using namespace Cold;
+
+// register/unregister cost of the watchers and of the per fd table alone.
+// usage: IoWatcherBenchmark [rounds]
+
+struct Event {
+  uint32_t events = 0;
+  std::coroutine_handle<> readHandle;
+  std::coroutine_handle<> writeHandle;
+};
+
+double NsPerOp(Base::Time start, size_t ops) {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Base::Time::Now() - start)
+                .count();
+  return static_cast<double>(ns) / static_cast<double>(ops);
+}
+
+void BenchTable(int numFds, int rounds) {
+  std::map<int, Event> map;
+  auto start = Base::Time::Now();
+  for (int r = 0; r < rounds; ++r) {
+    for (int fd = 0; fd < numFds; ++fd) map[fd].events = 1;
+    for (int fd = 0; fd < numFds; ++fd) {
+      if (map.count(fd)) map[fd].events |= 2;
+    }
+    for (int fd = 0; fd < numFds; ++fd) map.erase(fd);
+  }
+  auto mapNs = NsPerOp(start, static_cast<size_t>(numFds * rounds * 3));
+
+  Base::IoEventTable<Event> table;
+  start = Base::Time::Now();
+  for (int r = 0; r < rounds; ++r) {
+    for (int fd = 0; fd < numFds; ++fd) table.Add(fd).events = 1;
+    for (int fd = 0; fd < numFds; ++fd) {
+      if (auto event = table.Find(fd)) event->events |= 2;
+    }
+    for (int fd = 0; fd < numFds; ++fd) table.Remove(fd);
+  }
+  auto tableNs = NsPerOp(start, static_cast<size_t>(numFds * rounds * 3));
+  std::cout << fmt::format(
+                   "table  fds: {:>6}  std::map: {:7.1f} ns/op  "
+                   "IoEventTable: {:7.1f} ns/op",
+                   numFds, mapNs, tableNs)
+            << std::endl;
+}
+
+void BenchWatcher(Base::IoBackend backend, const std::vector<int>& fds,
+                  int rounds) {
+  auto watcher = Base::IoWatcher::Create(backend);
+  auto name = watcher->GetBackend() == Base::IoBackend::kEpoll ? "epoll"
+                                                                : "io_uring";
+  auto noop = std::noop_coroutine();
+  auto start = Base::Time::Now();
+  for (int r = 0; r < rounds; ++r) {
+    for (auto fd : fds) watcher->ListenReadEvent(fd, noop);
+    for (auto fd : fds) watcher->StopListeningAll(fd);
+  }
+  auto registerNs = NsPerOp(start, fds.size() * static_cast<size_t>(rounds));
+  for (auto fd : fds) watcher->ListenReadEvent(fd, noop);
+  start = Base::Time::Now();
+  for (int r = 0; r < rounds; ++r) {
+    for (auto fd : fds) watcher->ListenWriteEvent(fd, noop);
+    for (auto fd : fds) watcher->StopListeningWriteEvent(fd);
+  }
+  auto writeNs = NsPerOp(start, fds.size() * static_cast<size_t>(rounds));
+  for (auto fd : fds) watcher->StopListeningAll(fd);
+  std::cout << fmt::format(
+                   "{:<8} fds: {:>6}  add+del: {:7.1f} ns/fd  "
+                   "arm+disarm write: {:7.1f} ns/fd",
+                   name, fds.size(), registerNs, writeNs)
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  int rounds = argc > 1 ? std::max(1, atoi(argv[1])) : 3;
+  for (int numFds : {10000, 100000}) {
+    BenchTable(numFds, rounds);
+  }
+
+  struct rlimit limit;
+  getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  for (int numFds : {10000, 100000}) {
+    if (static_cast<rlim_t>(numFds) + 64 > limit.rlim_cur) {
+      std::cout << fmt::format("skip {} fds. RLIMIT_NOFILE is {}", numFds,
+                               limit.rlim_cur)
+                << std::endl;
+      continue;
+    }
+    std::vector<int> fds;
+    for (int i = 0; i < numFds; ++i) {
+      fds.push_back(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    }
+    BenchWatcher(Base::IoBackend::kEpoll, fds, rounds);
+    BenchWatcher(Base::IoBackend::kIoUring, fds, rounds);
+    for (auto fd : fds) close(fd);
+  }
+}
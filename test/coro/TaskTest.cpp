@@ -2,6 +2,7 @@
 #include <memory>
 
 #include "cold/coro/Task.h"
+#include "cold/thread/Thread.h"
 #include "third_party/doctest.h"
 
 using Cold::Base::Task;
@@ -116,4 +117,30 @@ TEST_CASE("Test task return value") {
   //这时的调用是安全的 所有的Task都被保存到了协程帧里面
   coro.Resume();
   CHECK(coro.Done());
-}
\ No newline at end of file
+}
+
+Task<> Empty() { co_return; }
+
+TEST_CASE("Test Frame Pool") {
+  using Cold::Base::FramePool;
+  const auto& stats = FramePool::ThisThreadStats();
+  { auto warmUp = Empty(); }
+  auto allocated = stats.allocated;
+  auto recycled = stats.recycled;
+  for (int i = 0; i < 100; ++i) {
+    auto task = Empty();
+    task.Resume();
+  }
+  CHECK(stats.allocated == allocated);
+  CHECK(stats.recycled == recycled + 100);
+
+  // a frame freed in another thread goes back to the global heap
+  auto task = Empty();
+  Cold::Base::Thread thread([&task]() {
+    task = Task<>();
+    CHECK(FramePool::ThisThreadStats().foreignFreed == 1);
+  });
+  thread.Start();
+  thread.Join();
+  CHECK(!task.GetHandle());
+}
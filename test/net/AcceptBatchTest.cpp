@@ -0,0 +1,52 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <unistd.h>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Acceptor.h"
+#include "cold/net/TcpSocket.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+int Connect(const Net::IpAddress& addr) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  if (connect(fd, addr.GetSockaddr(), sizeof(struct sockaddr_in)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+Base::Task<> DoAcceptBatch(Base::IoService& service, Net::Acceptor& acceptor,
+                           std::vector<size_t>& batches) {
+  std::vector<std::pair<int, Net::IpAddress>> connections;
+  batches.push_back(co_await acceptor.AcceptFdBatch(connections, 3));
+  for (auto& connection : connections) close(connection.first);
+  auto sockets = co_await acceptor.AcceptBatch();
+  batches.push_back(sockets.size());
+  service.Stop();
+}
+
+TEST_CASE("test accept batch") {
+  Base::IoService service;
+  Net::IpAddress addr(18888, true);
+  Net::Acceptor acceptor(service, addr, true);
+  CHECK(acceptor.SetDeferAccept(1));
+  acceptor.Listen();
+  std::vector<int> clients;
+  for (int i = 0; i < 5; ++i) {
+    auto fd = Connect(addr);
+    REQUIRE(fd >= 0);
+    // deferred until the client sends something
+    CHECK(write(fd, "x", 1) == 1);
+    clients.push_back(fd);
+  }
+  std::vector<size_t> batches;
+  service.CoSpawn(DoAcceptBatch(service, acceptor, batches));
+  service.Start();
+  REQUIRE(batches.size() == 2);
+  CHECK(batches[0] == 3);
+  CHECK(batches[1] == 2);
+  for (auto fd : clients) close(fd);
+}
@@ -0,0 +1,129 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Buffer.h"
+#include "cold/net/BufferedSocket.h"
+#include "cold/net/TcpSocket.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+TEST_CASE("test buffer") {
+  Net::Buffer buffer;
+  CHECK(buffer.Empty());
+  CHECK(buffer.Capacity() == 0);
+  buffer.Append("hello\r\nworld");
+  CHECK(buffer.Capacity() == Net::BufferPool::kMinBlockSize);
+  CHECK(buffer.ReadableBytes() == 12);
+  CHECK(buffer.Find("\r\n") == 5);
+  CHECK(buffer.Find("!") == std::string_view::npos);
+  CHECK(buffer.Retrieve(7) == "hello\r\n");
+  CHECK(buffer.View() == "world");
+  // consuming everything rewinds the indexes
+  buffer.Consume(5);
+  CHECK(buffer.Empty());
+  CHECK(buffer.WritableBytes() == buffer.Capacity());
+
+  // room at the front is reused before growing
+  std::string chunk(3000, 'a');
+  buffer.Append(chunk);
+  buffer.Consume(2900);
+  buffer.Append(chunk);
+  CHECK(buffer.Capacity() == Net::BufferPool::kMinBlockSize);
+  CHECK(buffer.ReadableBytes() == 3100);
+  // grow keeps the readable bytes
+  buffer.Append(chunk);
+  CHECK(buffer.Capacity() > Net::BufferPool::kMinBlockSize);
+  CHECK(buffer.ReadableBytes() == 6100);
+  CHECK(buffer.View() == std::string(6100, 'a'));
+
+  Net::Buffer other(std::move(buffer));
+  CHECK(buffer.Capacity() == 0);
+  CHECK(other.ReadableBytes() == 6100);
+  other.Shrink();
+  CHECK(other.Capacity() != 0);
+  other.ConsumeAll();
+  other.Shrink();
+  CHECK(other.Capacity() == 0);
+}
+
+TEST_CASE("test buffer pool") {
+  size_t size = 5000;
+  auto block = Net::BufferPool::Allocate(size);
+  CHECK(size == 8192);
+  Net::BufferPool::Deallocate(block, size);
+  auto stats = Net::BufferPool::ThisThreadStats();
+  size = 8000;
+  auto again = Net::BufferPool::Allocate(size);
+  CHECK(again == block);
+  CHECK(Net::BufferPool::ThisThreadStats().recycled == stats.recycled + 1);
+  Net::BufferPool::Deallocate(again, size);
+  // not pooled
+  size = Net::BufferPool::kMaxPooledBlockSize + 1;
+  auto big = Net::BufferPool::Allocate(size);
+  CHECK(size == 2 * Net::BufferPool::kMaxPooledBlockSize);
+  Net::BufferPool::Deallocate(big, size);
+}
+
+Base::Task<> DoBufferedSocket(Base::IoService& service, int fd, int peer) {
+  Net::TcpSocket socket(service, Net::IpAddress(), Net::IpAddress(), fd);
+  Net::BufferedSocket stream(socket, 64);
+  // the delim arrives split over two writes
+  CHECK(write(peer, "GET / HTTP/1.1\r", 15) == 15);
+  CHECK(write(peer, "\nbody12345", 10) == 10);
+  auto n = co_await stream.ReadUntil("\r\n");
+  CHECK(n == 16);
+  CHECK(stream.Peek().substr(0, 16) == "GET / HTTP/1.1\r\n");
+  stream.Consume(static_cast<size_t>(n));
+  CHECK(co_await stream.ReadExactly(9) == 9);
+  CHECK(stream.Peek() == "body12345");
+  stream.Consume(9);
+  // a full buffer without the delim fails
+  CHECK(write(peer, "abcdef", 6) == 6);
+  CHECK(co_await stream.ReadUntil("\n", 4) == -1);
+  CHECK(errno == EMSGSIZE);
+  stream.Consume(stream.ReadableBytes());
+  // a long message takes one block, the idle shrink must not undo it
+  std::string message(20000, 'm');
+  CHECK(write(peer, message.data(), message.size()) == 20000);
+  auto before = Net::BufferPool::ThisThreadStats();
+  CHECK(co_await stream.ReadExactly(20000) == 20000);
+  auto after = Net::BufferPool::ThisThreadStats();
+  CHECK(after.allocated + after.recycled ==
+        before.allocated + before.recycled + 1);
+  CHECK(stream.Peek() == message);
+  stream.Consume(20000);
+
+  // small writes stay in the buffer until a flush
+  CHECK(co_await stream.Write("ab", 2));
+  CHECK(co_await stream.Write("cd", 2));
+  char buf[128];
+  CHECK(read(peer, buf, sizeof buf) == -1);
+  CHECK(co_await stream.Flush());
+  CHECK(stream.GetWriteBuffer().Capacity() == 0);
+  CHECK(read(peer, buf, sizeof buf) == 4);
+  CHECK(std::string_view(buf, 4) == "abcd");
+  // reaching the threshold flushes
+  std::string big(100, 'x');
+  CHECK(co_await stream.Write("ab", 2));
+  CHECK(co_await stream.Write(big));
+  CHECK(read(peer, buf, sizeof buf) == 102);
+
+  close(peer);
+  CHECK(co_await stream.Fill() == 0);
+  socket.Close();
+  service.Stop();
+}
+
+TEST_CASE("test buffered socket") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                     fds) == 0);
+  Base::IoService service;
+  service.CoSpawn(DoBufferedSocket(service, fds[0], fds[1]));
+  service.Start();
+}
@@ -0,0 +1,384 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Acceptor.h"
+#include "cold/net/Resolver.h"
+#include "cold/net/TcpSocket.h"
+#include "cold/net/UdpSocket.h"
+#include "cold/time/Timer.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+// a stand-in dns server on the loopback, udp and tcp on the same port.
+// answers are fixed by name:
+//   a.test      A 10.0.0.1 10.0.0.2, AAAA fd00::1
+//   alias.test  CNAME a.test, A 10.0.0.1
+//   zero.test   A 10.0.0.3 with ttl 0
+//   big.test    truncated over udp, A 10.0.0.9 over tcp
+//   slow.test   A 10.0.0.4 and AAAA fd00::4, 50ms late
+//   n<i>.test   A 10.0.0.5
+//   empty.test  no A, no AAAA with a soa of minimum 1
+//   any other   NXDOMAIN
+class FakeDnsServer {
+ public:
+  FakeDnsServer(Base::IoService& service, uint16_t port)
+      : service_(&service),
+        addr_(port, true),
+        udp_(service),
+        acceptor_(service, addr_, false) {
+    REQUIRE(udp_.Bind(addr_));
+    acceptor_.Listen();
+    service.CoSpawn(DoUdp());
+    service.CoSpawn(DoTcp());
+  }
+
+  // queries by name and type, e.g. "a.test/1"
+  std::map<std::string, int> udpQueries;
+  std::map<std::string, int> tcpQueries;
+  // queries of slow.test not answered yet
+  int slowInFlight = 0;
+  int maxSlowInFlight = 0;
+
+ private:
+  static void Put16(std::string& buf, uint16_t v) {
+    buf.push_back(static_cast<char>(v >> 8));
+    buf.push_back(static_cast<char>(v & 0xff));
+  }
+
+  static void Put32(std::string& buf, uint32_t v) {
+    Put16(buf, static_cast<uint16_t>(v >> 16));
+    Put16(buf, static_cast<uint16_t>(v & 0xffff));
+  }
+
+  // the record of the name asked, by a pointer to the question
+  static void PutRecord(std::string& buf, uint16_t type, uint32_t ttl,
+                        const std::string& rdata) {
+    Put16(buf, 0xc00c);
+    Put16(buf, type);
+    Put16(buf, 1);
+    Put32(buf, ttl);
+    Put16(buf, static_cast<uint16_t>(rdata.size()));
+    buf += rdata;
+  }
+
+  static std::string V4(uint8_t last) { return {10, 0, 0, (char)last}; }
+
+  std::string Answer(std::string_view query, bool tcp) {
+    // the name of the question
+    std::string name;
+    size_t offset = 12;
+    while (query[offset] != 0) {
+      auto len = static_cast<size_t>(query[offset]);
+      if (!name.empty()) name.push_back('.');
+      name.append(query.substr(offset + 1, len));
+      offset += 1 + len;
+    }
+    auto type = static_cast<uint16_t>(
+        (static_cast<uint8_t>(query[offset + 1]) << 8) |
+        static_cast<uint8_t>(query[offset + 2]));
+    auto questionEnd = offset + 5;
+    auto key = name + "/" + std::to_string(type);
+    ++(tcp ? tcpQueries : udpQueries)[key];
+
+    std::string records;
+    uint16_t count = 0;
+    uint16_t authorities = 0;
+    uint16_t flags = 0x8180;
+    if (name == "a.test" && type == 1) {
+      PutRecord(records, 1, 60, V4(1));
+      PutRecord(records, 1, 60, V4(2));
+      count = 2;
+    } else if (name == "a.test" && type == 28) {
+      std::string v6(16, '\0');
+      v6[0] = '\xfd';
+      v6[15] = 1;
+      PutRecord(records, 28, 60, v6);
+      count = 1;
+    } else if (name == "slow.test" && type == 1) {
+      PutRecord(records, 1, 60, V4(4));
+      count = 1;
+    } else if (name == "slow.test" && type == 28) {
+      std::string v6(16, '\0');
+      v6[0] = '\xfd';
+      v6[15] = 4;
+      PutRecord(records, 28, 60, v6);
+      count = 1;
+    } else if (name.starts_with("n") && name.ends_with(".test") &&
+               type == 1) {
+      PutRecord(records, 1, 60, V4(5));
+      count = 1;
+    } else if (name == "alias.test" && type == 1) {
+      // rdata: a.test
+      PutRecord(records, 5, 30, std::string("\1a\4test\0", 8));
+      PutRecord(records, 1, 30, V4(1));
+      count = 2;
+    } else if (name == "zero.test" && type == 1) {
+      PutRecord(records, 1, 0, V4(3));
+      count = 1;
+    } else if (name == "big.test" && type == 1 && !tcp) {
+      flags |= 0x0200;
+    } else if (name == "big.test" && type == 1) {
+      PutRecord(records, 1, 60, V4(9));
+      count = 1;
+    } else if (name == "empty.test" && type == 1) {
+    } else if (name == "empty.test" && type == 28) {
+      // rdata: root mname and rname, serial, refresh, retry, expire, minimum
+      std::string soa(2, '\0');
+      for (uint32_t field : {1u, 3600u, 600u, 86400u, 1u}) Put32(soa, field);
+      PutRecord(records, 6, 60, soa);
+      authorities = 1;
+    } else if (type == 1 || type == 28) {
+      flags |= 3;
+    }
+    std::string reply(query.substr(0, 2));
+    Put16(reply, flags);
+    Put16(reply, 1);
+    Put16(reply, count);
+    Put16(reply, authorities);
+    Put16(reply, 0);
+    reply.append(query.substr(12, questionEnd - 12));
+    reply += records;
+    return reply;
+  }
+
+  Base::Task<> DoUdp() {
+    char buf[512];
+    while (true) {
+      Net::IpAddress source;
+      auto n = co_await udp_.RecvFrom(buf, sizeof buf, source);
+      if (n <= 0) continue;
+      std::string_view query(buf, static_cast<size_t>(n));
+      auto reply = Answer(query, false);
+      if (query.find("\4slow\4test") != std::string_view::npos) {
+        service_->CoSpawn(SendLate(std::move(reply), source));
+        continue;
+      }
+      co_await udp_.SendTo(reply.data(), reply.size(), source);
+    }
+  }
+
+  Base::Task<> SendLate(std::string reply, Net::IpAddress dest) {
+    maxSlowInFlight = std::max(maxSlowInFlight, ++slowInFlight);
+    co_await Base::Sleep(*service_, std::chrono::milliseconds(50));
+    --slowInFlight;
+    co_await udp_.SendTo(reply.data(), reply.size(), dest);
+  }
+
+  Base::Task<> DoTcp() {
+    while (true) {
+      auto socket = co_await acceptor_.Accept();
+      char header[2];
+      auto n = co_await socket.ReadN(header, 2);
+      if (n != 2) continue;
+      std::string query(static_cast<size_t>(
+                            (static_cast<uint8_t>(header[0]) << 8) |
+                            static_cast<uint8_t>(header[1])),
+                        '\0');
+      n = co_await socket.ReadN(query.data(), query.size());
+      if (n < 0) continue;
+      auto answer = Answer(query, true);
+      std::string reply;
+      Put16(reply, static_cast<uint16_t>(answer.size()));
+      reply += answer;
+      co_await socket.WriteN(reply.data(), reply.size());
+      socket.Close();
+    }
+  }
+
+  Base::IoService* service_;
+  Net::IpAddress addr_;
+  Net::UdpSocket udp_;
+  Net::Acceptor acceptor_;
+};
+
+constexpr uint16_t kDnsPort = 18853;
+// nothing listens there, so the resolver moves on to the next one
+constexpr uint16_t kDeadDnsPort = 18854;
+
+void SetTestConfig() {
+  std::ofstream hosts("/tmp/cold-resolver-hosts");
+  hosts << "# test hosts\n"
+        << "10.1.1.1\tmyhost.test myalias  # comment\n"
+        << "::2 myhost.test\n";
+  hosts.close();
+  Net::Resolver::Config config;
+  config.nameservers = {Net::IpAddress(kDeadDnsPort, true),
+                        Net::IpAddress(kDnsPort, true)};
+  config.hostsPath = "/tmp/cold-resolver-hosts";
+  config.timeout = std::chrono::milliseconds(1000);
+  config.attempts = 1;
+  Net::Resolver::SetConfig(config);
+}
+
+std::vector<std::string> IpPorts(const std::vector<Net::IpAddress>& addrs) {
+  std::vector<std::string> result;
+  for (auto& addr : addrs) result.push_back(addr.GetIpPort());
+  return result;
+}
+
+using Strings = std::vector<std::string>;
+using Family = Net::Resolver::Family;
+
+Base::Task<> DoResolve(Base::IoService& service, FakeDnsServer& server) {
+  auto addrs = co_await Net::Resolver::Resolve(service, "127.0.0.1", 80);
+  CHECK(IpPorts(addrs) == Strings{"127.0.0.1:80"});
+  addrs = co_await Net::Resolver::Resolve(service, "[::1]", 80, Family::kAny);
+  CHECK(IpPorts(addrs) == Strings{"[::1]:80"});
+  addrs = co_await Net::Resolver::Resolve(service, "::1", 80);
+  CHECK(addrs.empty());
+
+  // the hosts file
+  addrs = co_await Net::Resolver::Resolve(service, "MyHost.test", 80);
+  CHECK(IpPorts(addrs) == Strings{"10.1.1.1:80"});
+  addrs = co_await Net::Resolver::Resolve(service, "myhost.test.", 80,
+                                          Family::kAny);
+  CHECK(IpPorts(addrs) == Strings{"10.1.1.1:80", "[::2]:80"});
+  addrs = co_await Net::Resolver::Resolve(service, "myalias", 81);
+  CHECK(IpPorts(addrs) == Strings{"10.1.1.1:81"});
+  CHECK(server.udpQueries.empty());
+
+  // udp, then the cache
+  addrs = co_await Net::Resolver::Resolve(service, "a.test", 443);
+  CHECK(IpPorts(addrs) == Strings{"10.0.0.1:443", "10.0.0.2:443"});
+  addrs = co_await Net::Resolver::Resolve(service, "A.TEST", 80);
+  CHECK(IpPorts(addrs) == Strings{"10.0.0.1:80", "10.0.0.2:80"});
+  CHECK(server.udpQueries["a.test/1"] == 1);
+  CHECK(Net::Resolver::CacheSize() == 1);
+  addrs = co_await Net::Resolver::Resolve(service, "a.test", 80, Family::kAny);
+  CHECK(IpPorts(addrs) ==
+        Strings{"[fd00::1]:80", "10.0.0.1:80", "10.0.0.2:80"});
+  CHECK(server.udpQueries["a.test/28"] == 1);
+  CHECK(server.udpQueries["a.test/1"] == 1);
+  Net::Resolver::ClearCache();
+  addrs = co_await Net::Resolver::Resolve(service, "a.test", 80);
+  CHECK(addrs.size() == 2);
+  CHECK(server.udpQueries["a.test/1"] == 2);
+
+  // the chain of an alias
+  addrs = co_await Net::Resolver::Resolve(service, "alias.test", 80);
+  CHECK(IpPorts(addrs) == Strings{"10.0.0.1:80"});
+
+  // a ttl of 0 is not cached
+  addrs = co_await Net::Resolver::Resolve(service, "zero.test", 80);
+  addrs = co_await Net::Resolver::Resolve(service, "zero.test", 80);
+  CHECK(IpPorts(addrs) == Strings{"10.0.0.3:80"});
+  CHECK(server.udpQueries["zero.test/1"] == 2);
+
+  // no such record: not cached without a soa, else for its minimum
+  addrs = co_await Net::Resolver::Resolve(service, "empty.test", 80);
+  addrs = co_await Net::Resolver::Resolve(service, "empty.test", 80);
+  CHECK(addrs.empty());
+  CHECK(server.udpQueries["empty.test/1"] == 2);
+  addrs = co_await Net::Resolver::Resolve(service, "empty.test", 80,
+                                          Family::kIpv6);
+  addrs = co_await Net::Resolver::Resolve(service, "empty.test", 80,
+                                          Family::kIpv6);
+  CHECK(addrs.empty());
+  CHECK(server.udpQueries["empty.test/28"] == 1);
+  co_await Base::Sleep(service, std::chrono::milliseconds(1100));
+  addrs = co_await Net::Resolver::Resolve(service, "empty.test", 80,
+                                          Family::kIpv6);
+  CHECK(server.udpQueries["empty.test/28"] == 2);
+
+  // truncated over udp
+  addrs = co_await Net::Resolver::Resolve(service, "big.test", 80);
+  CHECK(IpPorts(addrs) == Strings{"10.0.0.9:80"});
+  CHECK(server.udpQueries["big.test/1"] == 1);
+  CHECK(server.tcpQueries["big.test/1"] == 1);
+
+  addrs = co_await Net::Resolver::Resolve(service, "missing.test", 80);
+  CHECK(addrs.empty());
+  addrs = co_await Net::Resolver::Resolve(service, "bad..name", 80);
+  CHECK(addrs.empty());
+  service.Stop();
+}
+
+TEST_CASE("test resolver") {
+  SetTestConfig();
+  Base::IoService service;
+  FakeDnsServer server(service, kDnsPort);
+  service.CoSpawn(DoResolve(service, server));
+  service.Start();
+}
+
+Base::Task<> DoConcurrentResolve(Base::IoService& service, int& finished,
+                                 std::vector<std::string>& results) {
+  auto addrs = co_await Net::Resolver::Resolve(service, "a.test", 80);
+  for (auto& addr : addrs) results.push_back(addr.GetIpPort());
+  if (++finished == 3) service.Stop();
+}
+
+TEST_CASE("test resolver coalesces lookups") {
+  SetTestConfig();
+  Base::IoService service;
+  FakeDnsServer server(service, kDnsPort);
+  int finished = 0;
+  std::vector<std::string> results;
+  for (int i = 0; i < 3; ++i) {
+    service.CoSpawn(DoConcurrentResolve(service, finished, results));
+  }
+  service.Start();
+  CHECK(finished == 3);
+  CHECK(results.size() == 6);
+  CHECK(server.udpQueries["a.test/1"] == 1);
+}
+
+Base::Task<> DoResolveAny(Base::IoService& service, FakeDnsServer& server) {
+  auto addrs =
+      co_await Net::Resolver::Resolve(service, "slow.test", 80, Family::kAny);
+  CHECK(IpPorts(addrs) == Strings{"[fd00::4]:80", "10.0.0.4:80"});
+  // the A query went out before the AAAA answer came back
+  CHECK(server.maxSlowInFlight == 2);
+  service.Stop();
+}
+
+TEST_CASE("test resolver asks for both families at once") {
+  SetTestConfig();
+  Base::IoService service;
+  FakeDnsServer server(service, kDnsPort);
+  service.CoSpawn(DoResolveAny(service, server));
+  service.Start();
+}
+
+Base::Task<> DoFillCache(Base::IoService& service) {
+  for (int i = 0; i < 4100; ++i) {
+    auto name = "n" + std::to_string(i) + ".test";
+    auto addrs = co_await Net::Resolver::Resolve(service, name, 80);
+    CHECK(IpPorts(addrs) == Strings{"10.0.0.5:80"});
+  }
+  CHECK(Net::Resolver::CacheSize() == 4096);
+  service.Stop();
+}
+
+TEST_CASE("test resolver cache is bounded") {
+  SetTestConfig();
+  auto config = Net::Resolver::GetConfig();
+  config.nameservers = {Net::IpAddress(kDnsPort, true)};
+  Net::Resolver::SetConfig(config);
+  Base::IoService service;
+  FakeDnsServer server(service, kDnsPort);
+  service.CoSpawn(DoFillCache(service));
+  service.Start();
+}
+
+TEST_CASE("test load resolv.conf") {
+  std::ofstream file("/tmp/cold-resolv.conf");
+  file << "# comment\n"
+       << "search example.com\n"
+       << "nameserver 10.0.0.53\n"
+       << "nameserver ::1 ; comment\n"
+       << "options ndots:1 timeout:3 attempts:4\n";
+  file.close();
+  auto config = Net::Resolver::LoadConfig("/tmp/cold-resolv.conf");
+  CHECK(IpPorts(config.nameservers) == Strings{"10.0.0.53:53", "[::1]:53"});
+  CHECK(config.timeout == std::chrono::seconds(3));
+  CHECK(config.attempts == 4);
+  config = Net::Resolver::LoadConfig("/tmp/cold-no-such-resolv.conf");
+  CHECK(IpPorts(config.nameservers) == Strings{"127.0.0.1:53"});
+}
@@ -15,6 +15,8 @@ TEST_CASE("test socket options") {
   CHECK(socket.SetOption(Net::SocketOptions::TcpNoDelay(true)));
   CHECK(socket.SetOption(Net::SocketOptions::KeepAlive(true)));
   CHECK(socket.SetOption(Net::SocketOptions::Linger(true, 3)));
+  CHECK(socket.SetOption(Net::SocketOptions::BusyPoll(0)));
+  CHECK(socket.SetOption(Net::SocketOptions::TcpDeferAccept(3)));
   // Get
   Net::SocketOptions::ReuseAddress ReuseAddress;
   CHECK(ReuseAddress.value == 0);
@@ -38,4 +40,13 @@ TEST_CASE("test socket options") {
   CHECK(socket.GetOption(linger));
   CHECK(linger.value.l_onoff == 1);
   CHECK(linger.value.l_linger == 3);
+  Net::SocketOptions::BusyPoll busyPoll(-1);
+  CHECK(socket.GetOption(busyPoll));
+  CHECK(busyPoll.value == 0);
+  Net::SocketOptions::TcpDeferAccept deferAccept;
+  CHECK(socket.GetOption(deferAccept));
+  CHECK(deferAccept.value > 0);
+  Net::SocketOptions::IncomingCpu incomingCpu;
+  CHECK(socket.GetOption(incomingCpu));
+  CHECK(incomingCpu.value >= -1);
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Splice.h"
+#include "cold/net/TcpSocket.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+// a connected pair of sockets. first is the end of the user, second the
+// end forwarded
+std::pair<Net::TcpSocket, Net::TcpSocket> MakePair(Base::IoService& service) {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                     fds) == 0);
+  return {Net::TcpSocket(service, Net::IpAddress(), Net::IpAddress(), fds[0]),
+          Net::TcpSocket(service, Net::IpAddress(), Net::IpAddress(), fds[1])};
+}
+
+Base::Task<> DoSplice(Base::IoService& service, Net::TcpSocket& src,
+                      Net::TcpSocket& dst, int in, int out) {
+  CHECK(write(in, "hello world", 11) == 11);
+  CHECK(co_await Net::Splice(src, dst, 5) == 5);
+  char buf[16];
+  CHECK(read(out, buf, sizeof buf) == 5);
+  CHECK(std::string_view(buf, 5) == "hello");
+  CHECK(co_await Net::Splice(src, dst, 100) == 6);
+  CHECK(read(out, buf, sizeof buf) == 6);
+  shutdown(in, SHUT_WR);
+  CHECK(co_await Net::Splice(src, dst, 100) == 0);
+  service.Stop();
+}
+
+TEST_CASE("test splice") {
+  Base::IoService service;
+  auto [in, src] = MakePair(service);
+  auto [dst, out] = MakePair(service);
+  service.CoSpawn(DoSplice(service, src, dst, in.NativeHandle(),
+                           out.NativeHandle()));
+  service.Start();
+}
+
+Base::Task<> DoForward(Net::TcpSocket& a, Net::TcpSocket& b,
+                       std::pair<size_t, size_t>& bytes) {
+  bytes = co_await Net::Forward(a, b);
+}
+
+Base::Task<> DoClient(Base::IoService& service, Net::TcpSocket& client,
+                      const std::string& data, std::string& reply) {
+  auto n = co_await client.WriteN(data.data(), data.size());
+  CHECK(n == static_cast<ssize_t>(data.size()));
+  client.ShutDown();
+  char buf[4096];
+  while (true) {
+    auto ret = co_await client.Read(buf, sizeof buf);
+    if (ret <= 0) break;
+    reply.append(buf, static_cast<size_t>(ret));
+  }
+  service.Stop();
+}
+
+Base::Task<> DoServer(Net::TcpSocket& server, std::string& received) {
+  std::string buf(65536, '\0');
+  while (true) {
+    auto ret = co_await server.Read(buf.data(), buf.size());
+    if (ret <= 0) break;
+    received.append(buf.data(), static_cast<size_t>(ret));
+  }
+  auto n = co_await server.WriteN("done", 4);
+  CHECK(n == 4);
+  server.Close();
+}
+
+TEST_CASE("test forward") {
+  Base::IoService service;
+  auto [client, a] = MakePair(service);
+  auto [server, b] = MakePair(service);
+  std::string data(1 << 20, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+  std::pair<size_t, size_t> bytes;
+  std::string received;
+  std::string reply;
+  service.CoSpawn(DoForward(a, b, bytes));
+  service.CoSpawn(DoServer(server, received));
+  service.CoSpawn(DoClient(service, client, data, reply));
+  service.Start();
+  CHECK(received == data);
+  CHECK(reply == "done");
+  CHECK(bytes.first == data.size());
+  CHECK(bytes.second == 4);
+}
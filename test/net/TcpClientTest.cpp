@@ -0,0 +1,161 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Acceptor.h"
+#include "cold/net/Resolver.h"
+#include "cold/net/TcpClient.h"
+#include "cold/time/Timer.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+constexpr uint16_t kLivePort = 18860;
+// nothing listens there, a connect is refused at once
+constexpr uint16_t kDeadPort = 18861;
+// its accept queue is full, a connect hangs
+constexpr uint16_t kFullPort = 18862;
+
+size_t CountFds() {
+  size_t count = 0;
+  for ([[maybe_unused]] auto& entry :
+       std::filesystem::directory_iterator("/proc/self/fd")) {
+    ++count;
+  }
+  return count;
+}
+
+// a listener with a backlog of 0 holds one connection that is never
+// accepted, the SYNs after it are dropped
+class FullListener {
+ public:
+  FullListener() {
+    Net::IpAddress addr(kFullPort, true);
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    REQUIRE(bind(fd_, addr.GetSockaddr(), sizeof(struct sockaddr_in)) == 0);
+    REQUIRE(listen(fd_, 0) == 0);
+    filler_ = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(connect(filler_, addr.GetSockaddr(),
+                    sizeof(struct sockaddr_in)) == 0);
+  }
+
+  ~FullListener() {
+    close(filler_);
+    close(fd_);
+  }
+
+ private:
+  int fd_;
+  int filler_;
+};
+
+using Addrs = std::vector<Net::IpAddress>;
+
+Base::Task<> DoFailover(Base::IoService& service) {
+  auto start = Base::MonoTime::Now();
+  Addrs addrs{Net::IpAddress(kDeadPort, true), Net::IpAddress(kLivePort, true)};
+  auto socket = co_await Net::TcpClient::ConnectFirst(
+      service, addrs, std::chrono::seconds(10));
+  // the refused attempt starts the next one without the stagger
+  CHECK(Base::MonoTime::Now() - start < std::chrono::seconds(5));
+  REQUIRE(socket);
+  CHECK(socket->IsConnected());
+  CHECK(socket->GetRemoteAddress().GetPort() == kLivePort);
+  service.Stop();
+}
+
+TEST_CASE("test connect first fails over") {
+  Base::IoService service;
+  Net::Acceptor acceptor(service, Net::IpAddress(kLivePort, true), false);
+  acceptor.Listen();
+  service.CoSpawn(DoFailover(service));
+  service.Start();
+}
+
+Base::Task<> DoStagger(Base::IoService& service) {
+  auto fds = CountFds();
+  auto start = Base::MonoTime::Now();
+  Addrs addrs{Net::IpAddress(kFullPort, true), Net::IpAddress(kLivePort, true)};
+  auto socket = co_await Net::TcpClient::ConnectFirst(
+      service, addrs, std::chrono::milliseconds(100));
+  auto elapsed = Base::MonoTime::Now() - start;
+  CHECK(elapsed >= std::chrono::milliseconds(100));
+  // before the first SYN is sent again
+  CHECK(elapsed < std::chrono::milliseconds(900));
+  REQUIRE(socket);
+  CHECK(socket->GetRemoteAddress().GetPort() == kLivePort);
+  // the hanging attempt is cancelled and its socket closed
+  co_await Base::Sleep(service, std::chrono::milliseconds(100));
+  CHECK(CountFds() == fds + 1);
+  service.Stop();
+}
+
+TEST_CASE("test connect first staggers the attempts") {
+  FullListener full;
+  Base::IoService service;
+  Net::Acceptor acceptor(service, Net::IpAddress(kLivePort, true), false);
+  acceptor.Listen();
+  service.CoSpawn(DoStagger(service));
+  service.Start();
+}
+
+Base::Task<> DoAllFail(Base::IoService& service) {
+  Addrs addrs{Net::IpAddress(kDeadPort, true),
+              Net::IpAddress(kDeadPort + 10, true)};
+  auto socket = co_await Net::TcpClient::ConnectFirst(service, addrs);
+  auto error = errno;
+  CHECK(!socket);
+  CHECK(error == ECONNREFUSED);
+  Addrs none;
+  socket = co_await Net::TcpClient::ConnectFirst(service, none);
+  CHECK(!socket);
+  service.Stop();
+}
+
+TEST_CASE("test connect first fails") {
+  Base::IoService service;
+  service.CoSpawn(DoAllFail(service));
+  service.Start();
+}
+
+class EyeballsClient : public Net::TcpClient {
+ public:
+  explicit EyeballsClient(Base::IoService& service) : TcpClient(service) {}
+
+  bool connected = false;
+  uint16_t port = 0;
+
+ protected:
+  Base::Task<> OnConnect() override {
+    connected = true;
+    port = socket_.GetRemoteAddress().GetPort();
+    socket_.GetIoService().Stop();
+    co_return;
+  }
+};
+
+TEST_CASE("test connect any by name") {
+  // ::1 is tried first, nothing listens there
+  std::ofstream hosts("/tmp/cold-tcpclient-hosts");
+  hosts << "127.0.0.1 eyeballs.test\n::1 eyeballs.test\n";
+  hosts.close();
+  auto config = Net::Resolver::GetConfig();
+  config.hostsPath = "/tmp/cold-tcpclient-hosts";
+  Net::Resolver::SetConfig(config);
+
+  Base::IoService service;
+  Net::Acceptor acceptor(service, Net::IpAddress(kLivePort, true), false);
+  acceptor.Listen();
+  EyeballsClient client(service);
+  service.CoSpawn(client.ConnectAny("eyeballs.test", kLivePort,
+                                    std::chrono::milliseconds(100)));
+  service.Start();
+  CHECK(client.connected);
+  CHECK(client.port == kLivePort);
+}
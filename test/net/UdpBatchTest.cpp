@@ -0,0 +1,115 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <string>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/SocketOptions.h"
+#include "cold/net/UdpSocket.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+Base::Task<> DoBatch(Base::IoService& service, Net::UdpSocket& sender,
+                     Net::UdpSocket& receiver, const Net::IpAddress& addr) {
+  std::vector<std::string> data;
+  std::vector<Net::UdpMessage> msgs(10);
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    data.push_back("message " + std::to_string(i));
+  }
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    msgs[i].data = data[i].data();
+    msgs[i].len = data[i].size();
+    msgs[i].addr = addr;
+  }
+  auto n = co_await sender.SendBatch(msgs.data(), msgs.size());
+  CHECK(n == 10);
+  CHECK(msgs[9].bytes == data[9].size());
+
+  char bufs[16][1024];
+  std::vector<Net::UdpMessage> recvMsgs(16);
+  for (size_t i = 0; i < recvMsgs.size(); ++i) {
+    recvMsgs[i].data = bufs[i];
+    recvMsgs[i].len = sizeof bufs[i];
+  }
+  n = co_await receiver.RecvBatch(recvMsgs.data(), recvMsgs.size());
+  CHECK(n == 10);
+  for (size_t i = 0; i < 10; ++i) {
+    CHECK(std::string_view(bufs[i], recvMsgs[i].bytes) == data[i]);
+    CHECK(recvMsgs[i].addr.GetIp() == "127.0.0.1");
+    CHECK(recvMsgs[i].segmentSize == 0);
+  }
+
+  // one send of 4 datagrams
+  std::string big(4000, 'x');
+  Net::UdpMessage gso;
+  gso.data = big.data();
+  gso.len = big.size();
+  gso.addr = addr;
+  gso.segmentSize = 1000;
+  n = co_await sender.SendBatch(&gso, 1);
+  CHECK(n == 1);
+  CHECK(gso.bytes == big.size());
+  n = co_await receiver.RecvBatch(recvMsgs.data(), recvMsgs.size());
+  CHECK(n == 4);
+  for (size_t i = 0; i < 4; ++i) CHECK(recvMsgs[i].bytes == 1000);
+
+  auto ret = co_await receiver.RecvBatchWithTimeout(
+      recvMsgs.data(), recvMsgs.size(), std::chrono::milliseconds(10));
+  CHECK(ret == -1);
+  CHECK(errno == ETIMEDOUT);
+  service.Stop();
+}
+
+TEST_CASE("test udp batch") {
+  Base::IoService service;
+  Net::IpAddress addr(18890, true);
+  Net::UdpSocket sender(service);
+  Net::UdpSocket receiver(service);
+  REQUIRE(receiver.Bind(addr));
+  service.CoSpawn(DoBatch(service, sender, receiver, addr));
+  service.Start();
+}
+
+Base::Task<> DoGro(Base::IoService& service, Net::UdpSocket& sender,
+                   Net::UdpSocket& receiver, const Net::IpAddress& addr) {
+  std::string big(8000, 'x');
+  Net::UdpMessage gso;
+  gso.data = big.data();
+  gso.len = big.size();
+  gso.addr = addr;
+  auto n = co_await sender.SendBatch(&gso, 1);
+  CHECK(n == 1);
+  // coalesced or not, every byte arrives in datagrams of 1000
+  std::string buf(65536, '\0');
+  Net::UdpMessage msg;
+  msg.data = buf.data();
+  msg.len = buf.size();
+  size_t total = 0;
+  while (total < big.size()) {
+    n = co_await receiver.RecvBatch(&msg, 1);
+    REQUIRE(n == 1);
+    if (msg.segmentSize == 0) {
+      CHECK(msg.bytes == 1000);
+    } else {
+      CHECK(msg.segmentSize == 1000);
+    }
+    total += msg.bytes;
+  }
+  CHECK(total == big.size());
+  service.Stop();
+}
+
+TEST_CASE("test udp gso and gro") {
+  Base::IoService service;
+  Net::IpAddress addr(18891, true);
+  Net::UdpSocket sender(service);
+  Net::UdpSocket receiver(service);
+  REQUIRE(receiver.Bind(addr));
+  CHECK(sender.SetOption(Net::SocketOptions::UdpSegment(1000)));
+  CHECK(receiver.SetOption(Net::SocketOptions::UdpGro(true)));
+  Net::SocketOptions::UdpGro gro;
+  CHECK(receiver.GetOption(gro));
+  CHECK(gro.value == 1);
+  service.CoSpawn(DoGro(service, sender, receiver, addr));
+  service.Start();
+}
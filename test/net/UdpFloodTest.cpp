@@ -0,0 +1,142 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/IpAddress.h"
+#include "cold/net/SocketOptions.h"
+#include "cold/net/UdpSocket.h"
+#include "cold/time/Time.h"
+
+using namespace Cold;
+
+// flood a receiver on the loopback for a while, once with SendTo/RecvFrom,
+// once with SendBatch/RecvBatch and once with GSO and GRO on top. print
+// the datagrams sent and received per second
+
+enum class Mode { kSingle, kBatch, kGso };
+
+constexpr size_t kPayloadSize = 64;
+constexpr size_t kBatch = Net::UdpBatchStorage::kMaxBatch;
+constexpr auto kFloodTime = std::chrono::seconds(2);
+constexpr auto kIdleTime = std::chrono::milliseconds(200);
+
+double Seconds(Base::Time::TimePoint::duration duration) {
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::microseconds>(duration)
+                 .count()) /
+         1e6;
+}
+
+Base::Task<> Flood(Base::IoService& service, Net::UdpSocket& socket,
+                   Net::IpAddress addr, Mode mode, size_t& sent) {
+  std::string payload(kPayloadSize * kBatch, 'x');
+  std::vector<Net::UdpMessage> msgs(kBatch);
+  for (size_t i = 0; i < kBatch; ++i) {
+    msgs[i].data = payload.data() + i * kPayloadSize;
+    msgs[i].len = kPayloadSize;
+    msgs[i].addr = addr;
+  }
+  if (mode == Mode::kGso) {
+    // the whole payload in one send
+    msgs[0].data = payload.data();
+    msgs[0].len = payload.size();
+    msgs[0].segmentSize = kPayloadSize;
+  }
+  auto end = Base::Time::Now() + kFloodTime;
+  while (Base::Time::Now() < end) {
+    if (mode == Mode::kSingle) {
+      auto n = co_await socket.SendTo(payload.data(), kPayloadSize, addr);
+      if (n < 0) break;
+      ++sent;
+    } else if (mode == Mode::kBatch) {
+      auto n = co_await socket.SendBatch(msgs.data(), kBatch);
+      if (n < 0) break;
+      sent += static_cast<size_t>(n);
+    } else {
+      auto n = co_await socket.SendBatch(msgs.data(), 1);
+      if (n < 0) break;
+      sent += msgs[0].bytes / kPayloadSize;
+    }
+  }
+  if (Base::Time::Now() < end) {
+    Base::ERROR("Flood error. reason: {}", Base::ThisThread::ErrorMsg());
+  }
+  service.Stop();
+}
+
+Base::Task<> Drain(Base::IoService& service, Net::UdpSocket& socket,
+                   Mode mode, size_t& received, double& seconds) {
+  std::string buf(65536 * kBatch, '\0');
+  std::vector<Net::UdpMessage> msgs(kBatch);
+  for (size_t i = 0; i < kBatch; ++i) {
+    msgs[i].data = buf.data() + i * 65536;
+    msgs[i].len = 65536;
+  }
+  Net::IpAddress source;
+  Base::Time start;
+  Base::Time last;
+  // the flood may not have started yet
+  auto wait = Base::Time::Now() + kFloodTime;
+  while (true) {
+    ssize_t n = 0;
+    if (mode == Mode::kSingle) {
+      n = co_await socket.RecvFromWithTimeout(buf.data(), buf.size(), source,
+                                              kIdleTime);
+      if (n >= 0) n = 1;
+    } else {
+      n = co_await socket.RecvBatchWithTimeout(msgs.data(), kBatch, kIdleTime);
+    }
+    if (n < 0 && received == 0 && Base::Time::Now() < wait) continue;
+    if (n < 0) break;
+    if (received == 0) start = Base::Time::Now();
+    last = Base::Time::Now();
+    if (mode != Mode::kGso) {
+      received += static_cast<size_t>(n);
+      continue;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(n); ++i) {
+      auto size = msgs[i].segmentSize ? msgs[i].segmentSize : msgs[i].bytes;
+      received += msgs[i].bytes / size;
+    }
+  }
+  seconds = Seconds(last - start);
+  service.Stop();
+}
+
+void Bench(Mode mode, const char* name) {
+  Base::IoService recvService;
+  Base::IoService sendService;
+  Net::IpAddress addr(18892, true);
+  Net::UdpSocket receiver(recvService);
+  Net::UdpSocket sender(sendService);
+  if (!receiver.Bind(addr)) {
+    Base::ERROR("Cannot bind {}. reason: {}", addr.GetIpPort(),
+                Base::ThisThread::ErrorMsg());
+    return;
+  }
+  if (mode == Mode::kGso &&
+      !receiver.SetOption(Net::SocketOptions::UdpGro(true))) {
+    Base::WARN("UDP_GRO is not supported. reason: {}",
+               Base::ThisThread::ErrorMsg());
+  }
+  size_t sent = 0;
+  size_t received = 0;
+  double seconds = 0;
+  recvService.CoSpawn(Drain(recvService, receiver, mode, received, seconds));
+  sendService.CoSpawn(Flood(sendService, sender, addr, mode, sent));
+  std::thread recvThread([&]() { recvService.Start(); });
+  auto start = Base::Time::Now();
+  sendService.Start();
+  auto sendSeconds = Seconds(Base::Time::Now() - start);
+  recvThread.join();
+  Base::INFO("{}: sent {} datagrams, {:.0f}/s. received {} datagrams, {:.0f}/s",
+             name, sent, static_cast<double>(sent) / sendSeconds, received,
+             seconds > 0 ? static_cast<double>(received) / seconds : 0.0);
+}
+
+int main() {
+  Bench(Mode::kSingle, "sendto/recvfrom");
+  Bench(Mode::kBatch, "sendmmsg/recvmmsg");
+  Bench(Mode::kGso, "sendmmsg/recvmmsg with gso/gro");
+}
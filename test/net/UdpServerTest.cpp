@@ -0,0 +1,91 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "cold/net/UdpServer.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+class EchoServer : public Net::UdpServer {
+ public:
+  EchoServer(const Net::IpAddress& addr, size_t poolSize)
+      : Net::UdpServer(addr, poolSize) {}
+
+  std::atomic<size_t> received = 0;
+
+ protected:
+  Base::Task<> OnDatagram(Net::UdpSocket& socket, std::string_view data,
+                          const Net::IpAddress& source) override {
+    if (data != "ping") ++received;
+    co_await socket.SendTo(data.data(), data.size(), source);
+  }
+};
+
+// the server binds in its own thread
+void WaitReady(const Net::IpAddress& addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  REQUIRE(fd >= 0);
+  struct timeval timeout {0, 100000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+  char buf[16];
+  for (int i = 0; i < 50; ++i) {
+    sendto(fd, "ping", 4, 0, addr.GetSockaddr(), sizeof(struct sockaddr_in));
+    if (recv(fd, buf, sizeof buf, 0) == 4) break;
+  }
+  close(fd);
+}
+
+// echo from every client and return the replies
+size_t RunClients(const Net::IpAddress& addr, size_t clients,
+                  size_t datagrams) {
+  size_t replies = 0;
+  for (size_t i = 0; i < clients; ++i) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    REQUIRE(fd >= 0);
+    struct timeval timeout {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    REQUIRE(connect(fd, addr.GetSockaddr(), sizeof(struct sockaddr_in)) == 0);
+    for (size_t j = 0; j < datagrams; ++j) {
+      auto data = std::to_string(i) + ":" + std::to_string(j);
+      REQUIRE(send(fd, data.data(), data.size(), 0) ==
+              static_cast<ssize_t>(data.size()));
+      char buf[64];
+      auto n = recv(fd, buf, sizeof buf, 0);
+      if (n < 0) continue;
+      CHECK(std::string_view(buf, static_cast<size_t>(n)) == data);
+      ++replies;
+    }
+    close(fd);
+  }
+  return replies;
+}
+
+TEST_CASE("test udp server") {
+  Net::IpAddress addr(18893, true);
+  EchoServer server(addr, 2);
+  std::thread thread([&]() { server.Start(); });
+  WaitReady(addr);
+  auto replies = RunClients(addr, 8, 20);
+  server.Stop();
+  thread.join();
+  CHECK(replies == 160);
+  CHECK(server.received == 160);
+}
+
+TEST_CASE("test udp server with gro") {
+  Net::IpAddress addr(18894, true);
+  EchoServer server(addr, 0);
+  server.EnableGro(true);
+  std::thread thread([&]() { server.Start(); });
+  WaitReady(addr);
+  auto replies = RunClients(addr, 2, 20);
+  server.Stop();
+  thread.join();
+  CHECK(replies == 40);
+}
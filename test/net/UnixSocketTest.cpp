@@ -0,0 +1,203 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "cold/coro/IoService.h"
+#include "cold/net/Acceptor.h"
+#include "cold/net/TcpServer.h"
+#include "cold/net/UnixSocket.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+
+TEST_CASE("test unix address") {
+  Net::UnixAddress unnamed;
+  CHECK(unnamed.IsUnnamed());
+  CHECK(unnamed.GetPath().empty());
+  Net::UnixAddress path("/tmp/cold.sock");
+  CHECK(!path.IsUnnamed());
+  CHECK(!path.IsAbstract());
+  CHECK(path.GetPath() == "/tmp/cold.sock");
+  Net::UnixAddress abstract("@cold");
+  CHECK(abstract.IsAbstract());
+  CHECK(abstract.GetPath() == "@cold");
+  CHECK(abstract.GetLength() == sizeof(sa_family_t) + 5);
+}
+
+Base::Task<> DoEcho(Net::Acceptor& acceptor) {
+  auto socket = co_await acceptor.Accept();
+  CHECK(socket.GetRemoteAddress().GetPort() == 0);
+  char buf[64];
+  while (true) {
+    auto n = co_await socket.Read(buf, sizeof buf);
+    if (n <= 0) break;
+    CHECK(co_await socket.WriteN(buf, static_cast<size_t>(n)) == n);
+  }
+}
+
+Base::Task<> DoClient(Base::IoService& service, Net::UnixAddress addr) {
+  Net::UnixStreamSocket socket(service);
+  auto ret = co_await socket.Connect(addr);
+  REQUIRE(ret == 0);
+  CHECK(co_await socket.WriteN("hello", 5) == 5);
+  char buf[5];
+  CHECK(co_await socket.ReadN(buf, 5) == 5);
+  CHECK(std::string_view(buf, 5) == "hello");
+  auto cred = socket.GetPeerCredentials();
+  REQUIRE(cred);
+  CHECK(cred->pid == getpid());
+  socket.ShutDown();
+  service.Stop();
+}
+
+TEST_CASE("test unix stream socket") {
+  for (auto path : {"@cold-unix-test", "/tmp/cold-unix-test.sock"}) {
+    Net::UnixAddress addr(path);
+    {
+      Base::IoService service;
+      Net::Acceptor acceptor(service, addr);
+      acceptor.Listen();
+      service.CoSpawn(DoEcho(acceptor));
+      service.CoSpawn(DoClient(service, addr));
+      service.Start();
+    }
+    // the file is removed with the acceptor
+    struct stat st;
+    CHECK(stat("/tmp/cold-unix-test.sock", &st) < 0);
+  }
+}
+
+TEST_CASE("test stale unix socket file") {
+  Net::UnixAddress addr("/tmp/cold-unix-stale.sock");
+  unlink("/tmp/cold-unix-stale.sock");
+  // bound and closed without unlink, like a crashed server
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  REQUIRE(fd >= 0);
+  REQUIRE(bind(fd, addr.GetSockaddr(), addr.GetLength()) == 0);
+  close(fd);
+  Base::IoService service;
+  Net::Acceptor acceptor(service, addr);
+  acceptor.Listen();
+  // the file of the new acceptor accepts connections
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  REQUIRE(fd >= 0);
+  CHECK(connect(fd, addr.GetSockaddr(), addr.GetLength()) == 0);
+  close(fd);
+}
+
+Base::Task<> DoPassFd(Base::IoService& service, Net::UnixStreamSocket& a,
+                      Net::UnixStreamSocket& b) {
+  int pipeFds[2];
+  REQUIRE(pipe(pipeFds) == 0);
+  std::vector<int> passed{pipeFds[0], pipeFds[1]};
+  CHECK(co_await a.SendFds("x", 1, passed) == 1);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+  std::vector<int> fds;
+  char c;
+  CHECK(co_await b.RecvFds(&c, 1, fds) == 1);
+  CHECK(c == 'x');
+  REQUIRE(fds.size() == 2);
+  CHECK((fcntl(fds[0], F_GETFD) & FD_CLOEXEC));
+  // the passed fds are the pipe
+  CHECK(write(fds[1], "pipe", 4) == 4);
+  char buf[4];
+  CHECK(read(fds[0], buf, sizeof buf) == 4);
+  CHECK(std::string_view(buf, 4) == "pipe");
+  close(fds[0]);
+  close(fds[1]);
+  service.Stop();
+}
+
+TEST_CASE("test pass fds") {
+  Base::IoService service;
+  auto pair = Net::UnixStreamSocket::Pair(service);
+  REQUIRE(pair);
+  service.CoSpawn(DoPassFd(service, pair->first, pair->second));
+  service.Start();
+}
+
+Base::Task<> DoDatagram(Base::IoService& service, Net::UnixDatagramSocket& a,
+                        Net::UnixDatagramSocket& b,
+                        const Net::UnixAddress& addrB) {
+  CHECK(co_await a.SendTo("ping", 4, addrB) == 4);
+  char buf[16];
+  Net::UnixAddress source;
+  auto n = co_await b.RecvFrom(buf, sizeof buf, source);
+  CHECK(n == 4);
+  CHECK(source.GetPath() == "@cold-dgram-a");
+  CHECK(co_await b.SendTo("pong", 4, source) == 4);
+  n = co_await a.RecvFrom(buf, sizeof buf, source);
+  CHECK(std::string_view(buf, static_cast<size_t>(n)) == "pong");
+
+  int pipeFds[2];
+  REQUIRE(pipe(pipeFds) == 0);
+  std::vector<int> passed{pipeFds[1]};
+  CHECK(co_await a.SendFds("fd", 2, passed, &addrB) == 2);
+  close(pipeFds[1]);
+  std::vector<int> fds;
+  CHECK(co_await b.RecvFds(buf, sizeof buf, fds) == 2);
+  REQUIRE(fds.size() == 1);
+  CHECK(write(fds[0], "p", 1) == 1);
+  CHECK(read(pipeFds[0], buf, 1) == 1);
+  close(fds[0]);
+  close(pipeFds[0]);
+  service.Stop();
+}
+
+TEST_CASE("test unix datagram socket") {
+  Base::IoService service;
+  Net::UnixDatagramSocket a(service);
+  Net::UnixDatagramSocket b(service);
+  Net::UnixAddress addrB("@cold-dgram-b");
+  REQUIRE(a.Bind(Net::UnixAddress("@cold-dgram-a")));
+  REQUIRE(b.Bind(addrB));
+  service.CoSpawn(DoDatagram(service, a, b, addrB));
+  service.Start();
+}
+
+class EchoServer : public Net::TcpServer {
+ public:
+  explicit EchoServer(const Net::UnixAddress& addr) : Net::TcpServer(addr) {}
+
+  void Stop() { pool_.Stop(); }
+
+ protected:
+  Base::Task<> OnConnect(Net::TcpSocket socket) override {
+    char buf[64];
+    while (true) {
+      auto n = co_await socket.Read(buf, sizeof buf);
+      if (n <= 0) break;
+      co_await socket.WriteN(buf, static_cast<size_t>(n));
+    }
+  }
+};
+
+TEST_CASE("test tcp server on unix socket") {
+  Net::UnixAddress addr("@cold-unix-server");
+  EchoServer server(addr);
+  std::thread thread([&]() { server.Start(); });
+  // the server listens in its own thread
+  int fd = -1;
+  for (int i = 0; i < 100 && fd < 0; ++i) {
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    REQUIRE(fd >= 0);
+    if (connect(fd, addr.GetSockaddr(), addr.GetLength()) < 0) {
+      close(fd);
+      fd = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  REQUIRE(fd >= 0);
+  CHECK(write(fd, "hello", 5) == 5);
+  char buf[5];
+  CHECK(read(fd, buf, sizeof buf) == 5);
+  CHECK(std::string_view(buf, 5) == "hello");
+  close(fd);
+  server.Stop();
+  thread.join();
+}
@@ -0,0 +1,79 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <chrono>
+
+#include "cold/coro/IoService.h"
+#include "cold/time/LoopClock.h"
+#include "cold/time/MonoTime.h"
+#include "cold/time/Timer.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+using namespace std::chrono_literals;
+
+TEST_CASE("test operator") {
+  auto t = Base::MonoTime::Now();
+  auto n = t + 20ms;
+  CHECK(t < n);
+  CHECK(n - t == 20ms);
+  n -= 20ms;
+  CHECK(n == t);
+  CHECK((t + 1s).TimeSinceEpochMilliSeconds() ==
+        t.TimeSinceEpochMilliSeconds() + 1000);
+  CHECK(Base::MonoTime().Dump() == "0.000000000s");
+  CHECK((Base::MonoTime() + 1500ms).Dump() == "1.500000000s");
+}
+
+TEST_CASE("test coarse clock") {
+  auto coarse = Base::MonoTime::NowCoarse();
+  auto precise = Base::MonoTime::Now();
+  // the coarse clock lags behind by at most a few ticks
+  CHECK(coarse <= precise);
+  CHECK(precise - coarse < 100ms);
+  auto wall = Base::Time::NowCoarse();
+  CHECK(Base::Time::Now() - wall < 100ms);
+}
+
+TEST_CASE("test from wall time") {
+  auto mono = Base::MonoTime::FromTime(Base::Time::Now() + 10s);
+  auto diff = mono - Base::MonoTime::Now();
+  CHECK(diff > 9s);
+  CHECK(diff <= 10s);
+}
+
+Base::Task<> CheckLoopTime(Base::IoService& service, bool& cached) {
+  auto first = service.Now();
+  auto firstWall = Base::LoopClock::WallNow();
+  // busy for a while without going back to the loop
+  auto until = Base::MonoTime::Now() + 5ms;
+  while (Base::MonoTime::Now() < until) {
+  }
+  cached = service.Now() == first &&
+           Base::LoopClock::WallNow() == firstWall &&
+           Base::LoopClock::MonoNow() == first;
+  co_await Base::Sleep(service, 10ms);
+  // refreshed after polling
+  CHECK(service.Now() - first >= 10ms);
+  service.Stop();
+}
+
+TEST_CASE("test loop clock") {
+  Base::IoService service;
+  bool cached = false;
+  service.CoSpawn(CheckLoopTime(service, cached));
+  service.Start();
+  CHECK(cached);
+  // outside of the loop the clock is read directly
+  auto before = Base::MonoTime::Now();
+  CHECK(service.Now() >= before);
+  CHECK(Base::LoopClock::MonoNow() >= before);
+}
+
+TEST_CASE("test coarse loop clock") {
+  Base::IoServiceOptions options;
+  options.coarseClock = true;
+  Base::IoService service(options);
+  bool cached = false;
+  service.CoSpawn(CheckLoopTime(service, cached));
+  service.Start();
+  CHECK(cached);
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/time/Timer.h"
+#include "cold/time/TimerQueue.h"
+#include "third_party/fmt/include/fmt/format.h"
+
+using namespace Cold;
+
+// timeout heavy workload: every request arms a 15s timeout which is
+// canceled when the request finishes, like ReadWithTimeout does.
+// usage: TimerQueueBenchmark [requests] [concurrency]
+
+void Bench(Base::IoService& service, Base::TimerQueueType type,
+           size_t requests, size_t concurrency) {
+  auto queue = Base::TimerQueue::Create(type);
+  std::vector<std::unique_ptr<Base::Timer>> inflight(concurrency);
+  std::vector<Base::Task<>> expired;
+  size_t maxSize = 0;
+  auto start = Base::Time::Now();
+  for (size_t i = 0; i < requests; ++i) {
+    auto& timer = inflight[i % concurrency];
+    if (timer) queue->CancelTimer(*timer);
+    timer = std::make_unique<Base::Timer>(service);
+    timer->ExpiresAfter(std::chrono::seconds(15));
+    queue->AddTimer(*timer);
+    if (i % 1024 == 0) {
+      queue->HandleTimeout(Base::MonoTime::Now(), expired);
+      maxSize = std::max(maxSize, queue->Size());
+    }
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Base::Time::Now() - start)
+                .count();
+  std::cout << fmt::format(
+                   "{:<12} requests: {:>8}  concurrency: {:>6}  "
+                   "{:7.1f} ns/request  max stored timers: {}",
+                   type == Base::TimerQueueType::kHeap ? "heap"
+                                                       : "timing-wheel",
+                   requests, concurrency,
+                   static_cast<double>(ns) / static_cast<double>(requests),
+                   maxSize)
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  size_t requests = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  size_t concurrency = argc > 2 ? std::stoul(argv[2]) : 10000;
+  // the timers only use the queues of the benchmark
+  Base::IoService service;
+  for (auto type :
+       {Base::TimerQueueType::kHeap, Base::TimerQueueType::kTimingWheel}) {
+    Bench(service, type, requests, concurrency);
+  }
+}
@@ -0,0 +1,158 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "cold/coro/IoService.h"
+#include "cold/time/Timer.h"
+#include "cold/time/TimerQueue.h"
+#include "third_party/doctest.h"
+
+using namespace Cold;
+using namespace std::chrono_literals;
+
+Base::IoServiceOptions MakeOptions(Base::TimerQueueType type) {
+  Base::IoServiceOptions options;
+  options.timerQueue = type;
+  return options;
+}
+
+Base::Task<> SleepAndRecord(Base::IoService& service,
+                            std::chrono::milliseconds ms,
+                            std::vector<int>& order) {
+  co_await Base::Sleep(service, ms);
+  order.push_back(static_cast<int>(ms.count()));
+  if (order.size() == 4) service.Stop();
+}
+
+Base::Task<> SetFlag(bool& flag) {
+  flag = true;
+  co_return;
+}
+
+Base::Task<> StopAfter(Base::IoService& service,
+                       std::chrono::milliseconds ms) {
+  co_await Base::Sleep(service, ms);
+  service.Stop();
+}
+
+Base::Task<> SleepManyTimes(Base::IoService& service,
+                            std::chrono::microseconds us, int times) {
+  for (int i = 0; i < times; ++i) co_await Base::Sleep(service, us);
+  service.Stop();
+}
+
+Base::Task<> StopService(Base::IoService& service) {
+  service.Stop();
+  co_return;
+}
+
+TEST_CASE("test timer order") {
+  for (auto type :
+       {Base::TimerQueueType::kHeap, Base::TimerQueueType::kTimingWheel}) {
+    Base::IoService service(MakeOptions(type));
+    std::vector<int> order;
+    // 90ms and 300ms cascade from the upper levels of the timing wheel
+    for (auto ms : {300ms, 5ms, 90ms, 30ms}) {
+      service.CoSpawn(SleepAndRecord(service, ms, order));
+    }
+    service.Start();
+    CHECK(order == std::vector<int>{5, 30, 90, 300});
+  }
+}
+
+TEST_CASE("test cancel and update") {
+  for (auto type :
+       {Base::TimerQueueType::kHeap, Base::TimerQueueType::kTimingWheel}) {
+    Base::IoService service(MakeOptions(type));
+    bool canceled = false;
+    bool updated = false;
+    Base::Timer cancelTimer(service);
+    cancelTimer.ExpiresAfter(20ms);
+    cancelTimer.AsyncWait(SetFlag(canceled));
+    Base::Timer updateTimer(service);
+    updateTimer.ExpiresAfter(10s);
+    updateTimer.AsyncWait(SetFlag(updated));
+    updateTimer.ExpiresAfter(10ms);
+    cancelTimer.Cancel();
+    service.CoSpawn(StopAfter(service, 50ms));
+    service.Start();
+    CHECK(!canceled);
+    CHECK(updated);
+  }
+}
+
+TEST_CASE("test timing wheel removes canceled timers") {
+  Base::IoService service;
+  auto heap = Base::TimerQueue::Create(Base::TimerQueueType::kHeap);
+  auto wheel = Base::TimerQueue::Create(Base::TimerQueueType::kTimingWheel);
+  std::vector<std::unique_ptr<Base::Timer>> timers;
+  for (int i = 0; i < 100; ++i) {
+    timers.push_back(std::make_unique<Base::Timer>(service));
+    // far beyond the range of the wheel
+    timers.back()->ExpiresAfter(i % 2 ? 15s : 10h);
+    heap->AddTimer(*timers.back());
+    wheel->AddTimer(*timers.back());
+  }
+  std::vector<Base::Task<>> tasks;
+  CHECK(wheel->HandleTimeout(Base::MonoTime::Now(), tasks) > 0);
+  CHECK(tasks.empty());
+  for (auto& timer : timers) {
+    heap->CancelTimer(*timer);
+    wheel->CancelTimer(*timer);
+  }
+  CHECK(heap->Size() == 100);
+  CHECK(wheel->Size() == 0);
+}
+
+TEST_CASE("test timing wheel skips idle ticks") {
+  Base::IoService service;
+  auto wheel = Base::TimerQueue::Create(Base::TimerQueueType::kTimingWheel);
+  auto start = Base::MonoTime::Now();
+  bool fired = false;
+  Base::Timer timer(service);
+  // cascades through every level on the way
+  timer.ExpiresAt(start + 3h);
+  timer.AsyncWait(SetFlag(fired));
+  wheel->AddTimer(timer);
+  std::vector<Base::Task<>> tasks;
+  auto waitNs = wheel->HandleTimeout(start + 3h - 1ms, tasks);
+  CHECK(tasks.empty());
+  CHECK(waitNs > 0);
+  CHECK(waitNs <= 2000000);
+  wheel->HandleTimeout(start + 3h + 1ms, tasks);
+  CHECK(tasks.size() == 1);
+  CHECK(wheel->Size() == 0);
+  // fired already, so this finds nothing to cancel
+  wheel->CancelTimer(timer);
+  CHECK(wheel->Size() == 0);
+}
+
+TEST_CASE("test sub-millisecond timer") {
+  for (auto type :
+       {Base::TimerQueueType::kHeap, Base::TimerQueueType::kTimingWheel}) {
+    Base::IoService service(MakeOptions(type));
+    service.CoSpawn(SleepManyTimes(service, 200us, 20));
+    auto start = Base::MonoTime::Now();
+    service.Start();
+    auto elapsed = Base::MonoTime::Now() - start;
+    CHECK(elapsed >= 4ms);
+    // the timing wheel rounds up to its 1ms ticks
+    if (type == Base::TimerQueueType::kHeap) CHECK(elapsed < 15ms);
+  }
+}
+
+TEST_CASE("test timer added from another thread") {
+  // the loop has no timer and waits forever until the new one wakes it
+  Base::IoService service;
+  Base::Timer timer(service);
+  std::thread thread([&]() {
+    std::this_thread::sleep_for(50ms);
+    timer.ExpiresAfter(10ms);
+    timer.AsyncWait(StopService(service));
+  });
+  auto start = Base::MonoTime::Now();
+  service.Start();
+  thread.join();
+  CHECK(Base::MonoTime::Now() - start >= 60ms);
+}